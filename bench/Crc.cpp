@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "EmbMessenger/Crc.hpp"
+
+namespace emb
+{
+    namespace bench
+    {
+        namespace
+        {
+            // The same bytes on every run, so results can be compared between commits
+            std::vector<uint8_t> makeData(size_t size)
+            {
+                std::vector<uint8_t> data(size);
+                uint32_t state = 0x12345678;
+                for (uint8_t& byte : data)
+                {
+                    state = state * 1664525 + 1013904223;
+                    byte = static_cast<uint8_t>(state >> 24);
+                }
+                return data;
+            }
+
+            // One byte at a time, the cost every Writer::writeByte and Reader::readByte pays
+            template <typename T, T (*Calculate)(const T, const uint8_t)>
+            void BM_CrcByte(benchmark::State& state)
+            {
+                std::vector<uint8_t> data = makeData(256);
+
+                T crc = 0;
+                size_t index = 0;
+                for (auto _ : state)
+                {
+                    crc = Calculate(crc, data[index++ & 0xFF]);
+                    benchmark::DoNotOptimize(crc);
+                }
+
+                state.SetBytesProcessed(state.iterations());
+            }
+
+            // A whole frame, the argument is the frame size
+            template <typename T, T (*Calculate)(const T, const uint8_t)>
+            void BM_CrcFrame(benchmark::State& state)
+            {
+                size_t size = static_cast<size_t>(state.range(0));
+                std::vector<uint8_t> data = makeData(size);
+
+                for (auto _ : state)
+                {
+                    T crc = 0;
+                    for (uint8_t byte : data)
+                    {
+                        crc = Calculate(crc, byte);
+                    }
+                    benchmark::DoNotOptimize(crc);
+                }
+
+                state.SetBytesProcessed(state.iterations() * size);
+            }
+        }  // namespace
+
+        BENCHMARK_TEMPLATE(BM_CrcByte, uint8_t, shared::crc::Calculate8);
+        BENCHMARK_TEMPLATE(BM_CrcByte, uint16_t, shared::crc::Calculate16);
+        BENCHMARK_TEMPLATE(BM_CrcByte, uint32_t, shared::crc::Calculate32);
+        BENCHMARK_TEMPLATE(BM_CrcFrame, uint8_t, shared::crc::Calculate8)->Arg(8)->Arg(64)->Arg(256);
+        BENCHMARK_TEMPLATE(BM_CrcFrame, uint16_t, shared::crc::Calculate16)->Arg(8)->Arg(64)->Arg(256);
+        BENCHMARK_TEMPLATE(BM_CrcFrame, uint32_t, shared::crc::Calculate32)->Arg(8)->Arg(64)->Arg(256);
+    }  // namespace bench
+}  // namespace emb
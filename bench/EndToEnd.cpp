@@ -0,0 +1,248 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifndef EMB_SINGLE_THREADED
+#include <thread>
+#endif
+
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "LoopbackLink.hpp"
+#include "SimulatedDevice.hpp"
+
+namespace emb
+{
+    namespace bench
+    {
+        namespace
+        {
+            using clock_t = std::chrono::steady_clock;
+
+            class Add : public host::Command
+            {
+                int16_t m_a;
+                int16_t m_b;
+
+            public:
+                int16_t sum = 0;
+                clock_t::time_point sent;
+                clock_t::time_point received;
+
+                Add(int16_t a, int16_t b) : m_a(a), m_b(b)
+                {
+                }
+
+                void send(host::EmbMessenger* messenger) override
+                {
+                    messenger->write(m_a, m_b);
+                }
+
+                void receive(host::EmbMessenger* messenger) override
+                {
+                    messenger->read(sum);
+                    received = clock_t::now();
+                }
+            };
+
+            class Tick : public host::Command
+            {
+            public:
+                int64_t latency = 0;
+
+                void receive(host::EmbMessenger* messenger) override
+                {
+                    uint64_t device_time = 0;
+                    messenger->read(device_time);
+                    latency = clock_t::now().time_since_epoch().count() - static_cast<int64_t>(device_time);
+                }
+            };
+
+            /**
+             * The host and the device connected through a LoopbackLink. In the Single Threaded EmbMessenger the device
+             * runs in the host's update, otherwise it runs in its own thread.
+             */
+            class Harness
+            {
+                LoopbackLink m_link;
+                SimulatedDevice m_device;
+#ifndef EMB_SINGLE_THREADED
+                std::atomic_bool m_running;
+                std::thread m_device_thread;
+#endif
+                std::unique_ptr<host::EmbMessenger> m_host;
+
+            public:
+                Harness() : m_device(m_link.device().get())
+                {
+#ifdef EMB_SINGLE_THREADED
+                    m_link.host()->setPump([this] { m_device.update(); });
+                    m_host.reset(new host::EmbMessenger(m_link.host()));
+#else
+                    m_running = true;
+                    m_device_thread = std::thread([this] {
+                        while (m_running)
+                        {
+                            m_device.update();
+                            std::this_thread::yield();
+                        }
+                    });
+                    m_host.reset(new host::EmbMessenger(m_link.host(), [](std::exception_ptr) { return false; }));
+#endif
+                    m_host->registerCommand<Add>(SimulatedDevice::kAdd);
+                    m_host->registerCommand<Tick>(SimulatedDevice::kTick);
+                }
+
+                ~Harness()
+                {
+                    m_host.reset();
+#ifndef EMB_SINGLE_THREADED
+                    m_running = false;
+                    m_device_thread.join();
+#endif
+                }
+
+                host::EmbMessenger& host()
+                {
+                    return *m_host;
+                }
+
+                // Lets the messages move, the threads do that on their own in the Multi Threaded EmbMessenger
+                void poll()
+                {
+#ifdef EMB_SINGLE_THREADED
+                    m_host->updateAll();
+#else
+                    std::this_thread::yield();
+#endif
+                }
+
+                void wait(host::Command& command)
+                {
+#ifdef EMB_SINGLE_THREADED
+                    while (command.getCommandState() != host::CommandState::Received)
+                    {
+                        m_host->updateAll();
+                    }
+#else
+                    command.wait();
+#endif
+                }
+            };
+
+            std::shared_ptr<Add> sendAdd(Harness& harness)
+            {
+                std::shared_ptr<Add> add = harness.host().makeCommand<Add>(int16_t(2), int16_t(3));
+                add->sent = clock_t::now();
+                harness.host().send(add);
+                return add;
+            }
+
+            void reportLatency(benchmark::State& state, std::vector<int64_t>& samples)
+            {
+                if (samples.empty())
+                {
+                    return;
+                }
+
+                std::sort(samples.begin(), samples.end());
+                auto percentile = [&](double p) {
+                    return static_cast<double>(samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))]);
+                };
+                state.counters["p50_ns"] = percentile(0.5);
+                state.counters["p99_ns"] = percentile(0.99);
+                state.counters["p999_ns"] = percentile(0.999);
+                state.counters["max_ns"] = static_cast<double>(samples.back());
+            }
+
+            // One command at a time, each waits for the response to the one before
+            void BM_SingleShot(benchmark::State& state)
+            {
+                Harness harness;
+                std::vector<int64_t> samples;
+                samples.reserve(state.max_iterations);
+
+                for (auto _ : state)
+                {
+                    std::shared_ptr<Add> add = sendAdd(harness);
+                    harness.wait(*add);
+                    samples.push_back(std::chrono::nanoseconds(add->received - add->sent).count());
+                }
+
+                state.SetItemsProcessed(state.iterations());
+                reportLatency(state, samples);
+            }
+
+            // Keeps as many commands in flight as the argument
+            void BM_Pipelined(benchmark::State& state)
+            {
+                Harness harness;
+                std::vector<int64_t> samples;
+                samples.reserve(state.max_iterations);
+
+                std::vector<std::shared_ptr<Add>> in_flight(static_cast<size_t>(state.range(0)));
+                for (std::shared_ptr<Add>& add : in_flight)
+                {
+                    add = sendAdd(harness);
+                }
+
+                size_t next = 0;
+                for (auto _ : state)
+                {
+                    std::shared_ptr<Add>& add = in_flight[next];
+                    harness.wait(*add);
+                    samples.push_back(std::chrono::nanoseconds(add->received - add->sent).count());
+
+                    add = sendAdd(harness);
+                    next = (next + 1) % in_flight.size();
+                }
+
+                for (std::shared_ptr<Add>& add : in_flight)
+                {
+                    harness.wait(*add);
+                }
+
+                state.SetItemsProcessed(state.iterations());
+                reportLatency(state, samples);
+            }
+
+            // A periodic command the device runs on every update, the latency is from the device to the callback
+            void BM_Periodic(benchmark::State& state)
+            {
+                Harness harness;
+                std::vector<int64_t> samples;
+                samples.reserve(state.max_iterations + 1024);
+                std::atomic<uint64_t> received(0);
+
+                harness.host().registerPeriodicCommand<Tick>(0, [&](std::shared_ptr<Tick> tick) {
+                    samples.push_back(tick->latency);
+                    received.fetch_add(1, std::memory_order_release);
+                });
+
+                uint64_t expected = 0;
+                for (auto _ : state)
+                {
+                    ++expected;
+                    while (received.load(std::memory_order_acquire) < expected)
+                    {
+                        harness.poll();
+                    }
+                }
+
+                // Waits for the callbacks to stop in the Multi Threaded EmbMessenger
+                harness.host().unregisterPeriodicCommand<Tick>();
+
+                state.SetItemsProcessed(state.iterations());
+                reportLatency(state, samples);
+            }
+        }  // namespace
+
+        BENCHMARK(BM_SingleShot)->UseRealTime();
+        BENCHMARK(BM_Pipelined)->Arg(1)->Arg(8)->Arg(64)->UseRealTime();
+        BENCHMARK(BM_Periodic)->UseRealTime();
+    }  // namespace bench
+}  // namespace emb
@@ -0,0 +1,182 @@
+#ifndef EMBMESSENGER_BENCH_LOOPBACKLINK_HPP
+#define EMBMESSENGER_BENCH_LOOPBACKLINK_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#endif
+
+namespace emb
+{
+    namespace bench
+    {
+        /**
+         * @brief In memory link between the host and the device, in place of a serial port.
+         *
+         * Each end is an IBuffer. Messages are handed to the other end whole, once their last byte is written, and
+         * arrive when the other end updates.
+         */
+        class LoopbackLink
+        {
+            // Messages going one way
+            struct Channel
+            {
+                std::vector<uint8_t> bytes;
+#ifndef EMB_SINGLE_THREADED
+                std::mutex mutex;
+#endif
+            };
+
+        public:
+            class End : public shared::IBuffer
+            {
+                std::shared_ptr<Channel> m_incoming;
+                std::shared_ptr<Channel> m_outgoing;
+                std::function<void()> m_pump;
+
+                std::vector<uint8_t> m_writing;
+                host::FrameSplitter m_write_splitter;
+
+                std::vector<uint8_t> m_received;
+                std::vector<uint8_t> m_arrived;
+                size_t m_read_index = 0;
+                size_t m_messages = 0;
+                host::FrameSplitter m_arrive_splitter;
+                host::FrameSplitter m_read_splitter;
+
+            public:
+                End(std::shared_ptr<Channel> incoming, std::shared_ptr<Channel> outgoing) :
+                    m_incoming(incoming), m_outgoing(outgoing)
+                {
+                }
+
+                /**
+                 * @brief Sets a function to call at the start of each update.
+                 *
+                 * Runs the device from the host's update when they share a thread.
+                 *
+                 * @param pump The function
+                 */
+                void setPump(std::function<void()> pump)
+                {
+                    m_pump = pump;
+                }
+
+                virtual void writeByte(const uint8_t byte) override
+                {
+                    m_writing.push_back(byte);
+                    if (m_write_splitter.push(byte))
+                    {
+#ifndef EMB_SINGLE_THREADED
+                        std::lock_guard<std::mutex> lock(m_outgoing->mutex);
+#endif
+                        m_outgoing->bytes.insert(m_outgoing->bytes.end(), m_writing.begin(), m_writing.end());
+                        m_writing.clear();
+                    }
+                }
+
+                virtual uint8_t peek() const override
+                {
+                    return m_received[m_read_index];
+                }
+
+                virtual uint8_t readByte() override
+                {
+                    uint8_t byte = m_received[m_read_index++];
+                    if (m_read_splitter.push(byte))
+                    {
+                        --m_messages;
+                    }
+                    return byte;
+                }
+
+                virtual bool empty() const override
+                {
+                    return m_read_index == m_received.size();
+                }
+
+                virtual size_t size() const override
+                {
+                    return m_received.size() - m_read_index;
+                }
+
+                virtual uint8_t messages() const override
+                {
+                    return static_cast<uint8_t>(std::min<size_t>(m_messages, 0xFF));
+                }
+
+                virtual void update() override
+                {
+                    if (m_pump)
+                    {
+                        m_pump();
+                    }
+
+                    {
+#ifndef EMB_SINGLE_THREADED
+                        std::lock_guard<std::mutex> lock(m_incoming->mutex);
+#endif
+                        m_arrived.swap(m_incoming->bytes);
+                    }
+
+                    // Drop what was read, the vectors keep their capacity so the link doesn't allocate once warm
+                    m_received.erase(m_received.begin(), m_received.begin() + m_read_index);
+                    m_read_index = 0;
+
+                    for (uint8_t byte : m_arrived)
+                    {
+                        if (m_arrive_splitter.push(byte))
+                        {
+                            ++m_messages;
+                        }
+                    }
+                    m_received.insert(m_received.end(), m_arrived.begin(), m_arrived.end());
+                    m_arrived.clear();
+                }
+
+                virtual void zero() override
+                {
+                    m_received.clear();
+                    m_read_index = 0;
+                    m_messages = 0;
+                    m_arrive_splitter.reset();
+                    m_read_splitter.reset();
+                }
+            };
+
+        private:
+            std::shared_ptr<End> m_host;
+            std::shared_ptr<End> m_device;
+
+        public:
+            LoopbackLink()
+            {
+                std::shared_ptr<Channel> to_device = std::make_shared<Channel>();
+                std::shared_ptr<Channel> to_host = std::make_shared<Channel>();
+                m_host = std::make_shared<End>(to_host, to_device);
+                m_device = std::make_shared<End>(to_device, to_host);
+            }
+
+            std::shared_ptr<End> host() const
+            {
+                return m_host;
+            }
+
+            std::shared_ptr<End> device() const
+            {
+                return m_device;
+            }
+        };
+    }  // namespace bench
+}  // namespace emb
+
+#endif  // EMBMESSENGER_BENCH_LOOPBACKLINK_HPP
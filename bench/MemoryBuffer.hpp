@@ -0,0 +1,83 @@
+#ifndef EMBMESSENGER_BENCH_MEMORYBUFFER_HPP
+#define EMBMESSENGER_BENCH_MEMORYBUFFER_HPP
+
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace emb
+{
+    namespace bench
+    {
+        /**
+         * @brief In memory buffer, so the benchmarks measure the encoding and not the I/O.
+         *
+         * A fixed ring of bytes without bounds checks or allocations, the benchmarks never have more than
+         * `kCapacity` bytes in it.
+         */
+        class MemoryBuffer : public shared::IBuffer
+        {
+        public:
+            static constexpr size_t kCapacity = 4096;
+
+        private:
+            static constexpr size_t kMask = kCapacity - 1;
+
+            uint8_t m_data[kCapacity];
+            size_t m_write_index = 0;
+            size_t m_read_index = 0;
+
+        public:
+            /**
+             * @brief Reads the written bytes again from the start.
+             */
+            void rewind()
+            {
+                m_read_index = 0;
+            }
+
+            virtual void writeByte(const uint8_t byte) override
+            {
+                m_data[m_write_index++ & kMask] = byte;
+            }
+
+            virtual uint8_t peek() const override
+            {
+                return m_data[m_read_index & kMask];
+            }
+
+            virtual uint8_t readByte() override
+            {
+                return m_data[m_read_index++ & kMask];
+            }
+
+            virtual bool empty() const override
+            {
+                return m_write_index == m_read_index;
+            }
+
+            virtual size_t size() const override
+            {
+                return m_write_index - m_read_index;
+            }
+
+            virtual uint8_t messages() const override
+            {
+                return 0;
+            }
+
+            virtual void update() override
+            {
+            }
+
+            virtual void zero() override
+            {
+                m_write_index = 0;
+                m_read_index = 0;
+            }
+        };
+    }  // namespace bench
+}  // namespace emb
+
+#endif  // EMBMESSENGER_BENCH_MEMORYBUFFER_HPP
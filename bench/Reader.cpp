@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include <limits>
+
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/Reader.hpp"
+#include "EmbMessenger/Writer.hpp"
+#include "MemoryBuffer.hpp"
+
+namespace emb
+{
+    namespace bench
+    {
+        namespace
+        {
+            // Values read per iteration, so rewinding the buffer is spread over many values
+            constexpr int kValues = 64;
+
+            // Reads back kValues copies of the encoded value into a T
+            template <typename T, typename V>
+            void readValues(benchmark::State& state, const V value)
+            {
+                MemoryBuffer buffer;
+                shared::Writer writer(&buffer);
+                for (int i = 0; i < kValues; ++i)
+                {
+                    writer.write(value);
+                }
+                size_t bytes = buffer.size();
+
+                shared::Reader reader(&buffer);
+                T read{};
+                for (auto _ : state)
+                {
+                    buffer.rewind();
+                    for (int i = 0; i < kValues; ++i)
+                    {
+                        if (!reader.read(read))
+                        {
+                            state.SkipWithError("Reading the value failed");
+                            return;
+                        }
+                        benchmark::DoNotOptimize(read);
+                    }
+                }
+
+                state.SetItemsProcessed(state.iterations() * kValues);
+                state.SetBytesProcessed(state.iterations() * bytes);
+            }
+
+            // Each type at its widest, so every byte of it is decoded
+            template <typename T>
+            void BM_ReadMax(benchmark::State& state)
+            {
+                readValues<T>(state, std::numeric_limits<T>::max());
+            }
+
+            template <typename T>
+            void BM_ReadMin(benchmark::State& state)
+            {
+                readValues<T>(state, std::numeric_limits<T>::min());
+            }
+
+            // A uint64_t encoded in fewer bytes, the argument is the value
+            void BM_ReadUint64Width(benchmark::State& state)
+            {
+                readValues<uint64_t>(state, static_cast<uint64_t>(state.range(0)));
+            }
+
+            void BM_ReadBool(benchmark::State& state)
+            {
+                readValues<bool>(state, true);
+            }
+
+            void BM_ReadFloat(benchmark::State& state)
+            {
+                readValues<float>(state, 3.14159f);
+            }
+
+            // Each of the encodings in turn, so the branches of getType aren't all predicted the same way
+            void BM_GetType(benchmark::State& state)
+            {
+                MemoryBuffer buffer;
+                shared::Writer writer(&buffer);
+                for (int i = 0; i < kValues / 8; ++i)
+                {
+                    writer.write(static_cast<uint8_t>(5));
+                    writer.write(static_cast<uint8_t>(200));
+                    writer.write(static_cast<uint32_t>(70000));
+                    writer.write(static_cast<int8_t>(-5));
+                    writer.write(static_cast<int16_t>(-300));
+                    writer.write(1.5f);
+                    writer.write(false);
+                    writer.writeNull();
+                }
+
+                shared::Reader reader(&buffer);
+                shared::DataType type;
+                for (auto _ : state)
+                {
+                    buffer.rewind();
+                    for (int i = 0; i < kValues; ++i)
+                    {
+                        reader.getType(type);
+                        benchmark::DoNotOptimize(type);
+                        buffer.readByte();
+                        for (uint8_t data = shared::dataBytes(type); data > 0; --data)
+                        {
+                            buffer.readByte();
+                        }
+                    }
+                }
+
+                state.SetItemsProcessed(state.iterations() * kValues);
+            }
+        }  // namespace
+
+        BENCHMARK_TEMPLATE(BM_ReadMax, uint8_t);
+        BENCHMARK_TEMPLATE(BM_ReadMax, uint16_t);
+        BENCHMARK_TEMPLATE(BM_ReadMax, uint32_t);
+        BENCHMARK_TEMPLATE(BM_ReadMax, uint64_t);
+        BENCHMARK_TEMPLATE(BM_ReadMin, int8_t);
+        BENCHMARK_TEMPLATE(BM_ReadMin, int16_t);
+        BENCHMARK_TEMPLATE(BM_ReadMin, int32_t);
+        BENCHMARK_TEMPLATE(BM_ReadMin, int64_t);
+        BENCHMARK(BM_ReadUint64Width)->Arg(0x7F)->Arg(0xFF)->Arg(0xFFFF)->Arg(0xFFFFFFFF);
+        BENCHMARK(BM_ReadBool);
+        BENCHMARK(BM_ReadFloat);
+        BENCHMARK(BM_GetType);
+    }  // namespace bench
+}  // namespace emb
@@ -0,0 +1,53 @@
+#ifndef EMBMESSENGER_BENCH_SIMULATEDDEVICE_HPP
+#define EMBMESSENGER_BENCH_SIMULATEDDEVICE_HPP
+
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace emb
+{
+    namespace bench
+    {
+        /**
+         * @brief The device's EmbMessenger running in the benchmark process.
+         *
+         * The host and the device both have an `EmbMessenger/EmbMessenger.hpp`, so the device is compiled separately
+         * and only this header is shared.
+         *
+         * Its commands are:
+         * - `0` Ping, responds without values
+         * - `1` Add, reads two `int16_t` and responds with their sum
+         * - `2` Tick, responds with the time it ran as `steady_clock` nanoseconds, for measuring periodic commands
+         */
+        class SimulatedDevice
+        {
+            struct Impl;
+            std::unique_ptr<Impl> m_impl;
+
+        public:
+            static constexpr uint16_t kPing = 0;
+            static constexpr uint16_t kAdd = 1;
+            static constexpr uint16_t kTick = 2;
+
+            /**
+             * @brief Construct a new Simulated Device.
+             *
+             * @param buffer The device's end of the link, it has to outlive the device
+             */
+            explicit SimulatedDevice(shared::IBuffer* buffer);
+            ~SimulatedDevice();
+
+            SimulatedDevice(const SimulatedDevice&) = delete;
+            SimulatedDevice& operator=(const SimulatedDevice&) = delete;
+
+            /**
+             * @brief Runs the device's update once, it handles at most one message.
+             */
+            void update();
+        };
+    }  // namespace bench
+}  // namespace emb
+
+#endif  // EMBMESSENGER_BENCH_SIMULATEDDEVICE_HPP
@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+
+#include <limits>
+
+#include "EmbMessenger/DataError.hpp"
+#include "EmbMessenger/Writer.hpp"
+#include "MemoryBuffer.hpp"
+
+namespace emb
+{
+    namespace bench
+    {
+        namespace
+        {
+            // Values written per iteration, so the buffer reset is spread over many values
+            constexpr int kValues = 64;
+
+            template <typename T>
+            void writeValues(benchmark::State& state, const T value)
+            {
+                MemoryBuffer buffer;
+                shared::Writer writer(&buffer);
+
+                for (auto _ : state)
+                {
+                    buffer.zero();
+                    for (int i = 0; i < kValues; ++i)
+                    {
+                        writer.write(value);
+                    }
+                    benchmark::ClobberMemory();
+                }
+
+                state.SetItemsProcessed(state.iterations() * kValues);
+                state.SetBytesProcessed(state.iterations() * buffer.size());
+            }
+
+            // Each type at its widest, so every byte of it is encoded
+            template <typename T>
+            void BM_WriteMax(benchmark::State& state)
+            {
+                writeValues<T>(state, std::numeric_limits<T>::max());
+            }
+
+            template <typename T>
+            void BM_WriteMin(benchmark::State& state)
+            {
+                writeValues<T>(state, std::numeric_limits<T>::min());
+            }
+
+            // A uint64_t whose value fits in fewer bytes, the argument is the value
+            void BM_WriteUint64Width(benchmark::State& state)
+            {
+                writeValues<uint64_t>(state, static_cast<uint64_t>(state.range(0)));
+            }
+
+            void BM_WriteBool(benchmark::State& state)
+            {
+                writeValues<bool>(state, true);
+            }
+
+            void BM_WriteFloat(benchmark::State& state)
+            {
+                writeValues<float>(state, 3.14159f);
+            }
+
+            void BM_WriteNull(benchmark::State& state)
+            {
+                MemoryBuffer buffer;
+                shared::Writer writer(&buffer);
+
+                for (auto _ : state)
+                {
+                    buffer.zero();
+                    for (int i = 0; i < kValues; ++i)
+                    {
+                        writer.writeNull();
+                    }
+                    benchmark::ClobberMemory();
+                }
+
+                state.SetItemsProcessed(state.iterations() * kValues);
+            }
+
+            void BM_WriteError(benchmark::State& state)
+            {
+                MemoryBuffer buffer;
+                shared::Writer writer(&buffer);
+
+                for (auto _ : state)
+                {
+                    buffer.zero();
+                    for (int i = 0; i < kValues; ++i)
+                    {
+                        writer.writeError(shared::DataError::kParameterInvalid);
+                    }
+                    benchmark::ClobberMemory();
+                }
+
+                state.SetItemsProcessed(state.iterations() * kValues);
+            }
+
+            // A message id, a command id, three parameters and the CRC, like a typical command
+            void BM_WriteMessage(benchmark::State& state)
+            {
+                MemoryBuffer buffer;
+                shared::Writer writer(&buffer);
+
+                for (auto _ : state)
+                {
+                    buffer.zero();
+                    for (int i = 0; i < kValues; ++i)
+                    {
+                        writer.write(static_cast<uint16_t>(1000 + i));
+                        writer.write(static_cast<uint16_t>(5));
+                        writer.write(static_cast<int16_t>(-300));
+                        writer.write(2.5f);
+                        writer.write(true);
+                        writer.writeCrc();
+                    }
+                    benchmark::ClobberMemory();
+                }
+
+                state.SetItemsProcessed(state.iterations() * kValues);
+                state.SetBytesProcessed(state.iterations() * buffer.size());
+            }
+        }  // namespace
+
+        BENCHMARK_TEMPLATE(BM_WriteMax, uint8_t);
+        BENCHMARK_TEMPLATE(BM_WriteMax, uint16_t);
+        BENCHMARK_TEMPLATE(BM_WriteMax, uint32_t);
+        BENCHMARK_TEMPLATE(BM_WriteMax, uint64_t);
+        BENCHMARK_TEMPLATE(BM_WriteMin, int8_t);
+        BENCHMARK_TEMPLATE(BM_WriteMin, int16_t);
+        BENCHMARK_TEMPLATE(BM_WriteMin, int32_t);
+        BENCHMARK_TEMPLATE(BM_WriteMin, int64_t);
+        BENCHMARK(BM_WriteUint64Width)->Arg(0x7F)->Arg(0xFF)->Arg(0xFFFF)->Arg(0xFFFFFFFF);
+        BENCHMARK(BM_WriteBool);
+        BENCHMARK(BM_WriteFloat);
+        BENCHMARK(BM_WriteNull);
+        BENCHMARK(BM_WriteError);
+        BENCHMARK(BM_WriteMessage);
+    }  // namespace bench
+}  // namespace emb
@@ -0,0 +1,56 @@
+#include "SimulatedDevice.hpp"
+
+#include "EmbMessenger/EmbMessenger.hpp"
+
+#include <chrono>
+
+namespace emb
+{
+    namespace bench
+    {
+        constexpr uint16_t SimulatedDevice::kPing;
+        constexpr uint16_t SimulatedDevice::kAdd;
+        constexpr uint16_t SimulatedDevice::kTick;
+
+        struct SimulatedDevice::Impl
+        {
+            using Messenger = device::EmbMessenger<4>;
+
+            std::chrono::steady_clock::time_point start;
+            Messenger::CommandFunction commands[3];
+            Messenger messenger;
+
+            explicit Impl(shared::IBuffer* buffer) :
+                start(std::chrono::steady_clock::now()),
+                commands{ [] {},
+                          [this] {
+                              int16_t a = 0;
+                              int16_t b = 0;
+                              messenger.read(a, b);
+                              messenger.write(static_cast<int16_t>(a + b));
+                          },
+                          [this] {
+                              messenger.write(static_cast<uint64_t>(
+                                  std::chrono::steady_clock::now().time_since_epoch().count()));
+                          } },
+                messenger(buffer, commands, 3, [this] {
+                    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                     std::chrono::steady_clock::now() - start)
+                                                     .count());
+                })
+            {
+            }
+        };
+
+        SimulatedDevice::SimulatedDevice(shared::IBuffer* buffer) : m_impl(new Impl(buffer))
+        {
+        }
+
+        SimulatedDevice::~SimulatedDevice() = default;
+
+        void SimulatedDevice::update()
+        {
+            m_impl->messenger.update();
+        }
+    }  // namespace bench
+}  // namespace emb
@@ -4,7 +4,9 @@
 #include <setjmp.h>
 #include <stdint.h>
 
+#include "EmbMessenger/BusAddress.hpp"
 #include "EmbMessenger/DataError.hpp"
+#include "EmbMessenger/IBuffer.hpp"
 #include "EmbMessenger/Reader.hpp"
 #include "EmbMessenger/Writer.hpp"
 #include "Templates.hpp"
@@ -32,8 +34,10 @@ namespace emb
          * EmbMessenger has reserved 16 command IDs for internal usage
          * 
          * @tparam MaxPeriodicCommands The maximum number of periodic commands to store, must be less than `65520`
+         * @tparam RecentMessages The number of message IDs to remember for rejecting retransmitted messages that were
+         *     already executed, `0` to execute every message
          */
-        template <uint8_t MaxPeriodicCommands = 0>
+        template <uint8_t MaxPeriodicCommands = 0, uint8_t RecentMessages = 0>
         class EmbMessenger
         {
         public:
@@ -46,6 +50,48 @@ namespace emb
 #endif
 
         protected:
+            // Takes the responses to broadcasts, nobody is listening for them
+            class DiscardBuffer : public shared::IBuffer
+            {
+            public:
+                virtual void writeByte(const uint8_t) override
+                {
+                }
+
+                virtual uint8_t peek() const override
+                {
+                    return 0;
+                }
+
+                virtual uint8_t readByte() override
+                {
+                    return 0;
+                }
+
+                virtual bool empty() const override
+                {
+                    return true;
+                }
+
+                virtual size_t size() const override
+                {
+                    return 0;
+                }
+
+                virtual uint8_t messages() const override
+                {
+                    return 0;
+                }
+
+                virtual void update() override
+                {
+                }
+
+                virtual void zero() override
+                {
+                }
+            };
+
             struct PeriodicCommand
             {
                 uint16_t command_id = 65535;
@@ -65,6 +111,16 @@ namespace emb
             uint8_t m_num_messages;
 
             uint16_t m_parameter_index;
+            bool m_message_failed;
+
+            bool m_addressed = false;
+            uint8_t m_address = 0;
+            bool m_broadcast = false;
+            DiscardBuffer m_discard_buffer;
+
+            uint16_t m_recent_messages[RecentMessages > 0 ? RecentMessages : 1];
+            uint8_t m_recent_index = 0;
+            uint8_t m_recent_count = 0;
 
             TimeFunction m_time_func;
 
@@ -118,9 +174,58 @@ namespace emb
                     ;
             }
 
+            bool readAddress()
+            {
+                m_reader.resetCrc();
+
+                uint8_t address = 0;
+                if (!m_reader.read(address) || (address != m_address && address != shared::kBroadcastAddress))
+                {
+                    return false;
+                }
+
+                m_broadcast = address == shared::kBroadcastAddress;
+                m_writer = shared::Writer(m_broadcast ? &m_discard_buffer : m_buffer);
+                if (!m_broadcast)
+                {
+                    m_writer.write(m_address);
+                }
+                return true;
+            }
+
+            bool isDuplicateMessage(const uint16_t messageId) const
+            {
+                for (uint8_t i = 0; i < m_recent_count; ++i)
+                {
+                    if (m_recent_messages[i] == messageId)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void rememberMessage(const uint16_t messageId)
+            {
+                m_recent_messages[m_recent_index] = messageId;
+                if (++m_recent_index == RecentMessages)
+                {
+                    m_recent_index = 0;
+                }
+                if (m_recent_count < RecentMessages)
+                {
+                    ++m_recent_count;
+                }
+            }
+
             void resetPeriodicCommands()
             {
                 checkCrc();
+
+                // The host starts over with its message IDs after a reset
+                m_recent_index = 0;
+                m_recent_count = 0;
+
                 for (uint8_t i = 0; i < MaxPeriodicCommands; ++i)
                 {
                     m_periodic_commands[i].command_id = 65535;
@@ -186,6 +291,14 @@ namespace emb
                 reportError(shared::DataError::kParameterInvalid, 0);
             }
 
+            void sendBufferCapacity()
+            {
+                checkCrc();
+
+                size_t capacity = m_buffer->capacity();
+                write(static_cast<uint16_t>(capacity > 0xFFFF ? 0xFFFF : capacity));
+            }
+
         public:
             /**
              * @brief Constructor for EmbMessenger without periodic commands.
@@ -260,6 +373,34 @@ namespace emb
                 return m_is_periodic;
             }
 
+            /**
+             * @brief Puts the device on a bus shared with other devices, like RS-485.
+             *
+             * The device only runs the messages with its address or `shared::kBroadcastAddress`, the others are skipped
+             * without parsing them. Its responses start with its address so the host can tell the devices apart.
+             * Broadcasts can only run the commands from the command table and get no response, not even errors.
+             *
+             * @param address The device's address, any but `shared::kBroadcastAddress`
+             */
+            void setAddress(const uint8_t address)
+            {
+                m_addressed = true;
+                m_address = address;
+            }
+
+            /**
+             * @brief Determine if your command is being executed for a broadcast.
+             *
+             * Calling this from outside a command is undefined behaviour.
+             *
+             * @return true Your command is being executed for a message to every device, its response is discarded.
+             * @return false Your command is being executed for a message to this device.
+             */
+            bool getIsBroadcast() const
+            {
+                return m_broadcast;
+            }
+
             /**
              * @brief Update method for EmbMessenger.
              * 
@@ -271,11 +412,23 @@ namespace emb
                 m_buffer->update();
                 m_num_messages = m_buffer->messages();
 
+                // Messages for other devices on the bus are skipped before any of them is parsed
+                while (m_addressed && m_num_messages != 0 && !readAddress())
+                {
+                    consumeMessage();
+                    m_num_messages = m_buffer->messages();
+                }
+
                 if (m_num_messages != 0)
                 {
-                    m_reader.resetCrc();
+                    // The address is part of the CRC
+                    if (!m_addressed)
+                    {
+                        m_reader.resetCrc();
+                    }
                     m_message_id = 0;
                     m_parameter_index = 0;
+                    m_message_failed = false;
 
                     if (!m_reader.read(m_message_id))
                     {
@@ -296,6 +449,30 @@ namespace emb
                         return;
                     }
 
+                    if (m_broadcast && m_command_id >= 0xFFF0)
+                    {
+                        m_writer.writeError(shared::DataError::kCommandIdInvalid);
+                        m_writer.write(m_command_id);
+                        consumeMessage();
+                        m_writer.writeCrc();
+                        return;
+                    }
+
+                    // A retransmitted message that was already executed, the host lost the response. Only reported
+                    // once the whole message passed the CRC check, a corrupted message ID could be any message's.
+                    // Broadcasts have message IDs of their own.
+                    if (RecentMessages > 0 && !m_broadcast && m_command_id != 0xFFFF &&
+                        isDuplicateMessage(m_message_id))
+                    {
+                        bool valid = m_reader.skipMessage();
+                        consumeMessage();
+                        m_writer.writeError(valid ? shared::DataError::kDuplicateMessage
+                                                  : shared::DataError::kCrcInvalid);
+                        m_writer.write((uint8_t)0);
+                        m_writer.writeCrc();
+                        return;
+                    }
+
                     if (setjmp(m_jmp_buf) == 0)
                     {
                         switch (m_command_id)
@@ -309,11 +486,15 @@ namespace emb
                             case 0xFFFD:
                                 unregisterPeriodicCommand();
                                 break;
+                            case 0xFFFC:
+                                sendBufferCapacity();
+                                break;
                             default:
                                 if (m_command_id >= m_command_count)
                                 {
                                     m_writer.writeError(shared::DataError::kCommandIdInvalid);
                                     m_writer.write(m_command_id);
+                                    m_message_failed = true;
                                     consumeMessage();
                                     break;
                                 }
@@ -328,6 +509,7 @@ namespace emb
                                 {
                                     m_writer.writeError(shared::DataError::kCommandIdInvalid);
                                     m_writer.write(m_command_id);
+                                    m_message_failed = true;
                                     consumeMessage();
                                 }
                                 else
@@ -350,6 +532,7 @@ namespace emb
                                 consumeMessage();
                                 m_writer.writeError(shared::DataError::kCrcInvalid);
                                 m_writer.write((uint8_t)0);
+                                m_message_failed = true;
                             }
                         }
                         else
@@ -357,12 +540,24 @@ namespace emb
                             consumeMessage();
                             m_writer.writeError(shared::DataError::kExtraParameters);
                             m_writer.write((uint8_t)0);
+                            m_message_failed = true;
                         }
                     }
 
+                    if (RecentMessages > 0 && !m_message_failed && !m_broadcast)
+                    {
+                        rememberMessage(m_message_id);
+                    }
+
                     m_writer.writeCrc();
                 }
 
+                if (m_broadcast)
+                {
+                    m_writer = shared::Writer(m_buffer);
+                    m_broadcast = false;
+                }
+
                 if (MaxPeriodicCommands > 0)
                 {
                     m_is_periodic = true;
@@ -375,6 +570,10 @@ namespace emb
                             m_message_id = m_periodic_commands[i].message_id;
                             m_parameter_index = 0;
 
+                            if (m_addressed)
+                            {
+                                m_writer.write(m_address);
+                            }
                             m_writer.write(m_message_id);
                             if (setjmp(m_jmp_buf) == 0)
                             {
@@ -487,6 +686,7 @@ namespace emb
              */
             void reportError(const uint8_t code, const int16_t data = 0)
             {
+                m_message_failed = true;
                 m_writer.writeError(static_cast<shared::DataError>(code));
                 m_writer.write(data);
 
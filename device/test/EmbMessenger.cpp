@@ -247,6 +247,18 @@ namespace emb
                 ASSERT_TRUE(buffer.buffersEmpty());
             }
 
+            TEST(messenger_builtin_command, buffer_capacity)
+            {
+                FakeBuffer buffer;
+                EmbMessenger<>::CommandFunction commands[] = { [] {} };
+                EmbMessenger<> messenger(&buffer, commands, ARRAY_SIZE(commands));
+
+                buffer.addHostMessage({ 0x01, shared::DataType::kUint16, 0xFF, 0xFC });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer({ 0x01, 0x40 }));
+                ASSERT_TRUE(buffer.buffersEmpty());
+            }
+
             TEST(messenger_errors, parameter_read_error)
             {
                 bool ledState = false;
@@ -417,6 +429,116 @@ namespace emb
 
                 ASSERT_TRUE(buffer.buffersEmpty());
             }
+
+            TEST(messenger_errors, duplicate_message)
+            {
+                int pings = 0;
+
+                FakeBuffer buffer;
+                EmbMessenger<>::CommandFunction commands[] = { [&] { ++pings; } };
+                EmbMessenger<0, 2> messenger(&buffer, commands, ARRAY_SIZE(commands));
+
+                buffer.addHostMessage({ 0x01, 0x00 });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer({ 0x01 }));
+
+                // The retransmitted message isn't executed again
+                buffer.addHostMessage({ 0x01, 0x00 });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer(
+                    { 0x01, shared::DataType::kError, shared::DataError::kDuplicateMessage, 0x00 }));
+                ASSERT_EQ(pings, 1);
+
+                // A message whose ID only looks like a duplicate because it was corrupted fails the CRC check
+                buffer.writeValidCrc(false);
+                buffer.addHostMessage({ 0x01, 0x00, 0x05 });
+                messenger.update();
+                ASSERT_TRUE(
+                    buffer.checkDeviceBuffer({ 0x01, shared::DataType::kError, shared::DataError::kCrcInvalid, 0x00 }));
+                buffer.writeValidCrc(true);
+                ASSERT_EQ(pings, 1);
+
+                // Only the most recent messages are remembered
+                buffer.addHostMessage({ 0x02, 0x00 });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer({ 0x02 }));
+                buffer.addHostMessage({ 0x03, 0x00 });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer({ 0x03 }));
+                buffer.addHostMessage({ 0x01, 0x00 });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer({ 0x01 }));
+                ASSERT_EQ(pings, 4);
+
+                ASSERT_TRUE(buffer.buffersEmpty());
+            }
+
+            TEST(messenger_bus, addressed_messages)
+            {
+                int pings = 0;
+
+                FakeBuffer buffer;
+                EmbMessenger<>::CommandFunction commands[] = { [&] { ++pings; } };
+                EmbMessenger<0, 2> messenger(&buffer, commands, ARRAY_SIZE(commands));
+                messenger.setAddress(0x05);
+
+                // Messages for other devices are skipped, the next one is run in the same update
+                buffer.addHostMessage({ 0x04, 0x01, 0x00 });
+                buffer.addHostMessage({ shared::DataType::kUint8, 0x85, 0x02, 0x00 });
+                buffer.addHostMessage({ 0x05, 0x03, 0x00 });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer({ 0x05, 0x03 }));
+                ASSERT_EQ(pings, 1);
+
+                // The address is part of the CRC
+                buffer.writeValidCrc(false);
+                buffer.addHostMessage({ 0x05, 0x04, 0x00 });
+                messenger.update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer(
+                    { 0x05, 0x04, shared::DataType::kError, shared::DataError::kCrcInvalid, 0x00 }));
+
+                ASSERT_TRUE(buffer.buffersEmpty());
+            }
+
+            TEST(messenger_bus, broadcast)
+            {
+                int total = 0;
+                bool broadcast = false;
+
+                std::shared_ptr<EmbMessenger<0, 2>> messenger;
+
+                std::function<void()> add = [&] {
+                    int16_t value;
+                    messenger->read(value);
+                    total += value;
+                    broadcast = messenger->getIsBroadcast();
+                    messenger->write(total);
+                };
+
+                FakeBuffer buffer;
+                EmbMessenger<>::CommandFunction commands[] = { add };
+                messenger = std::make_shared<EmbMessenger<0, 2>>(&buffer, commands, ARRAY_SIZE(commands));
+                messenger->setAddress(0x05);
+
+                // Runs without a response, not even for errors
+                buffer.addHostMessage({ shared::DataType::kUint8, shared::kBroadcastAddress, 0x01, 0x00, 0x02 });
+                messenger->update();
+                buffer.addHostMessage({ shared::DataType::kUint8, shared::kBroadcastAddress, 0x02, 0x00 });
+                messenger->update();
+                buffer.addHostMessage({ shared::DataType::kUint8, shared::kBroadcastAddress, 0x03, 0x7F });
+                messenger->update();
+                ASSERT_TRUE(buffer.buffersEmpty());
+                ASSERT_EQ(total, 2);
+                ASSERT_TRUE(broadcast);
+
+                // Broadcast message IDs aren't remembered as duplicates
+                buffer.addHostMessage({ 0x05, 0x01, 0x00, 0x03 });
+                messenger->update();
+                ASSERT_TRUE(buffer.checkDeviceBuffer({ 0x05, 0x01, 0x05 }));
+                ASSERT_FALSE(broadcast);
+
+                ASSERT_TRUE(buffer.buffersEmpty());
+            }
         }  // namespace test
     }  // namespace device
 }  // namespace emb
@@ -129,6 +129,11 @@ namespace emb
                 return hostMessages;
             }
 
+            size_t FakeBuffer::capacity() const
+            {
+                return 64;
+            }
+
             void FakeBuffer::update()
             {
                 (void)0;  // Noop
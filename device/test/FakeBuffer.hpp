@@ -55,6 +55,7 @@ namespace emb
                 virtual bool empty() const override;
                 virtual size_t size() const override;
                 virtual uint8_t messages() const override;
+                virtual size_t capacity() const override;
                 virtual void update() override;
                 virtual void zero() override;
             };
@@ -59,6 +59,12 @@ public:
         return m_numberMessages;
     }
 
+    size_t capacity() const override
+    {
+        // One slot is always left empty to tell a full buffer from an empty one
+        return BufferSize - 1;
+    }
+
     void update() override
     {
         while (m_stream->available() > 0)
@@ -0,0 +1,114 @@
+#ifndef EMBMESSENGER_BUSEMULATOR_HPP
+#define EMBMESSENGER_BUSEMULATOR_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+#include "EmbMessenger/IClock.hpp"
+#include "EmbMessenger/LinkEmulator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief A bus shared by the host and many devices, like RS-485, emulated with one LinkEmulator.
+         *
+         * The host's end behaves like the host's end of the link. Every device hears everything the host writes,
+         * with the same delays and errors. The devices' messages go out whole, one at a time, like on a bus where
+         * the host only lets one device talk at a time, and each takes its time on the link.
+         */
+        class BusEmulator
+        {
+            class Line;
+
+            // A device's connection to the bus
+            class Drop : public shared::IBuffer
+            {
+                std::shared_ptr<Line> m_line;
+
+                std::vector<uint8_t> m_outgoing;
+                FrameSplitter m_write_splitter;
+
+                std::deque<uint8_t> m_received;
+                size_t m_messages;
+                FrameSplitter m_arrive_splitter;
+                FrameSplitter m_read_splitter;
+
+            public:
+                explicit Drop(std::shared_ptr<Line> line);
+                ~Drop();
+
+                void arrive(uint8_t byte);
+
+                virtual void writeByte(const uint8_t byte) override;
+                virtual uint8_t peek() const override;
+                virtual uint8_t readByte() override;
+                virtual bool empty() const override;
+                virtual size_t size() const override;
+                virtual uint8_t messages() const override;
+                virtual void update() override;
+                virtual void zero() override;
+            };
+
+            std::shared_ptr<Line> m_line;
+
+        public:
+            /**
+             * @brief Construct a new Bus Emulator that behaves the same both ways.
+             *
+             * @param options How the bus behaves, the devices to host direction uses the seed + 1
+             * @param clock Time for the bus, defaults to the wall clock
+             */
+            explicit BusEmulator(LinkOptions options, std::shared_ptr<IClock> clock = std::make_shared<SteadyClock>());
+
+            /**
+             * @brief Construct a new Bus Emulator that behaves differently each way.
+             *
+             * @param host_to_devices How the bytes written by the host travel
+             * @param devices_to_host How the bytes written by the devices travel
+             * @param clock Time for the bus, defaults to the wall clock
+             */
+            BusEmulator(LinkOptions host_to_devices, LinkOptions devices_to_host,
+                        std::shared_ptr<IClock> clock = std::make_shared<SteadyClock>());
+
+            BusEmulator(const BusEmulator&) = delete;
+            BusEmulator& operator=(const BusEmulator&) = delete;
+
+            /**
+             * @brief Gets the host's end of the bus.
+             *
+             * @return Buffer for a BusRouter
+             */
+            std::shared_ptr<shared::IBuffer> host() const;
+
+            /**
+             * @brief Connects a device to the bus, it hears what the host writes from now on.
+             *
+             * @return Buffer for the device's EmbMessenger
+             */
+            std::shared_ptr<shared::IBuffer> addDevice();
+
+            /**
+             * @brief Gets what happened to the bytes the host wrote.
+             *
+             * @return Counters of the host to devices direction
+             */
+            LinkEmulator::Counters hostToDevices() const;
+
+            /**
+             * @brief Gets what happened to the bytes the devices wrote.
+             *
+             * @return Counters of the devices to host direction
+             */
+            LinkEmulator::Counters devicesToHost() const;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_BUSEMULATOR_HPP
@@ -0,0 +1,116 @@
+#ifndef EMBMESSENGER_BUSROUTER_HPP
+#define EMBMESSENGER_BUSROUTER_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/IAddressable.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Shares the buffer of a bus, like an RS-485 port, between the EmbMessengers of the devices on it.
+         *
+         * Every device gets an endpoint, a buffer with its address for its own EmbMessenger. The endpoints write
+         * whole messages to the bus, one at a time. Updating an endpoint reads the responses from the bus and passes
+         * them on to the endpoints of the addresses they start with, responses for other addresses are dropped.
+         *
+         * In the Multi Threaded EmbMessenger the endpoints can be used from different threads.
+         */
+        class BusRouter
+        {
+            class Bus;
+
+        public:
+            /**
+             * @brief Buffer to one device on the bus.
+             */
+            class Endpoint : public shared::IBuffer, public IAddressable
+            {
+                std::shared_ptr<Bus> m_bus;
+                uint8_t m_address;
+
+                std::vector<uint8_t> m_outgoing;
+                FrameSplitter m_write_splitter;
+
+                std::deque<uint8_t> m_received;
+                size_t m_messages;
+                FrameSplitter m_read_splitter;
+#ifndef EMB_SINGLE_THREADED
+                mutable std::mutex m_mutex;
+#endif
+
+            public:
+                Endpoint(std::shared_ptr<Bus> bus, uint8_t address);
+                ~Endpoint();
+
+                Endpoint(const Endpoint&) = delete;
+                Endpoint& operator=(const Endpoint&) = delete;
+
+                /**
+                 * @brief Adds a message read from the bus, the router calls it.
+                 *
+                 * @param message The message's bytes
+                 */
+                void deliver(const std::vector<uint8_t>& message);
+
+                virtual void writeByte(const uint8_t byte) override;
+                virtual uint8_t peek() const override;
+                virtual uint8_t readByte() override;
+                virtual bool empty() const override;
+                virtual size_t size() const override;
+                virtual uint8_t messages() const override;
+                virtual void update() override;
+                virtual void zero() override;
+
+                virtual uint8_t address() const override;
+            };
+
+        private:
+            std::shared_ptr<Bus> m_bus;
+
+        public:
+            /**
+             * @brief Construct a new Bus Router.
+             *
+             * @param bus Buffer of the bus, only the router may use it from now on
+             */
+            explicit BusRouter(std::shared_ptr<shared::IBuffer> bus);
+
+            BusRouter(const BusRouter&) = delete;
+            BusRouter& operator=(const BusRouter&) = delete;
+
+            /**
+             * @brief Creates the endpoint of a device.
+             *
+             * The address is free again once the endpoint is destroyed. The endpoints keep the bus alive, the router
+             * may be destroyed before them.
+             *
+             * @param address The device's address
+             * @return Buffer for the device's EmbMessenger
+             * @throws std::invalid_argument If the address is `shared::kBroadcastAddress` or already has an endpoint
+             */
+            std::shared_ptr<shared::IBuffer> endpoint(uint8_t address);
+
+            /**
+             * @brief Gets the number of messages read from the bus that weren't for any endpoint.
+             *
+             * @return Number of messages dropped, including those whose address couldn't be read
+             */
+            uint64_t unrouted() const;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_BUSROUTER_HPP
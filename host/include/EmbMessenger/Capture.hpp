@@ -0,0 +1,127 @@
+#ifndef EMBMESSENGER_CAPTURE_HPP
+#define EMBMESSENGER_CAPTURE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Direction a captured message was sent in.
+         */
+        enum class CaptureDirection : uint8_t
+        {
+            HostToDevice = 0,  /// Written to the buffer by the host
+            DeviceToHost = 1   /// Read from the buffer by the host
+        };
+
+        /**
+         * @brief A message read from a capture file.
+         */
+        struct CaptureRecord
+        {
+            std::chrono::nanoseconds time{ 0 };                           /// Time since the capture started
+            CaptureDirection direction = CaptureDirection::HostToDevice;  /// Direction of the message
+            std::vector<uint8_t> data;                                    /// Bytes of the message
+        };
+
+        /**
+         * @brief Writes the header of a capture file.
+         *
+         * A capture file starts with the 8 byte header: `EMBCAP`, the version (2) and a flags byte. Each message
+         * follows as its time since the capture started in nanoseconds (8 bytes), its direction (1 byte), its length
+         * (2 bytes) and its bytes. Numbers are little endian. The only flag is `0x01`, set when the messages start
+         * with a bus address. Version 1 is the same without any flags.
+         *
+         * @param output Stream to write to
+         * @param addressed True if the messages start with a bus address, e.g. when capturing the bus of a BusRouter
+         */
+        void writeCaptureHeader(std::ostream& output, bool addressed = false);
+
+        /**
+         * @brief Writes a message to a capture file.
+         *
+         * @param output Stream to write to
+         * @param time Time since the capture started
+         * @param direction Direction of the message
+         * @param data Bytes of the message
+         * @param size Number of bytes in the message
+         */
+        void writeCaptureRecord(std::ostream& output, std::chrono::nanoseconds time, CaptureDirection direction,
+                                const uint8_t* data, size_t size);
+
+        /**
+         * @brief Reads the header of a capture file.
+         *
+         * @param input Stream to read from
+         * @return True if the messages start with a bus address
+         * @throws std::runtime_error If the stream isn't a capture file of a supported version, or sets flags this
+         *                            version doesn't know about
+         */
+        bool readCaptureHeader(std::istream& input);
+
+        /**
+         * @brief Reads the next message from a capture file.
+         *
+         * @param input Stream to read from, after the header
+         * @param record Record to read the message into
+         * @return False at the end of the file, or if the last message was cut off
+         */
+        bool readCaptureRecord(std::istream& input, CaptureRecord& record);
+
+        /**
+         * @brief Reads a whole capture file.
+         *
+         * @param input Stream to read from
+         * @return The messages in the file
+         * @throws std::runtime_error If the stream isn't a capture file of a supported version
+         */
+        std::vector<CaptureRecord> readCapture(std::istream& input);
+
+        /**
+         * @brief Reads a whole capture file.
+         *
+         * @param input Stream to read from
+         * @param[out] addressed Set to true if the messages start with a bus address
+         * @return The messages in the file
+         * @throws std::runtime_error If the stream isn't a capture file of a supported version
+         */
+        std::vector<CaptureRecord> readCapture(std::istream& input, bool& addressed);
+
+        /**
+         * @brief Finds where messages end in a stream of bytes.
+         *
+         * Follows the data type of each value, so a data byte that happens to look like the end of a message isn't
+         * mistaken for one.
+         */
+        class FrameSplitter
+        {
+            uint8_t m_remaining;
+            bool m_end_of_message;
+
+        public:
+            FrameSplitter();
+
+            /**
+             * @brief Feeds the next byte of the stream.
+             *
+             * @param byte The byte
+             * @return True if the byte is the last byte of a message
+             */
+            bool push(uint8_t byte);
+
+            /**
+             * @brief Starts over at the beginning of a message.
+             */
+            void reset();
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_CAPTURE_HPP
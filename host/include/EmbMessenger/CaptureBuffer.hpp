@@ -0,0 +1,140 @@
+#ifndef EMBMESSENGER_CAPTUREBUFFER_HPP
+#define EMBMESSENGER_CAPTUREBUFFER_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/Frame.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+#include "EmbMessenger/SpscQueue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#include <thread>
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Buffer that records the messages going through another buffer to a capture file.
+         *
+         * Each message written to or read from the real buffer is timestamped and queued, the file is written by a
+         * background thread, or during update in the Single Threaded EmbMessenger. Queueing a message is a copy into a
+         * preallocated lock free queue, so capturing can be left on without changing the timing of the link. Messages
+         * that arrive while the queue is full are dropped, see dropped.
+         *
+         * Messages of each direction are written in order, messages of the two directions are interleaved by time.
+         * Read the file with readCapture, or replay it with ReplayBuffer.
+         */
+        class CaptureBuffer : public shared::IBuffer
+        {
+            struct Entry
+            {
+                std::chrono::nanoseconds time{ 0 };
+                Frame frame;
+            };
+
+            static constexpr size_t kBatchSize = 64;
+
+            std::shared_ptr<shared::IBuffer> m_buffer;
+            std::shared_ptr<std::ostream> m_output;
+            std::chrono::steady_clock::time_point m_start;
+
+            // The host only writes from one thread at a time and reads from one thread, so each direction has a
+            // single producer
+            SpscQueue<Entry> m_transmitted;
+            SpscQueue<Entry> m_received;
+            Frame m_transmit_frame;
+            Frame m_receive_frame;
+            FrameSplitter m_transmit_splitter;
+            FrameSplitter m_receive_splitter;
+            std::atomic<size_t> m_dropped;
+
+            // Taken off the queues a batch at a time, what isn't written yet is kept for the next call
+            std::vector<Entry> m_transmitted_batch;
+            std::vector<Entry> m_received_batch;
+            size_t m_transmitted_index;
+            size_t m_transmitted_count;
+            size_t m_received_index;
+            size_t m_received_count;
+
+#ifndef EMB_SINGLE_THREADED
+            std::mutex m_output_mutex;
+            std::thread m_writer;
+            std::atomic_bool m_writing;
+
+            void writeThread();
+#endif
+
+            void capture(SpscQueue<Entry>& queue, Frame& frame, FrameSplitter& splitter, uint8_t byte);
+            size_t writeQueued();
+
+        public:
+            /**
+             * @brief Construct a new Capture Buffer writing to a stream.
+             *
+             * @param buffer The real buffer to use for communication
+             * @param output Stream to write the capture to, it is written from the background thread
+             * @param capacity Number of messages each direction can queue before they are dropped
+             * @param addressed True if the messages start with a bus address, like on the bus of a BusRouter. It is
+             *                  recorded in the header so the capture is decoded with the address.
+             */
+            CaptureBuffer(std::shared_ptr<shared::IBuffer> buffer, std::shared_ptr<std::ostream> output,
+                          size_t capacity = 1024, bool addressed = false);
+
+            /**
+             * @brief Construct a new Capture Buffer writing to a file.
+             *
+             * @param buffer The real buffer to use for communication
+             * @param path Path of the capture file, it is overwritten
+             * @param capacity Number of messages each direction can queue before they are dropped
+             * @param addressed True if the messages start with a bus address, like on the bus of a BusRouter
+             * @throws std::runtime_error If the file can't be opened
+             */
+            CaptureBuffer(std::shared_ptr<shared::IBuffer> buffer, const std::string& path, size_t capacity = 1024,
+                          bool addressed = false);
+
+            /**
+             * @brief Writes the remaining messages and flushes the capture.
+             */
+            ~CaptureBuffer();
+
+            CaptureBuffer(const CaptureBuffer&) = delete;
+            CaptureBuffer& operator=(const CaptureBuffer&) = delete;
+
+            /**
+             * @brief Writes the messages queued so far to the stream and flushes it.
+             *
+             * Waits for the background thread in the Multi Threaded EmbMessenger.
+             */
+            void flush();
+
+            /**
+             * @brief Gets the number of messages that weren't captured because the queue was full.
+             *
+             * @return Number of dropped messages
+             */
+            size_t dropped() const;
+
+            virtual void writeByte(const uint8_t byte) override;
+            virtual uint8_t peek() const override;
+            virtual uint8_t readByte() override;
+            virtual bool empty() const override;
+            virtual size_t size() const override;
+            virtual uint8_t messages() const override;
+            virtual size_t capacity() const override;
+            virtual void update() override;
+            virtual void zero() override;
+            virtual void print() const override;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_CAPTUREBUFFER_HPP
@@ -1,22 +1,23 @@
 #ifndef EMBMESSENGER_COMMAND_HPP
 #define EMBMESSENGER_COMMAND_HPP
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <exception>
 #include <functional>
 #include <memory>
 #include <typeindex>
 
-#ifndef EMB_SINGLE_THREADED
-#include <condition_variable>
-#include <mutex>
-#endif
-
 namespace emb
 {
     namespace host
     {
         class EmbMessenger;
 
+        template <typename CommandType>
+        class CommandFuture;
+
         enum class CommandState
         {
             NotSent,
@@ -37,21 +38,63 @@ namespace emb
         {
             friend class EmbMessenger;
 
+            template <typename CommandType>
+            friend class CommandFuture;
+
+            enum class ContinuationState : uint8_t
+            {
+                None,
+                Set,
+                Fired
+            };
+
+            enum class CallbackState : uint8_t
+            {
+                Idle,
+                Pending,     // Its callback was given to the executor and hasn't returned yet
+                PendingSend  // Sent again meanwhile, it is sent once the callback returns
+            };
+
         private:
             std::type_index m_type_index;
             uint16_t m_message_id;
+            uint16_t m_frame_size = 0;
+            std::chrono::milliseconds m_timeout{ 0 };
             std::function<void(std::shared_ptr<Command>)> m_callback = nullptr;
             bool m_is_periodic = false;
-            CommandState m_command_state = CommandState::NotSent;
+            std::atomic<CommandState> m_command_state;
+            std::exception_ptr m_exception;
 
-#ifndef EMB_SINGLE_THREADED
-            std::mutex m_mutex;
+            void (*m_continuation)(void*) = nullptr;
+            void* m_continuation_argument = nullptr;
+            std::atomic<ContinuationState> m_continuation_state;
 
-        protected:
-            std::condition_variable m_condition_variable;
-            bool m_is_waiting = false;
+#ifndef EMB_SINGLE_THREADED
+            std::atomic<CallbackState> m_callback_state{ CallbackState::Idle };
+            uint16_t m_deferred_command_id = 0;
 #endif
 
+            /**
+             * @brief Marks the command as received, wakes any threads waiting on it and runs its continuation.
+             */
+            void complete();
+
+            /**
+             * @brief Completes the command with an error.
+             *
+             * @param exception The error that occurred while receiving the command
+             */
+            void fail(std::exception_ptr exception);
+
+            /**
+             * @brief Sets a function to run once when the command completes.
+             *
+             * @param continuation Function to run on the thread that completes the command
+             * @param argument Argument for the function
+             * @return False if the command already completed, the continuation will not be run
+             */
+            bool setContinuation(void (*continuation)(void*), void* argument);
+
         public:
             /**
              * @brief Construct a new Command.
@@ -118,13 +161,68 @@ namespace emb
              */
             CommandState getCommandState() const;
 
+            /**
+             * @brief Gets the error that occurred while receiving the command.
+             *
+             * @return The error, or `nullptr` if the command didn't fail
+             */
+            std::exception_ptr getException() const;
+
+            /**
+             * @brief Sets how long to wait for the device to respond before the command fails with CommandTimeout.
+             *
+             * Overrides EmbMessenger::setDefaultTimeout for this command. Set before sending the command.
+             *
+             * @param timeout Time to wait after the message is written, `0` to use the messenger's default
+             */
+            void setTimeout(std::chrono::milliseconds timeout);
+
+            /**
+             * @brief Gets how long to wait for the device to respond.
+             *
+             * @return The command's timeout, `0` if it uses the messenger's default
+             */
+            std::chrono::milliseconds getTimeout() const;
+
+            /**
+             * @brief Checks if the command is executed periodically on the device.
+             *
+             * @return True if the command was registered using EmbMessenger::registerPeriodicCommand
+             */
+            bool isPeriodic() const;
+
 #ifndef EMB_SINGLE_THREADED
             /**
              * @brief Have your thread wait until the command receives a response from the device.
              */
             void wait();
+
+            /**
+             * @brief Have your thread wait until the command receives a response from the device or the timeout expires.
+             *
+             * @param timeout Maximum time to wait
+             * @return True if the command received a response
+             */
+            bool waitFor(std::chrono::nanoseconds timeout);
+
+            /**
+             * @brief Have your thread wait until the command receives a response from the device or the deadline passes.
+             *
+             * @param deadline Time to stop waiting
+             * @return True if the command received a response
+             */
+            bool waitUntil(std::chrono::steady_clock::time_point deadline);
 #endif
         };
+
+        /**
+         * @brief Entry in the EmbMessenger's completion queue.
+         */
+        struct Completion
+        {
+            std::shared_ptr<Command> command;  /// The command that received a message from the device
+            std::exception_ptr exception;      /// The error that occurred while receiving, or `nullptr`
+        };
     }  // namespace host
 }  // namespace emb
 
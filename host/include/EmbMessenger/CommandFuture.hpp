@@ -0,0 +1,176 @@
+#ifndef EMBMESSENGER_COMMANDFUTURE_HPP
+#define EMBMESSENGER_COMMANDFUTURE_HPP
+
+#include "EmbMessenger/Command.hpp"
+#include "EmbMessenger/Exceptions.hpp"
+
+#include <memory>
+
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define EMB_HAS_COROUTINES
+#endif
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Handle to the result of a command sent with EmbMessenger::sendAsync.
+         *
+         * The future only holds a pointer to the command, it doesn't allocate.
+         * With C++20 coroutines the future can be `co_await`ed, the coroutine is resumed on the thread that parses the
+         * response from the device.
+         *
+         * @tparam CommandType The type of the command
+         */
+        template <typename CommandType>
+        class CommandFuture
+        {
+            std::shared_ptr<CommandType> m_command;
+
+        public:
+            /**
+             * @brief Construct an empty future.
+             */
+            CommandFuture() = default;
+
+            /**
+             * @brief Construct a future for a sent command.
+             *
+             * @param command The command that was sent
+             */
+            explicit CommandFuture(std::shared_ptr<CommandType> command) : m_command(std::move(command))
+            {
+            }
+
+            /**
+             * @brief Checks if the future refers to a command.
+             *
+             * @return True if the future refers to a command
+             */
+            bool valid() const
+            {
+                return m_command != nullptr;
+            }
+
+            /**
+             * @brief Checks if the device has responded to the command.
+             *
+             * @return True if the command was received or failed
+             */
+            bool ready() const
+            {
+                return m_command->getCommandState() == CommandState::Received;
+            }
+
+            /**
+             * @brief Gets the command once the device has responded.
+             *
+             * Blocks in the multi threaded messenger. In the single threaded messenger, call EmbMessenger::update until
+             * the future is ready.
+             *
+             * @return The received command
+             * @throws The error that occurred while receiving the command, or CommandNotReceived
+             */
+            std::shared_ptr<CommandType> get() const
+            {
+#ifndef EMB_SINGLE_THREADED
+                wait();
+#endif
+                if (!ready())
+                {
+                    throw CommandNotReceived("The device has not responded to the command", m_command);
+                }
+
+                if (m_command->getException() != nullptr)
+                {
+                    std::rethrow_exception(m_command->getException());
+                }
+
+                return m_command;
+            }
+
+#ifndef EMB_SINGLE_THREADED
+            /**
+             * @brief Blocks until the device responds to the command.
+             */
+            void wait() const
+            {
+                m_command->wait();
+            }
+
+            /**
+             * @brief Blocks until the device responds to the command or the timeout expires.
+             *
+             * @param timeout Maximum time to wait
+             * @return True if the command was received
+             */
+            bool waitFor(std::chrono::nanoseconds timeout) const
+            {
+                return m_command->waitFor(timeout);
+            }
+
+            /**
+             * @brief Blocks until the device responds to the command or the deadline passes.
+             *
+             * @param deadline Time to stop waiting
+             * @return True if the command was received
+             */
+            bool waitUntil(std::chrono::steady_clock::time_point deadline) const
+            {
+                return m_command->waitUntil(deadline);
+            }
+#endif
+
+#ifdef EMB_HAS_COROUTINES
+            /**
+             * @brief Awaiter used by `co_await`.
+             */
+            class Awaiter
+            {
+                std::shared_ptr<CommandType> m_command;
+
+                static void resume(void* address)
+                {
+                    std::coroutine_handle<>::from_address(address).resume();
+                }
+
+            public:
+                explicit Awaiter(std::shared_ptr<CommandType> command) : m_command(std::move(command))
+                {
+                }
+
+                bool await_ready() const noexcept
+                {
+                    return m_command->getCommandState() == CommandState::Received;
+                }
+
+                bool await_suspend(std::coroutine_handle<> handle)
+                {
+                    // Don't suspend if the command completed in the meantime
+                    return m_command->setContinuation(&Awaiter::resume, handle.address());
+                }
+
+                std::shared_ptr<CommandType> await_resume() const
+                {
+                    if (m_command->getException() != nullptr)
+                    {
+                        std::rethrow_exception(m_command->getException());
+                    }
+                    return m_command;
+                }
+            };
+
+            Awaiter operator co_await() const
+            {
+                return Awaiter(m_command);
+            }
+#endif
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_COMMANDFUTURE_HPP
@@ -0,0 +1,129 @@
+#ifndef EMBMESSENGER_COMMANDPOOL_HPP
+#define EMBMESSENGER_COMMANDPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Recycling memory pool for commands.
+         *
+         * Memory is handed out in blocks rounded up to 16 bytes. Freed blocks are kept on a free list for their size
+         * and reused by the next allocation of the same size, so once every command type in use has been allocated
+         * the pool stops asking the system for memory.
+         * Blocks larger than `kMaxBlockSize` bypass the pool.
+         */
+        class CommandPool
+        {
+        public:
+            static constexpr size_t kBlockAlignment = 16;
+            static constexpr size_t kMaxBlockSize = 512;
+
+        private:
+            struct Block
+            {
+                Block* next;
+            };
+
+            Block* m_free_blocks[kMaxBlockSize / kBlockAlignment];
+            size_t m_system_allocations;
+
+#ifndef EMB_SINGLE_THREADED
+            std::mutex m_mutex;
+#endif
+
+        public:
+            CommandPool();
+            ~CommandPool();
+
+            CommandPool(const CommandPool&) = delete;
+            CommandPool& operator=(const CommandPool&) = delete;
+
+            /**
+             * @brief Allocates a block of memory.
+             *
+             * @param bytes Number of bytes to allocate
+             * @return Pointer to the block
+             */
+            void* allocate(size_t bytes);
+
+            /**
+             * @brief Returns a block of memory to the pool.
+             *
+             * @param pointer Pointer to the block
+             * @param bytes Number of bytes that were allocated
+             */
+            void deallocate(void* pointer, size_t bytes);
+
+            /**
+             * @brief Gets the number of blocks the pool requested from the system.
+             *
+             * @return Number of system allocations made by the pool
+             */
+            size_t systemAllocations();
+        };
+
+        /**
+         * @brief Standard allocator backed by a CommandPool, for use with `std::allocate_shared`.
+         *
+         * @tparam T Type to allocate
+         */
+        template <typename T>
+        class PoolAllocator
+        {
+            template <typename U>
+            friend class PoolAllocator;
+
+            std::shared_ptr<CommandPool> m_pool;
+
+        public:
+            using value_type = T;
+
+            /**
+             * @brief Construct a new Pool Allocator.
+             *
+             * @param pool Pool to allocate from, kept alive by the allocator
+             */
+            explicit PoolAllocator(std::shared_ptr<CommandPool> pool) noexcept : m_pool(std::move(pool))
+            {
+            }
+
+            template <typename U>
+            PoolAllocator(const PoolAllocator<U>& other) noexcept : m_pool(other.m_pool)
+            {
+            }
+
+            T* allocate(size_t n)
+            {
+                return static_cast<T*>(m_pool->allocate(n * sizeof(T)));
+            }
+
+            void deallocate(T* pointer, size_t n)
+            {
+                m_pool->deallocate(pointer, n * sizeof(T));
+            }
+
+            template <typename U>
+            bool operator==(const PoolAllocator<U>& other) const noexcept
+            {
+                return m_pool == other.m_pool;
+            }
+
+            template <typename U>
+            bool operator!=(const PoolAllocator<U>& other) const noexcept
+            {
+                return m_pool != other.m_pool;
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_COMMANDPOOL_HPP
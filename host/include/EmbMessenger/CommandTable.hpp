@@ -0,0 +1,119 @@
+#ifndef EMBMESSENGER_COMMANDTABLE_HPP
+#define EMBMESSENGER_COMMANDTABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        class Command;
+
+        /**
+         * @brief Fixed capacity table of the commands waiting on messages from the device.
+         *
+         * Message IDs are mapped directly onto a ring of slots (`message_id % capacity`), so lookups and removals
+         * never search or allocate. When the 16-bit message ID counter comes back around to a slot that is still in
+         * use, e.g. by a periodic command, that ID is skipped.
+         *
+         * The table is not synchronized, the owner is responsible for locking.
+         */
+        class CommandTable
+        {
+            struct Slot
+            {
+                std::shared_ptr<Command> command;
+                uint16_t message_id = 0;
+            };
+
+            std::vector<Slot> m_slots;
+            uint16_t m_mask;
+            uint16_t m_next_message_id;
+            size_t m_size;
+
+        public:
+            /**
+             * @brief Construct a new Command Table.
+             *
+             * @param capacity Maximum number of pending commands, rounded up to a power of two. Must be at most `32768`
+             */
+            explicit CommandTable(size_t capacity = 256);
+
+            /**
+             * @brief Allocates a message ID for the command and stores it.
+             *
+             * @param command Command to store
+             * @return The message ID allocated to the command
+             */
+            uint16_t insert(std::shared_ptr<Command> command);
+
+            /**
+             * @brief Replaces the command stored under an allocated message ID.
+             *
+             * Used to hand a message ID over to a periodic command.
+             *
+             * @param message_id Message ID of the slot
+             * @param command Command to store
+             */
+            void assign(uint16_t message_id, std::shared_ptr<Command> command);
+
+            /**
+             * @brief Gets the command waiting on a message ID.
+             *
+             * @param message_id Message ID to look up
+             * @return The command, or `nullptr` if no command is waiting on the message ID
+             */
+            std::shared_ptr<Command> find(uint16_t message_id) const;
+
+            /**
+             * @brief Removes the command waiting on a message ID.
+             *
+             * @param message_id Message ID to remove
+             * @return True if a command was removed
+             */
+            bool erase(uint16_t message_id);
+
+            /**
+             * @brief Removes all commands, the message ID counter is not reset.
+             */
+            void clear();
+
+            /**
+             * @brief Gets the number of commands in the table.
+             *
+             * @return Number of commands in the table
+             */
+            size_t size() const;
+
+            /**
+             * @brief Gets the maximum number of commands the table can hold.
+             *
+             * @return Capacity of the table
+             */
+            size_t capacity() const;
+
+            /**
+             * @brief Calls @p function for each command in the table.
+             *
+             * @tparam Function Type of the function, `void(const std::shared_ptr<Command>&)`
+             * @param function Function to call
+             */
+            template <typename Function>
+            void forEach(Function&& function) const
+            {
+                for (const Slot& slot : m_slots)
+                {
+                    if (slot.command != nullptr)
+                    {
+                        function(slot.command);
+                    }
+                }
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_COMMANDTABLE_HPP
@@ -1,58 +1,111 @@
 #ifndef DEBUGBUFFER_HPP
 #define DEBUGBUFFER_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <iostream>
 #include <vector>
 #include <memory>
 
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#include <thread>
+#endif
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/Frame.hpp"
 #include "EmbMessenger/IBuffer.hpp"
-#include "EmbMessenger/Reader.hpp"
+#include "EmbMessenger/ProtocolLog.hpp"
+#include "EmbMessenger/SpscQueue.hpp"
 
 namespace emb
 {
     namespace host
     {
+        /**
+         * @brief Severity of a line printed by the DebugBuffer.
+         */
+        enum class DebugSeverity
+        {
+            Trace,  /// Each value of a message
+            Info,   /// The message and command ids, and the CRC check
+            Error   /// Invalid CRCs, error values and anything that can't be decoded
+        };
+
+        /**
+         * @brief Options for the DebugBuffer.
+         */
+        struct DebugOptions
+        {
+            size_t capacity = 1024;                         /// Number of messages each direction can queue
+            uint32_t sample_every = 1;                      /// Decode one of every this many messages per direction
+            DebugSeverity severity = DebugSeverity::Trace;  /// Lines less severe than this aren't printed
+            bool addressed = false;                         /// Messages start with a bus address, as under a BusRouter
+        };
+
         /**
          * @brief Buffer for debugging what gets sent to and from the device.
          * Intercepts, interprets and forwards bytes sent to the device.
+         *
+         * The bytes are only copied into a preallocated lock free queue on the way through, the messages are decoded
+         * and printed by a background thread, or during update in the Single Threaded EmbMessenger. That way it can
+         * be left on without changing the timing of the link. Messages that arrive while the queue is full are
+         * dropped, see dropped.
          */
         class DebugBuffer : public emb::shared::IBuffer
         {
-            enum class BufferType
+            struct Entry
             {
-                Write,
-                Read
+                uint64_t sequence = 0;
+                Frame frame;
             };
 
-            class DecodeBuffer : public emb::shared::IBuffer
+            // The messages of one direction, each direction has a single producer
+            struct Direction
             {
-                std::vector<uint8_t> m_buf;
-                uint8_t m_numberMessages = 0;
-                BufferType m_type;
-                std::function<void(std::string)> m_print_func;
-
-                emb::shared::DataType m_readType, m_writeType;
-                uint8_t m_readBytes, m_writeBytes;
-
-                void decode();
-
-            public:
-                DecodeBuffer(BufferType type, std::function<void(std::string)> print_func);
-
-                virtual void writeByte(const uint8_t byte) override;
-                virtual uint8_t peek() const override;
-                virtual uint8_t readByte() override;
-                virtual bool empty() const override;
-                virtual size_t size() const override;
-                virtual uint8_t messages() const override;
-                virtual void update() override;
-                virtual void zero() override;
+                SpscQueue<Entry> queue;
+                Frame frame;
+                FrameSplitter splitter;
+                uint64_t messages = 0;
+                bool sampled = true;
+
+                explicit Direction(size_t capacity);
             };
 
+            static constexpr size_t kBatchSize = 64;
+
             std::shared_ptr<emb::shared::IBuffer> m_real_buffer;
-            DecodeBuffer m_read_buffer, m_write_buffer;
+            std::function<void(std::string)> m_print_func;
+            DebugOptions m_options;
+
+            Direction m_write;
+            Direction m_read;
+            std::atomic<uint64_t> m_sequence;
+            std::atomic<size_t> m_dropped;
+
+            // Taken off the queues a batch at a time, what isn't decoded yet is kept for the next call
+            std::vector<Entry> m_write_batch;
+            std::vector<Entry> m_read_batch;
+            size_t m_write_index;
+            size_t m_write_count;
+            size_t m_read_index;
+            size_t m_read_count;
+            std::vector<ProtocolEvent> m_events;
+
+#ifndef EMB_SINGLE_THREADED
+            std::mutex m_decode_mutex;
+            std::thread m_decoder;
+            std::atomic_bool m_decoding;
+
+            void decodeThread();
+#endif
+
+            void intercept(Direction& direction, uint8_t byte);
+            size_t decodeQueued();
+            void decode(CaptureDirection direction, const Frame& frame);
+            void print(DebugSeverity severity, const std::string& line) const;
 
         public:
             /**
@@ -60,8 +113,33 @@ namespace emb
              *
              * @param buffer The real buffer to use for communication.
              * @param print_func The function for printing the output. Defaults to stdout.
+             *                   It is called from the background thread.
+             * @param options Queue size, sampling and severity filter.
+             */
+            DebugBuffer(std::shared_ptr<emb::shared::IBuffer> buffer, std::function<void(std::string)> print_func = [](std::string str) { std::cout << str << std::endl; },
+                        DebugOptions options = DebugOptions());
+
+            /**
+             * @brief Prints the remaining messages.
+             */
+            ~DebugBuffer();
+
+            DebugBuffer(const DebugBuffer&) = delete;
+            DebugBuffer& operator=(const DebugBuffer&) = delete;
+
+            /**
+             * @brief Decodes and prints the messages queued so far.
+             *
+             * Waits for the background thread in the Multi Threaded EmbMessenger.
+             */
+            void flush();
+
+            /**
+             * @brief Gets the number of sampled messages that weren't printed because the queue was full.
+             *
+             * @return Number of dropped messages
              */
-            DebugBuffer(std::shared_ptr<emb::shared::IBuffer> buffer, std::function<void(std::string)> print_func = [](std::string str) { std::cout << str << std::endl; });
+            size_t dropped() const;
 
             virtual void writeByte(const uint8_t byte) override;
             virtual uint8_t peek() const override;
@@ -69,10 +147,12 @@ namespace emb
             virtual bool empty() const override;
             virtual size_t size() const override;
             virtual uint8_t messages() const override;
+            virtual size_t capacity() const override;
             virtual void update() override;
             virtual void zero() override;
+            virtual void print() const override;
         };
     }  // namespace host
 }  // namespace emb
 
-#endif  // DEBUGBUFFER_HPP
\ No newline at end of file
+#endif  // DEBUGBUFFER_HPP
@@ -2,20 +2,38 @@
 #define EMBMESSENGER_EMBMESSENGER_HPP
 
 #include "EmbMessenger/Command.hpp"
+#include "EmbMessenger/CommandFuture.hpp"
+#include "EmbMessenger/CommandPool.hpp"
+#include "EmbMessenger/CommandTable.hpp"
 #include "EmbMessenger/Exceptions.hpp"
+#include "EmbMessenger/Frame.hpp"
+#include "EmbMessenger/FrameQueue.hpp"
 #include "EmbMessenger/IBuffer.hpp"
+#include "EmbMessenger/IExecutor.hpp"
+#include "EmbMessenger/ITracer.hpp"
+#include "EmbMessenger/LinkStats.hpp"
+#include "EmbMessenger/Metrics.hpp"
 #include "EmbMessenger/Reader.hpp"
+#include "EmbMessenger/RttEstimator.hpp"
+#include "EmbMessenger/SpscQueue.hpp"
+#include "EmbMessenger/TimerWheel.hpp"
 #include "EmbMessenger/Writer.hpp"
 
 #include <chrono>
+#include <deque>
 #include <map>
 #include <memory>
+#include <set>
 #include <typeindex>
+#include <vector>
 
 #ifndef EMB_SINGLE_THREADED
+#include "EmbMessenger/ThreadOptions.hpp"
+
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <thread>
-#include <atomic>
 #endif
 
 namespace emb
@@ -31,31 +49,163 @@ namespace emb
         {
         protected:
             std::shared_ptr<shared::IBuffer> m_buffer;
-            shared::Writer m_writer;
+
+            // Each received message is copied here and its CRC checked before any of it is decoded
+            Frame m_received_frame;
             shared::Reader m_reader;
 
-            uint16_t m_message_id;
+            // The device's address when the buffer is an IAddressable on a bus
+            bool m_addressed;
+            uint8_t m_address;
+
             std::map<std::type_index, uint16_t> m_command_ids;
-            std::map<uint16_t, std::shared_ptr<Command>> m_commands;
+            CommandTable m_commands;
+            std::shared_ptr<CommandPool> m_command_pool;
             std::shared_ptr<Command> m_current_command;
             uint8_t m_parameter_index;
 
+            std::unique_ptr<SpscQueue<Completion>> m_completion_queue_storage;
+            std::atomic<SpscQueue<Completion>*> m_completion_queue;
+            std::atomic<size_t> m_dropped_completions;
+
+            std::shared_ptr<IExecutor> m_executor;
+
+            // Messages waiting to be written to the buffer, in the Single Threaded EmbMessenger only while waiting on
+            // flow control credit
+            FrameQueue m_frame_queue;
+
+#ifdef EMB_SINGLE_THREADED
+            struct QueuedCommand
+            {
+                std::shared_ptr<Command> command;
+                uint16_t command_id = 0;
+            };
+
+            // The commands of the messages in m_frame_queue, in the same order. Their timers start once written.
+            std::deque<QueuedCommand> m_queued_commands;
+#endif
+
+            // Flow control, guarded by m_write_mutex in the Multi Threaded EmbMessenger
+            std::atomic_bool m_flow_control;
+            size_t m_window_bytes;
+            size_t m_window_messages;
+            size_t m_bytes_in_flight;
+            size_t m_messages_in_flight;
+
+            struct PendingFrame
+            {
+                Frame frame;
+                uint16_t message_id = 0;
+                uint8_t retries = 0;
+                bool active = false;
+            };
+
+            enum class Recovery
+            {
+                None,        // The error can't be recovered from, fail the command
+                Retransmit,  // The message will be sent again with the same message ID
+                Resend       // The command will be sent again with a new message ID
+            };
+
+            // Retransmission, guarded by m_commands_mutex in the Multi Threaded EmbMessenger
+            std::atomic_bool m_retransmission;
+            std::chrono::milliseconds m_retransmit_timeout;
+            uint8_t m_max_retries;
+            std::vector<PendingFrame> m_pending_frames;
+            std::atomic<size_t> m_retransmissions;
+            std::set<std::type_index> m_idempotent_commands;
+
+            // Timers of the messages waiting on the device, guarded by m_commands_mutex in the Multi Threaded
+            // EmbMessenger. Each command slot has a deadline timer and after it a retransmission timer, the last
+            // timer is the keepalive.
+            TimerWheel m_timers;
+            std::vector<uint16_t> m_deadline_message_ids;
+            std::chrono::milliseconds m_default_timeout;
+            std::atomic<TimerWheel::clock_t::rep> m_next_tick;
+            std::vector<Completion> m_expired;
+            std::atomic<size_t> m_timeouts;
+
+            struct SentMessage
+            {
+                TimerWheel::clock_t::time_point time;
+                uint16_t message_id = 0;
+                uint16_t command_id = 0;
+                bool sample = false;
+            };
+
+            // Round trip times and keepalives, guarded by m_commands_mutex in the Multi Threaded EmbMessenger
+            std::vector<SentMessage> m_sent_messages;
+            RttEstimator m_rtt;
+            std::atomic<TimerWheel::clock_t::rep> m_last_response;
+            std::atomic<TimerWheel::clock_t::rep> m_last_activity;
+            std::chrono::milliseconds m_keepalive_interval;
+            bool m_keepalive_due;
+            std::atomic<size_t> m_keepalives_sent;
+            std::atomic<size_t> m_keepalives_missed;
+
+            Metrics m_metrics;
+
+#ifdef EMB_TRACING
+            // Every tracer set is kept alive, a hook may still be running on another thread when it is replaced
+            std::vector<std::shared_ptr<ITracer>> m_tracers;
+            std::atomic<ITracer*> m_tracer{ nullptr };
+#endif
+
 #ifndef EMB_SINGLE_THREADED
             std::function<bool(std::exception_ptr)> m_exception_handler;
+            ThreadOptions m_thread_options;
 
             std::thread m_update_thread;
+            std::atomic<std::thread::id> m_receive_thread;
             std::atomic_bool m_running;
             std::mutex m_commands_mutex;
 
+            std::thread m_write_thread;
+            std::atomic_bool m_writing;
+            std::atomic_bool m_writer_waiting;
+            std::mutex m_write_mutex;
+            std::condition_variable m_write_condition;
+            std::condition_variable m_credit_condition;
+
+            std::atomic<size_t> m_pending_callbacks;
+            std::atomic<size_t> m_dropped_samples;
+
             void update();
             void updateThread();
+            void writeThread();
+#else
+            void flushPendingFrames();
 #endif
 
+            static shared::Writer& frameWriter();
+            void flushFrame(const Frame& frame, bool take_credit = true);
+            void writeFrame(const Frame& frame);
+
+            size_t processMessages(size_t max);
+            size_t receiveMessages(size_t max);
+
             void write();
             void read();
 
             void readErrors();
+            bool receiveFrame();
             void consumeMessage();
+            void pushCompletion(const std::shared_ptr<Command>& command, std::exception_ptr exception);
+            void dispatchCallback(IExecutor& executor, uint16_t key, const std::shared_ptr<Command>& command);
+            static bool isBuiltInCommand(const Command& command);
+            bool hasCredit(size_t bytes) const;
+            void acquireCredit(Command& command, size_t bytes);
+
+            PendingFrame& pendingFrame(uint16_t message_id);
+            void startTimers(const std::shared_ptr<Command>& command, uint16_t command_id);
+            void cancelTimers(uint16_t message_id);
+            void expireTimers();
+            void expireTimer(uint32_t timer, TimerWheel::clock_t::time_point now);
+            uint32_t keepaliveTimer() const;
+            std::chrono::microseconds retransmitTimeout(uint8_t retransmissions) const;
+            void recordResponse(uint16_t message_id, TimerWheel::clock_t::time_point now);
+            Recovery recoverMessage(std::exception_ptr error, uint16_t message_id);
+            void releaseCredit(Command& command);
 
         public:
 #ifdef EMB_SINGLE_THREADED
@@ -64,15 +214,28 @@ namespace emb
              * 
              * @param buffer Buffer for communication
              * @param init_timeout Time to keep retrying to establish a connection
+             * @param command_capacity Maximum number of commands waiting on the device, at most `32768`
              */
-            EmbMessenger(std::shared_ptr<shared::IBuffer> buffer, std::chrono::milliseconds init_timeout = std::chrono::seconds(10));
+            EmbMessenger(std::shared_ptr<shared::IBuffer> buffer, std::chrono::milliseconds init_timeout = std::chrono::seconds(10),
+                         size_t command_capacity = 256);
 
             /**
              * @brief Public update method for the Single Threaded EmbMessenger.
              * 
              * This should be called whenever a message has been received from the device or faster.
+             * Processes at most one message.
              */
             void update();
+
+            /**
+             * @brief Processes every message that has been received from the device so far.
+             *
+             * The commands are looked up and removed in one batch instead of once per message, so this keeps up with
+             * bursts from the device better than calling update in a loop.
+             *
+             * @return Number of messages processed
+             */
+            size_t updateAll();
 #else
             /**
              * @brief Constructor for the Multi Threaded EmbMessenger.
@@ -80,14 +243,19 @@ namespace emb
              * @param buffer Buffer for communication
              * @param exception_handler Handler for exceptions thrown in the update thread
              * @param init_timeout Time to keep retrying to establish a connection
+             * @param thread_options Options for the receive and transmit threads
+             * @param command_capacity Maximum number of commands waiting on the device, at most `32768`
              */
             EmbMessenger(std::shared_ptr<shared::IBuffer> buffer, std::function<bool(std::exception_ptr)> exception_handler,
-                         std::chrono::milliseconds init_timeout = std::chrono::seconds(10));
+                         std::chrono::milliseconds init_timeout = std::chrono::seconds(10),
+                         ThreadOptions thread_options = ThreadOptions(), size_t command_capacity = 256);
 
             /**
              * @brief Destructor for the Multi Threaded EmbMessenger.
              * 
              * Stops the update thread and joins it.
+             * The write thread finishes writing the queued messages before it is joined.
+             * Waits for the callbacks given to the executor to finish.
              */
             ~EmbMessenger();
 
@@ -104,6 +272,19 @@ namespace emb
              * Does not block, the update thread will stop after finishing its current loop.
              */
             void stop();
+
+            /**
+             * @brief Processes the messages received so far, one loop of the update thread.
+             *
+             * Only for the `ReceiveMode::External` EmbMessenger, which has no update thread. Call it from one thread at
+             * a time, whenever the buffer may have received data and often enough to expire the timers. Exceptions go
+             * to the exception handler like in the update thread, if it returns `true` the EmbMessenger stops and
+             * this does nothing.
+             *
+             * @return Number of messages processed, plus one if an exception was handled
+             * @throws std::logic_error If the EmbMessenger has an update thread
+             */
+            size_t poll();
 #endif
 
             /**
@@ -118,13 +299,55 @@ namespace emb
                 static_assert(!std::is_same<Command, CommandType>::value, "You can't register the base class Command.");
                 static_assert(std::is_base_of<Command, CommandType>::value, "Ensure CommandType is derived from Command.");
                 m_command_ids.emplace(typeid(CommandType), id);
+                m_metrics.addCommand(id);
             }
 
+            /**
+             * @brief Create a command using the messenger's command pool.
+             *
+             * The memory of the command is recycled once every reference to it is gone,
+             * so creating commands this way doesn't allocate once the pool has warmed up.
+             * The type index of the command is set.
+             *
+             * @tparam CommandType The Command type
+             * @tparam Args Types of the constructor arguments
+             * @param args Arguments for the constructor of the command
+             * @return std::shared_ptr<CommandType> The new command
+             */
+            template <typename CommandType, typename... Args>
+            std::shared_ptr<CommandType> makeCommand(Args&&... args)
+            {
+                static_assert(std::is_base_of<Command, CommandType>::value, "Ensure CommandType is derived from Command.");
+                std::shared_ptr<CommandType> command = std::allocate_shared<CommandType>(
+                    PoolAllocator<CommandType>(m_command_pool), std::forward<Args>(args)...);
+                command->m_type_index = typeid(CommandType);
+                return command;
+            }
+
+            /**
+             * @brief Get the pool used by makeCommand.
+             *
+             * @return The messenger's command pool
+             */
+            std::shared_ptr<CommandPool> getCommandPool() const;
+
+            /**
+             * @brief Gets the buffer used for communication.
+             *
+             * @return The buffer
+             */
+            std::shared_ptr<shared::IBuffer> getBuffer() const;
+
             /**
              * @brief Send a command to the device.
              * 
+             * Safe to call from multiple threads at once in the Multi Threaded EmbMessenger. The command is encoded on
+             * the calling thread and the message is written to the buffer by the write thread. A command whose last
+             * callback is still running on the executor is sent once that callback returns.
+             * 
              * @param command Command to send
              * @return std::shared_ptr<Command> Command sent to the device
+             * @throws FrameTooLarge If the message is longer than `Frame::kMaxFrameSize`
              */
             std::shared_ptr<Command> send(std::shared_ptr<Command> command);
 
@@ -150,6 +373,40 @@ namespace emb
              */
             std::shared_ptr<Command> send(std::shared_ptr<Command> command, uint16_t commandId);
 
+            /**
+             * @brief Send a command to every device on the bus, without waiting for responses.
+             *
+             * Only for an EmbMessenger whose buffer is on a bus, see BusRouter. Any EmbMessenger on the bus can
+             * broadcast, the message goes out in order with its own messages but not with the others'. The devices
+             * don't respond, so the command's state, callback and receive aren't used and it can be broadcast again
+             * right away.
+             *
+             * @param command Command to send
+             * @throws std::logic_error If the buffer isn't on a bus
+             * @throws FrameTooLarge If the message is longer than `Frame::kMaxFrameSize`
+             */
+            void broadcast(std::shared_ptr<Command> command);
+
+            /**
+             * @brief Send a command to every device on the bus, without waiting for responses.
+             *
+             * @param command Command to send
+             */
+            template <typename CommandType>
+            void broadcast(std::shared_ptr<CommandType> command)
+            {
+                command->m_type_index = typeid(CommandType);
+                broadcast(std::static_pointer_cast<Command>(command));
+            }
+
+            /**
+             * @brief Send a command to every device on the bus, without waiting for responses.
+             *
+             * @param command Command to send
+             * @param commandId Id of the Command to send
+             */
+            void broadcast(std::shared_ptr<Command> command, uint16_t commandId);
+
             /**
              * @brief Send a command to the device.
              *
@@ -163,6 +420,31 @@ namespace emb
                 return std::static_pointer_cast<CommandType>(send(std::static_pointer_cast<Command>(command), commandId));
             }
 
+            /**
+             * @brief Send a command to the device without blocking.
+             *
+             * @param command Command to send
+             * @return CommandFuture<CommandType> Future for the response from the device
+             */
+            template <typename CommandType>
+            CommandFuture<CommandType> sendAsync(std::shared_ptr<CommandType> command)
+            {
+                return CommandFuture<CommandType>(send(command));
+            }
+
+            /**
+             * @brief Send a command to the device without blocking.
+             *
+             * @param command Command to send
+             * @param commandId Id of the Command to send
+             * @return CommandFuture<CommandType> Future for the response from the device
+             */
+            template <typename CommandType>
+            CommandFuture<CommandType> sendAsync(std::shared_ptr<CommandType> command, uint16_t commandId)
+            {
+                return CommandFuture<CommandType>(send(command, commandId));
+            }
+
             /**
              * @brief Use in Command::send to write values to the device.
              * 
@@ -174,7 +456,7 @@ namespace emb
             template <typename T, typename... Ts>
             void write(const T arg, Ts... args)
             {
-                m_writer.write(arg);
+                frameWriter().write(arg);
                 write(args...);
             }
 
@@ -205,6 +487,75 @@ namespace emb
              */
             bool commandsReceived();
 
+            /**
+             * @brief Set the executor that runs the command callbacks.
+             *
+             * By default callbacks run on the update thread, so a slow callback holds up parsing the messages from
+             * the device. With an executor, the update thread hands the callbacks off and moves on.
+             * The callbacks of one command are given the same key and run in order.
+             * In the Multi Threaded EmbMessenger, exceptions thrown by callbacks are passed to the exception handler.
+             * A sample of a periodic command that arrives while the previous sample's callback is still running is
+             * dropped, see droppedSamples. Any other message waits for the command's callback before being parsed.
+             * The callbacks of the messenger's own commands always run on the update thread.
+             *
+             * @param executor Executor for the callbacks, `nullptr` to run them on the update thread
+             */
+            void setExecutor(std::shared_ptr<IExecutor> executor);
+
+#ifndef EMB_SINGLE_THREADED
+            /**
+             * @brief Gets the number of periodic samples dropped because their command's callback was still running.
+             *
+             * @return Number of dropped samples
+             */
+            size_t droppedSamples() const;
+#endif
+
+            /**
+             * @brief Turns on the completion queue.
+             *
+             * Every command that receives a message from the device afterwards, including each sample of a periodic
+             * command, is also pushed to the completion queue. Drain it with pollCompletions.
+             * Callbacks and waiting threads are still notified as usual.
+             * Can only be enabled once.
+             *
+             * @param capacity Maximum number of completions waiting to be polled, rounded up to a power of two
+             */
+            void enableCompletionQueue(size_t capacity = 256);
+
+            /**
+             * @brief Takes a batch of completions off the completion queue.
+             *
+             * Only one thread may poll at a time. In the Multi Threaded EmbMessenger this doesn't block the update
+             * thread.
+             * A periodic command is pushed once per sample, but its values are those of the latest sample when read.
+             *
+             * @param completions Array to move the completions into
+             * @param max Maximum number of completions to take
+             * @return Number of completions taken, `0` if the completion queue isn't enabled
+             */
+            size_t pollCompletions(Completion* completions, size_t max);
+
+            /**
+             * @brief Takes a batch of completions off the completion queue.
+             *
+             * @tparam N Size of the array
+             * @param completions Array to move the completions into
+             * @return Number of completions taken, `0` if the completion queue isn't enabled
+             */
+            template <size_t N>
+            size_t pollCompletions(Completion (&completions)[N])
+            {
+                return pollCompletions(completions, N);
+            }
+
+            /**
+             * @brief Gets the number of completions that were dropped because the completion queue was full.
+             *
+             * @return Number of dropped completions
+             */
+            size_t droppedCompletions() const;
+
         protected:
             class ResetCommand : public Command
             {
@@ -216,9 +567,10 @@ namespace emb
             {
                 uint16_t m_command_id;
                 uint32_t m_period;
+                std::shared_ptr<Command> m_periodic_command;
 
             public:
-                RegisterPeriodicCommand(uint16_t commandId, uint32_t period);
+                RegisterPeriodicCommand(uint16_t commandId, uint32_t period, std::shared_ptr<Command> periodicCommand);
 
                 virtual void send(EmbMessenger* messenger);
             };
@@ -236,7 +588,175 @@ namespace emb
                 virtual void receive(EmbMessenger* messenger);
             };
 
+            class BufferCapacityCommand : public Command
+            {
+            public:
+                uint16_t m_capacity = 0;
+
+                BufferCapacityCommand();
+
+                virtual void receive(EmbMessenger* messenger);
+            };
+
+            // Asks for the buffer capacity too, it's harmless for the device to answer
+            class KeepaliveCommand : public BufferCapacityCommand
+            {
+            public:
+                KeepaliveCommand();
+            };
+
         public:
+            /**
+             * @brief Sets how long commands wait for the device to respond before they fail with CommandTimeout.
+             *
+             * The deadline starts once the message is written, or queued on flow control credit. When it passes the
+             * command is removed, anybody waiting on it is woken and the timeout is thrown from update like any other
+             * error. Deadlines are kept in a timer wheel with a 1 ms tick, so a timeout fires within a tick of the
+             * deadline plus the time until the next update. Periodic commands only have a deadline for their first
+             * response.
+             *
+             * @param timeout Time to wait for a response, `0` to wait forever
+             */
+            void setDefaultTimeout(std::chrono::milliseconds timeout);
+
+            /**
+             * @brief Retransmit messages the device doesn't respond to.
+             *
+             * A copy of every message sent afterwards is kept until the device responds. If the response doesn't
+             * arrive within @p timeout, or the device reports the message's CRC was invalid, the message is sent again
+             * with the same message ID. Once the retries run out the command fails with RetriesExhausted.
+             * Corrupted responses and responses to commands that already completed are dropped silently.
+             *
+             * Once round trips have been measured, the retransmission timeout follows the smoothed round trip time and
+             * its variance instead of @p timeout, see getLinkStats. Each retransmission of a message doubles it.
+             *
+             * Pair this with a device that remembers recent messages (the `RecentMessages` template parameter), so it
+             * doesn't execute a message twice when only the response was lost. When the device reports a duplicate,
+             * idempotent commands (see setIdempotent) are sent again with a new message ID, other commands fail with
+             * DuplicateMessage.
+             * The timeout should be longer than messages wait on flow control.
+             *
+             * @param timeout Time to wait for a response before retransmitting, until round trips have been measured
+             * @param retries Number of times to retransmit a message
+             */
+            void enableRetransmission(std::chrono::milliseconds timeout, uint8_t retries = 3);
+
+            /**
+             * @brief Mark a command type as safe to execute more than once.
+             *
+             * Call before sending commands, like registerCommand.
+             *
+             * @tparam CommandType The Command type
+             * @param idempotent True if executing the command twice has the same effect as executing it once
+             */
+            template <typename CommandType>
+            void setIdempotent(bool idempotent = true)
+            {
+                if (idempotent)
+                {
+                    m_idempotent_commands.insert(typeid(CommandType));
+                }
+                else
+                {
+                    m_idempotent_commands.erase(typeid(CommandType));
+                }
+            }
+
+            /**
+             * @brief Pings the device when the link has been idle for a while.
+             *
+             * When nothing has been sent to or received from the device for @p interval, a keepalive is sent. Its
+             * round trip feeds the RTT estimate like any other message. Keepalives the device doesn't answer within
+             * @p interval are counted in getLinkStats, they aren't reported as errors.
+             *
+             * @param interval Idle time before pinging the device, `0` to stop pinging
+             */
+            void enableKeepalive(std::chrono::milliseconds interval);
+
+            /**
+             * @brief Gets the round trip time estimate and health counters of the link to the device.
+             *
+             * The round trip time is measured from writing a message to processing its response. Retransmitted
+             * messages aren't measured.
+             *
+             * @return Snapshot of the link's health
+             */
+            LinkStats getLinkStats();
+
+            /**
+             * @brief Gets the number of messages that were retransmitted or resent.
+             *
+             * @return Number of retransmissions
+             */
+            size_t retransmissions() const;
+
+            /**
+             * @brief Gets the traffic counters, error counts, queue depths and round trip time histograms.
+             *
+             * The counters are kept with relaxed atomics as messages are sent and received, taking a snapshot doesn't
+             * hold up either. The round trip times are measured like those in getLinkStats, per command ID.
+             * Errors are counted as they are thrown from update, or passed to the exception handler by the update
+             * thread.
+             *
+             * @return Snapshot of the metrics
+             */
+            MetricsSnapshot snapshot();
+
+#ifdef EMB_TRACING
+            /**
+             * @brief Set the tracer whose hooks are called as messages are sent and received.
+             *
+             * Only available when built with EMB_TRACING, without it the hooks are compiled out entirely.
+             * The messenger keeps the tracers it is given alive until it is destroyed.
+             *
+             * @param tracer Tracer to call, `nullptr` to stop tracing
+             */
+            void setTracer(std::shared_ptr<ITracer> tracer);
+#endif
+
+            /**
+             * @brief Limit the data sent to the device that it hasn't responded to yet.
+             *
+             * A message takes up room in the device's buffer until the device responds to it. With a window, sending
+             * a message that doesn't fit waits for the device to respond to earlier messages. A message is always
+             * allowed when nothing is in flight, even if it is bigger than the window.
+             * In the Multi Threaded EmbMessenger `send` blocks until the message fits, except when called from the
+             * update thread, e.g. from a callback. In the Single Threaded EmbMessenger the message is queued and
+             * written during `update` once it fits.
+             *
+             * @param bytes Maximum number of bytes in flight, `0` for no limit
+             * @param messages Maximum number of messages in flight, `0` for no limit
+             */
+            void setFlowControlWindow(size_t bytes, size_t messages = 0);
+
+            /**
+             * @brief Ask the device for the capacity of its buffer and use it as the flow control window.
+             *
+             * Blocks until the device responds in the Multi Threaded EmbMessenger. In the Single Threaded EmbMessenger
+             * the window is set once `update` receives the response.
+             *
+             * @param messages Maximum number of messages in flight, `0` for no limit
+             */
+            void negotiateFlowControl(size_t messages = 0);
+
+            /**
+             * @brief Gets the number of bytes sent to the device that it hasn't responded to yet.
+             *
+             * Only counted while flow control is enabled.
+             *
+             * @return Number of bytes in flight
+             */
+            size_t bytesInFlight();
+
+            /**
+             * @brief Gets the number of messages sent to the device that it hasn't responded to yet.
+             *
+             * Only counted while flow control is enabled.
+             *
+             * @return Number of messages in flight
+             */
+            size_t messagesInFlight();
+
             /**
              * @brief Send the Reset command to the device.
              * 
@@ -256,18 +776,19 @@ namespace emb
             template <typename CommandType, typename CallbackType>
             std::shared_ptr<CommandType> registerPeriodicCommand(uint32_t period, CallbackType callback)
             {
-                std::shared_ptr<CommandType> periodic_command = std::make_shared<CommandType>();
+                std::shared_ptr<CommandType> periodic_command = makeCommand<CommandType>();
                 periodic_command->m_is_periodic = true;
                 periodic_command->template setCallback<CommandType>(callback);
-                periodic_command->m_message_id = m_message_id;
 
-                std::shared_ptr<RegisterPeriodicCommand> registerCommand =
-                    std::make_shared<RegisterPeriodicCommand>(m_command_ids.at(typeid(CommandType)), period);
-                registerCommand->setCallback<RegisterPeriodicCommand>([=](auto&& registerCommand) {
+                // The periodic command takes over the message ID of the register command, it is set when the register
+                // command is sent
+                std::shared_ptr<RegisterPeriodicCommand> registerCommand = makeCommand<RegisterPeriodicCommand>(
+                    m_command_ids.at(typeid(CommandType)), period, periodic_command);
+                registerCommand->setCallback<RegisterPeriodicCommand>([this, periodic_command](auto&&) {
 #ifndef EMB_SINGLE_THREADED
                     std::lock_guard<std::mutex> lock(m_commands_mutex);
 #endif
-                    m_commands[periodic_command->getMessageId()] = periodic_command;
+                    m_commands.assign(periodic_command->getMessageId(), periodic_command);
                 });
                 send(registerCommand);
 
@@ -287,7 +808,7 @@ namespace emb
             void unregisterPeriodicCommand()
             {
                 std::shared_ptr<UnregisterPeriodicCommand> unregisterCommand =
-                    std::make_shared<UnregisterPeriodicCommand>(m_command_ids.at(typeid(CommandType)));
+                    makeCommand<UnregisterPeriodicCommand>(m_command_ids.at(typeid(CommandType)));
                 unregisterCommand->setCallback<UnregisterPeriodicCommand>([=](auto&& unregisterCommand) {
 #ifndef EMB_SINGLE_THREADED
                     std::lock_guard<std::mutex> lock(m_commands_mutex);
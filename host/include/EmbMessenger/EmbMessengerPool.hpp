@@ -0,0 +1,145 @@
+#ifndef EMBMESSENGER_EMBMESSENGERPOOL_HPP
+#define EMBMESSENGER_EMBMESSENGERPOOL_HPP
+
+#if !defined(EMB_SINGLE_THREADED) && defined(__linux__)
+
+#include "EmbMessenger/EmbMessenger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Options for the threads of an EmbMessengerPool.
+         */
+        struct PoolOptions
+        {
+            size_t threads = 2;  /// Number of reactor threads, at least 1
+
+            /// Time between polls of every messenger, for buffers without a file descriptor and for the timers
+            std::chrono::microseconds tick{ std::chrono::milliseconds(1) };
+
+            const char* name = "emb-pool";  /// Name of the reactor threads, at most 15 characters
+        };
+
+        /**
+         * @brief Runs the receive side of many Multi Threaded EmbMessengers on a few reactor threads.
+         *
+         * The messengers are constructed with `ReceiveMode::External`, and preferably `TransmitMode::Inline`, so they
+         * have no threads of their own. The reactor threads wait on epoll for the buffers that implement IPollable and
+         * poll every messenger each tick. A messenger with work is queued on the thread that noticed it, idle threads
+         * steal from the others' queues. A messenger is only ever polled by one thread at a time, so its callbacks
+         * still run one after the other in the order of its messages.
+         *
+         * Only available on Linux.
+         */
+        class EmbMessengerPool
+        {
+            enum class State
+            {
+                Idle,          // Waiting for data or the tick
+                Queued,        // In a worker's queue
+                Running,       // Being polled
+                RunningAgain,  // Being polled and got more data meanwhile
+                Stopped,       // Its exception handler stopped it
+                Removed
+            };
+
+            struct Entry
+            {
+                std::shared_ptr<EmbMessenger> messenger;
+                int fd;
+                uint64_t id;
+                std::atomic<State> state;
+                std::atomic_bool removed;  // Set by remove, the thread polling it doesn't queue it again
+            };
+
+            struct Worker
+            {
+                std::mutex mutex;
+                std::deque<std::shared_ptr<Entry>> queue;
+                std::thread thread;
+            };
+
+            std::vector<std::unique_ptr<Worker>> m_workers;
+
+            mutable std::mutex m_entries_mutex;
+            std::unordered_map<uint64_t, std::shared_ptr<Entry>> m_entries;
+            uint64_t m_next_id;
+
+            int m_epoll;
+            int m_timer;  // Tick, armed one shot so only one thread handles it
+            int m_wake;   // Wakes one idle thread to steal work
+            int m_stop;   // Wakes every thread to stop
+            std::atomic_bool m_running;
+
+            void work(size_t index);
+            void handleEvent(size_t index, uint64_t id);
+            void schedule(size_t index, const std::shared_ptr<Entry>& entry);
+            std::shared_ptr<Entry> take(size_t index);
+            void run(size_t index, const std::shared_ptr<Entry>& entry);
+            void rearm(int fd, uint64_t id);
+            void closeAll();
+
+        public:
+            /**
+             * @brief Construct a new EmbMessenger Pool and start its threads.
+             *
+             * @param options Number of threads and tick
+             * @throws std::invalid_argument If there are no threads or the tick isn't positive
+             * @throws std::system_error If epoll can't be set up
+             */
+            explicit EmbMessengerPool(PoolOptions options = PoolOptions());
+
+            /**
+             * @brief Destroy the EmbMessenger Pool.
+             *
+             * Joins the threads, then releases the messengers still in the pool.
+             */
+            ~EmbMessengerPool();
+
+            EmbMessengerPool(const EmbMessengerPool&) = delete;
+            EmbMessengerPool& operator=(const EmbMessengerPool&) = delete;
+
+            /**
+             * @brief Adds a messenger, it is polled from the next tick or when its buffer gets data.
+             *
+             * @param messenger A messenger constructed with `ReceiveMode::External`
+             * @throws std::system_error If its file descriptor can't be added to epoll
+             */
+            void add(std::shared_ptr<EmbMessenger> messenger);
+
+            /**
+             * @brief Removes a messenger, waiting for a thread that is polling it to finish.
+             *
+             * Don't call it from the callbacks of the messenger being removed.
+             *
+             * @param messenger The messenger
+             * @return `true` if the messenger was in the pool
+             */
+            bool remove(const std::shared_ptr<EmbMessenger>& messenger);
+
+            /**
+             * @brief Gets the number of messengers in the pool.
+             *
+             * @return Number of messengers, including those stopped by their exception handler
+             */
+            size_t size() const;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // !EMB_SINGLE_THREADED && __linux__
+
+#endif  // EMBMESSENGER_EMBMESSENGERPOOL_HPP
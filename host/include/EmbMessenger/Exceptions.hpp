@@ -1,6 +1,8 @@
 #ifndef EMBMESSENGER_EXCEPTIONS_HPP
 #define EMBMESSENGER_EXCEPTIONS_HPP
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <stdexcept>
 #include <string>
@@ -16,6 +18,19 @@
              std::shared_ptr<emb::host::Command> command = nullptr) :                                               \
             emb::host::BaseException(source, #name ": " + message, command)                                         \
         {                                                                                                           \
+        }                                                                                                           \
+                                                                                                                    \
+        /** @brief Get the name of the exception. @return Name of the exception */                                  \
+        const char* getName() const override                                                                        \
+        {                                                                                                           \
+            return #name;                                                                                           \
+        }                                                                                                           \
+                                                                                                                    \
+        /** @brief Get the index of the exception type. @return Index of the exception type */                     \
+        size_t getTypeIndex() const override                                                                        \
+        {                                                                                                           \
+            static const size_t index = nextTypeIndex();                                                            \
+            return index;                                                                                           \
         }                                                                                                           \
     };
 
@@ -28,6 +43,19 @@
         name(const std::string& message = "", std::shared_ptr<emb::host::Command> command = nullptr) :  \
             emb::host::BaseException(emb::host::ExceptionSource::source, #name ": " + message, command) \
         {                                                                                               \
+        }                                                                                               \
+                                                                                                        \
+        /** @brief Get the name of the exception. @return Name of the exception */                      \
+        const char* getName() const override                                                            \
+        {                                                                                               \
+            return #name;                                                                               \
+        }                                                                                               \
+                                                                                                        \
+        /** @brief Get the index of the exception type. @return Index of the exception type */         \
+        size_t getTypeIndex() const override                                                            \
+        {                                                                                               \
+            static const size_t index = nextTypeIndex();                                                \
+            return index;                                                                               \
         }                                                                                               \
     };
 
@@ -89,6 +117,42 @@ namespace emb
             {
                 return m_source;
             }
+
+            /**
+             * @brief Get the name of the exception, e.g. `"CommandTimeout"`.
+             *
+             * @return Name of the exception
+             */
+            virtual const char* getName() const
+            {
+                return "BaseException";
+            }
+
+            /**
+             * @brief Get the index of the exception type.
+             *
+             * Each exception type is given the next index the first time it is asked for, so the errors can be counted
+             * in an array rather than by name.
+             *
+             * @return Index of the exception type
+             */
+            virtual size_t getTypeIndex() const
+            {
+                static const size_t index = nextTypeIndex();
+                return index;
+            }
+
+        protected:
+            /**
+             * @brief Allocates the index of an exception type, see getTypeIndex.
+             *
+             * @return The next unused index
+             */
+            static size_t nextTypeIndex()
+            {
+                static std::atomic<size_t> next(0);
+                return next.fetch_add(1, std::memory_order_relaxed);
+            }
         };
 
         /**
@@ -126,6 +190,17 @@ namespace emb
             {
                 return m_parameter_index;
             }
+
+            const char* getName() const override
+            {
+                return "ParameterReadError";
+            }
+
+            size_t getTypeIndex() const override
+            {
+                static const size_t index = nextTypeIndex();
+                return index;
+            }
         };
 
         /**
@@ -161,6 +236,17 @@ namespace emb
             {
                 return m_parameter_index;
             }
+
+            const char* getName() const override
+            {
+                return "ParameterInvalid";
+            }
+
+            size_t getTypeIndex() const override
+            {
+                static const size_t index = nextTypeIndex();
+                return index;
+            }
         };
 
         /**
@@ -221,6 +307,41 @@ namespace emb
          */
         NEW_EMB_EX_SOURCE(UnregisteredCommand, Host);
 
+        /**
+         * @brief Exception for when the host is Out of Command Slots.
+         *
+         * Occurs when too many commands are waiting on messages from the device.
+         */
+        NEW_EMB_EX_SOURCE(OutOfCommandSlots, Host);
+
+        /**
+         * @brief Exception for a Frame that is Too Large.
+         *
+         * Occurs when a command writes more parameters than fit in one message.
+         */
+        NEW_EMB_EX_SOURCE(FrameTooLarge, Host);
+
+        /**
+         * @brief Exception for a Command that Timed Out.
+         *
+         * The device didn't respond to the command before its deadline.
+         */
+        NEW_EMB_EX_SOURCE(CommandTimeout, Host);
+
+        /**
+         * @brief Exception for when the Retries of a command are Exhausted.
+         *
+         * The device didn't respond to the command, even after retransmitting it.
+         */
+        NEW_EMB_EX_SOURCE(RetriesExhausted, Host);
+
+        /**
+         * @brief Exception for a Command that has not been Received.
+         *
+         * Occurs when the result of a CommandFuture is requested before the device responded.
+         */
+        NEW_EMB_EX_SOURCE(CommandNotReceived, Host);
+
         /**
          * @brief Exception for Command ID Read Error.
          * 
@@ -235,6 +356,14 @@ namespace emb
          */
         NEW_EMB_EX_SOURCE(CommandIdInvalid, Device);
 
+        /**
+         * @brief Exception for a Duplicate Message.
+         *
+         * The device already executed a retransmitted message, but its response was lost.
+         * The command isn't idempotent, so it can't safely be executed again.
+         */
+        NEW_EMB_EX_SOURCE(DuplicateMessage, Device);
+
         /**
          * @brief Exception for when the device is Out of Periodic Command Slots.
          * 
@@ -0,0 +1,73 @@
+#ifndef EMBMESSENGER_FRAME_HPP
+#define EMBMESSENGER_FRAME_HPP
+
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Fixed size buffer holding one encoded message.
+         *
+         * Commands are encoded into a frame before being written to the device, so a message is always written to
+         * the device's buffer in one piece.
+         * Bytes written past `kMaxFrameSize` are dropped and the frame is marked as overflowed.
+         */
+        class Frame : public shared::IBuffer
+        {
+        public:
+            static constexpr size_t kMaxFrameSize = 256;
+
+        private:
+            uint8_t m_data[kMaxFrameSize];
+            size_t m_size;
+            size_t m_read_index;
+            bool m_overflowed;
+
+        public:
+            Frame();
+
+            /**
+             * @brief Empties the frame.
+             */
+            void clear();
+
+            /**
+             * @brief Replaces the contents of the frame.
+             *
+             * @param data Bytes to copy into the frame
+             * @param size Number of bytes, at most `kMaxFrameSize`
+             */
+            void assign(const uint8_t* data, size_t size);
+
+            /**
+             * @brief Gets the unread bytes of the frame.
+             *
+             * @return Pointer to the first unread byte, there are `size()` of them
+             */
+            const uint8_t* data() const;
+
+            /**
+             * @brief Checks if more than `kMaxFrameSize` bytes were written to the frame.
+             *
+             * @return True if bytes were dropped
+             */
+            bool overflowed() const;
+
+            virtual void writeByte(const uint8_t byte) override;
+            virtual uint8_t peek() const override;
+            virtual uint8_t readByte() override;
+            virtual bool empty() const override;
+            virtual size_t size() const override;
+            virtual uint8_t messages() const override;
+            virtual void update() override;
+            virtual void zero() override;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_FRAME_HPP
@@ -0,0 +1,104 @@
+#ifndef EMBMESSENGER_FRAMEQUEUE_HPP
+#define EMBMESSENGER_FRAMEQUEUE_HPP
+
+#include "EmbMessenger/Frame.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Bounded lock free queue of frames, any number of threads may push and pop.
+         *
+         * Every slot holds a whole frame and is allocated up front, so queueing a frame is a copy into the slot.
+         * Each slot has a sequence number that tells the producers and consumers whose turn it is to use the slot.
+         */
+        class FrameQueue
+        {
+            struct Cell
+            {
+                std::atomic<size_t> sequence;
+                uint16_t size;
+                uint8_t data[Frame::kMaxFrameSize];
+            };
+
+            std::unique_ptr<Cell[]> m_cells;
+            size_t m_mask;
+
+            // The producer and consumer positions are kept on separate cache lines so the threads don't contend
+            char m_padding_front[64];
+            std::atomic<size_t> m_enqueue_position;
+            char m_padding_enqueue[64 - sizeof(std::atomic<size_t>)];
+            std::atomic<size_t> m_dequeue_position;
+            char m_padding_dequeue[64 - sizeof(std::atomic<size_t>)];
+
+        public:
+            /**
+             * @brief Construct a new Frame Queue.
+             *
+             * @param capacity Maximum number of frames in the queue, rounded up to a power of two
+             */
+            explicit FrameQueue(size_t capacity = 256);
+
+            FrameQueue(const FrameQueue&) = delete;
+            FrameQueue& operator=(const FrameQueue&) = delete;
+
+            /**
+             * @brief Copies the unread bytes of a frame into the queue.
+             *
+             * @param frame Frame to add
+             * @return False if the queue is full, the frame is not added
+             */
+            bool push(const Frame& frame);
+
+            /**
+             * @brief Takes the frame at the front of the queue.
+             *
+             * @param frame Frame to copy the bytes into
+             * @return False if the queue is empty
+             */
+            bool pop(Frame& frame);
+
+            /**
+             * @brief Gets the size of the frame at the front of the queue.
+             *
+             * Only reliable when there is a single consumer.
+             *
+             * @return Number of bytes in the front frame, `0` if the queue is empty
+             */
+            size_t frontSize() const;
+
+            /**
+             * @brief Checks if the queue is empty.
+             *
+             * Only a snapshot when other threads are using the queue.
+             *
+             * @return True if there is no frame to pop
+             */
+            bool empty() const;
+
+            /**
+             * @brief Gets the number of frames in the queue.
+             *
+             * Only a snapshot when other threads are using the queue, it includes frames that are still being pushed.
+             *
+             * @return Number of frames in the queue
+             */
+            size_t size() const;
+
+            /**
+             * @brief Gets the maximum number of frames the queue can hold.
+             *
+             * @return Capacity of the queue
+             */
+            size_t capacity() const;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_FRAMEQUEUE_HPP
@@ -0,0 +1,31 @@
+#ifndef EMBMESSENGER_IADDRESSABLE_HPP
+#define EMBMESSENGER_IADDRESSABLE_HPP
+
+#include <cstdint>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Interface for buffers to one device on a bus shared with other devices, like RS-485.
+         *
+         * Buffers implement it next to `shared::IBuffer`. An EmbMessenger using such a buffer starts its messages with
+         * the address and expects it at the start of the responses, see BusRouter.
+         */
+        class IAddressable
+        {
+        public:
+            virtual ~IAddressable() = default;
+
+            /**
+             * @brief Gets the address of the device the buffer is connected to.
+             *
+             * @return The address, any but `shared::kBroadcastAddress`
+             */
+            virtual uint8_t address() const = 0;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_IADDRESSABLE_HPP
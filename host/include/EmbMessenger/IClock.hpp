@@ -0,0 +1,88 @@
+#ifndef EMBMESSENGER_ICLOCK_HPP
+#define EMBMESSENGER_ICLOCK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Interface for the time used by simulations, so they can run on the wall clock or a virtual one.
+         */
+        class IClock
+        {
+        public:
+            virtual ~IClock() = default;
+
+            /**
+             * @brief Gets the current time.
+             *
+             * @return Time since the clock's epoch
+             */
+            virtual std::chrono::nanoseconds now() const = 0;
+        };
+
+        /**
+         * @brief Clock that follows `std::chrono::steady_clock`.
+         */
+        class SteadyClock : public IClock
+        {
+        public:
+            virtual std::chrono::nanoseconds now() const override
+            {
+                return std::chrono::steady_clock::now().time_since_epoch();
+            }
+        };
+
+        /**
+         * @brief Clock that only moves when it is told to.
+         *
+         * Simulations on a virtual clock are deterministic and run as fast as they can be computed.
+         */
+        class VirtualClock : public IClock
+        {
+            std::atomic<int64_t> m_now;
+
+        public:
+            /**
+             * @brief Construct a new Virtual Clock.
+             *
+             * @param start Time to start at
+             */
+            explicit VirtualClock(std::chrono::nanoseconds start = std::chrono::nanoseconds(0)) :
+                m_now(start.count())
+            {
+            }
+
+            virtual std::chrono::nanoseconds now() const override
+            {
+                return std::chrono::nanoseconds(m_now.load(std::memory_order_acquire));
+            }
+
+            /**
+             * @brief Moves the clock forward.
+             *
+             * @param duration Time to move forward by
+             */
+            void advance(std::chrono::nanoseconds duration)
+            {
+                m_now.fetch_add(duration.count(), std::memory_order_acq_rel);
+            }
+
+            /**
+             * @brief Sets the time.
+             *
+             * @param time The new time, it shouldn't be earlier than the current time
+             */
+            void set(std::chrono::nanoseconds time)
+            {
+                m_now.store(time.count(), std::memory_order_release);
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_ICLOCK_HPP
@@ -0,0 +1,44 @@
+#ifndef EMBMESSENGER_IEXECUTOR_HPP
+#define EMBMESSENGER_IEXECUTOR_HPP
+
+#include <cstdint>
+#include <functional>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Interface for running command callbacks off the update thread.
+         *
+         * Tasks with the same key must run one at a time, in the order they were given.
+         */
+        class IExecutor
+        {
+        public:
+            virtual ~IExecutor() = default;
+
+            /**
+             * @brief Runs the @p task, now or later.
+             *
+             * @param key Ordering key, the message ID of the command the task belongs to
+             * @param task Task to run
+             */
+            virtual void execute(uint16_t key, std::function<void()> task) = 0;
+        };
+
+        /**
+         * @brief Executor that runs tasks right away on the calling thread.
+         */
+        class InlineExecutor : public IExecutor
+        {
+        public:
+            virtual void execute(uint16_t /*key*/, std::function<void()> task) override
+            {
+                task();
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_IEXECUTOR_HPP
@@ -0,0 +1,29 @@
+#ifndef EMBMESSENGER_IPOLLABLE_HPP
+#define EMBMESSENGER_IPOLLABLE_HPP
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Interface for buffers backed by a file descriptor, like a serial port or a socket.
+         *
+         * Buffers implement it next to `shared::IBuffer` so an EmbMessengerPool can wait for their data with epoll
+         * instead of polling them.
+         */
+        class IPollable
+        {
+        public:
+            virtual ~IPollable() = default;
+
+            /**
+             * @brief Gets the file descriptor that becomes readable when the device sends data.
+             *
+             * @return The file descriptor, it must stay open while the buffer is in use
+             */
+            virtual int fileDescriptor() const = 0;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_IPOLLABLE_HPP
@@ -0,0 +1,140 @@
+#ifndef EMBMESSENGER_ITRACER_HPP
+#define EMBMESSENGER_ITRACER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+#ifdef EMB_TRACING
+#include <atomic>
+
+/**
+ * @brief Calls a hook of the tracer in the atomic pointer @p tracer, if it is set.
+ *
+ * Without EMB_TRACING this expands to nothing, the arguments aren't evaluated.
+ */
+#define EMB_TRACE(tracer, hook, ...)                                                                        \
+    do                                                                                                      \
+    {                                                                                                       \
+        emb::host::ITracer* emb_tracer = (tracer).load(std::memory_order_acquire);                          \
+        if (emb_tracer != nullptr)                                                                          \
+        {                                                                                                   \
+            emb_tracer->hook(std::chrono::duration_cast<std::chrono::nanoseconds>(                          \
+                                 std::chrono::steady_clock::now().time_since_epoch()),                      \
+                             __VA_ARGS__);                                                                  \
+        }                                                                                                   \
+    } while (0)
+#else
+#define EMB_TRACE(tracer, hook, ...) \
+    do                               \
+    {                                \
+    } while (0)
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        class Command;
+
+        /**
+         * @brief Interface for observing the lifecycle of messages and commands, see EmbMessenger::setTracer.
+         *
+         * The hooks are only called when the messenger is built with EMB_TRACING, otherwise they are compiled out.
+         * Each hook is given a steady clock timestamp in nanoseconds. Hooks run on the thread the event happened on,
+         * in the middle of sending or parsing, so they should be quick and must not call back into the messenger.
+         * The hooks do nothing by default, override the ones you need.
+         */
+        class ITracer
+        {
+        public:
+            virtual ~ITracer() = default;
+
+            /**
+             * @brief A command was encoded into a message, on the sending thread.
+             *
+             * @param time Timestamp of the event
+             * @param message_id Message ID of the message
+             * @param command_id Command ID of the command
+             * @param data Bytes of the message, only valid during the call
+             * @param size Number of bytes in the message
+             */
+            virtual void frameEncoded(std::chrono::nanoseconds /*time*/, uint16_t /*message_id*/,
+                                      uint16_t /*command_id*/, const uint8_t* /*data*/, size_t /*size*/)
+            {
+            }
+
+            /**
+             * @brief A message was written to the buffer, retransmissions included.
+             *
+             * @param time Timestamp of the event
+             * @param data Bytes of the message, only valid during the call
+             * @param size Number of bytes in the message
+             */
+            virtual void frameFlushed(std::chrono::nanoseconds /*time*/, const uint8_t* /*data*/, size_t /*size*/)
+            {
+            }
+
+            /**
+             * @brief The message ID of a message from the device was read.
+             *
+             * @param time Timestamp of the event
+             * @param message_id Message ID of the message
+             */
+            virtual void frameReceived(std::chrono::nanoseconds /*time*/, uint16_t /*message_id*/)
+            {
+            }
+
+            /**
+             * @brief A command read a message from the device and its CRC checked out.
+             *
+             * @param time Timestamp of the event
+             * @param message_id Message ID of the message
+             * @param command The command that read the message
+             */
+            virtual void decodeComplete(std::chrono::nanoseconds /*time*/, uint16_t /*message_id*/,
+                                        const Command& /*command*/)
+            {
+            }
+
+            /**
+             * @brief The callback of a command is about to run, on the thread that runs it.
+             *
+             * @param time Timestamp of the event
+             * @param message_id Message ID of the command
+             * @param command The command
+             */
+            virtual void callbackStart(std::chrono::nanoseconds /*time*/, uint16_t /*message_id*/,
+                                       const Command& /*command*/)
+            {
+            }
+
+            /**
+             * @brief The callback of a command finished.
+             *
+             * A callback on the update thread that throws ends with error instead.
+             *
+             * @param time Timestamp of the event
+             * @param message_id Message ID of the command
+             * @param command The command
+             */
+            virtual void callbackEnd(std::chrono::nanoseconds /*time*/, uint16_t /*message_id*/,
+                                     const Command& /*command*/)
+            {
+            }
+
+            /**
+             * @brief An error is about to be thrown from update, or passed to the exception handler.
+             *
+             * @param time Timestamp of the event
+             * @param error The error
+             */
+            virtual void error(std::chrono::nanoseconds /*time*/, std::exception_ptr /*error*/)
+            {
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_ITRACER_HPP
@@ -0,0 +1,175 @@
+#ifndef EMBMESSENGER_LINKEMULATOR_HPP
+#define EMBMESSENGER_LINKEMULATOR_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+#include "EmbMessenger/IClock.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief How one direction of an emulated link behaves.
+         */
+        struct LinkOptions
+        {
+            uint32_t bytes_per_second = 0;          /// Rate bytes go out at, `0` for unlimited. 8N1 sends baud / 10
+            std::chrono::nanoseconds latency{ 0 };  /// Delay from a byte leaving until it arrives
+            std::chrono::nanoseconds jitter{ 0 };   /// Random extra delay of up to this much, bytes stay in order
+            double drop_rate = 0;                   /// Probability of losing each byte
+            double bit_error_rate = 0;              /// Probability of flipping each bit
+            uint32_t seed = 1;                      /// Seed for the drops, bit flips and jitter
+        };
+
+        /**
+         * @brief A pair of connected buffers that behave like a serial link.
+         *
+         * Bytes written to one end take the time to go out at the link's rate, plus the latency and jitter, before
+         * the other end's update makes them available. They can be dropped or have bits flipped on the way. Time comes
+         * from an IClock, on a VirtualClock the link is deterministic for a given seed.
+         *
+         * The ends count messages by following the data types, like FrameSplitter, so a corrupted type byte can
+         * throw the count off just like it would on a real device.
+         */
+        class LinkEmulator
+        {
+        public:
+            /**
+             * @brief What happened to the bytes going one way.
+             */
+            struct Counters
+            {
+                uint64_t bytes = 0;      /// Bytes written
+                uint64_t dropped = 0;    /// Bytes lost
+                uint64_t corrupted = 0;  /// Bytes with at least one flipped bit
+            };
+
+        private:
+            // One direction of the link
+            class Channel
+            {
+                struct InFlight
+                {
+                    std::chrono::nanoseconds arrival;
+                    uint8_t byte;
+                };
+
+                LinkOptions m_options;
+                std::shared_ptr<IClock> m_clock;
+                std::mt19937 m_random;
+                std::chrono::nanoseconds m_byte_time;
+                std::chrono::nanoseconds m_line_free;
+                std::chrono::nanoseconds m_last_arrival;
+                std::deque<InFlight> m_in_flight;
+                Counters m_counters;
+#ifndef EMB_SINGLE_THREADED
+                mutable std::mutex m_mutex;
+#endif
+
+            public:
+                Channel(LinkOptions options, std::shared_ptr<IClock> clock);
+
+                void send(uint8_t byte);
+
+                template <typename F>
+                void receive(F&& deliver);
+
+                Counters counters() const;
+            };
+
+        public:
+            /**
+             * @brief One end of the link.
+             */
+            class End : public shared::IBuffer
+            {
+                std::shared_ptr<Channel> m_incoming;
+                std::shared_ptr<Channel> m_outgoing;
+
+                std::deque<uint8_t> m_received;
+                size_t m_messages;
+                FrameSplitter m_arrive_splitter;
+                FrameSplitter m_read_splitter;
+
+            public:
+                End(std::shared_ptr<Channel> incoming, std::shared_ptr<Channel> outgoing);
+
+                virtual void writeByte(const uint8_t byte) override;
+                virtual uint8_t peek() const override;
+                virtual uint8_t readByte() override;
+                virtual bool empty() const override;
+                virtual size_t size() const override;
+                virtual uint8_t messages() const override;
+                virtual void update() override;
+                virtual void zero() override;
+            };
+
+        private:
+            std::shared_ptr<Channel> m_to_device;
+            std::shared_ptr<Channel> m_to_host;
+            std::shared_ptr<End> m_host;
+            std::shared_ptr<End> m_device;
+
+        public:
+            /**
+             * @brief Construct a new Link Emulator that behaves the same both ways.
+             *
+             * @param options How the link behaves, the device to host direction uses the seed + 1
+             * @param clock Time for the link, defaults to the wall clock
+             */
+            explicit LinkEmulator(LinkOptions options, std::shared_ptr<IClock> clock = std::make_shared<SteadyClock>());
+
+            /**
+             * @brief Construct a new Link Emulator that behaves differently each way.
+             *
+             * @param host_to_device How the bytes written by the host travel
+             * @param device_to_host How the bytes written by the device travel
+             * @param clock Time for the link, defaults to the wall clock
+             */
+            LinkEmulator(LinkOptions host_to_device, LinkOptions device_to_host,
+                         std::shared_ptr<IClock> clock = std::make_shared<SteadyClock>());
+
+            /**
+             * @brief Gets the host's end of the link.
+             *
+             * @return Buffer for the host's EmbMessenger
+             */
+            std::shared_ptr<shared::IBuffer> host() const;
+
+            /**
+             * @brief Gets the device's end of the link.
+             *
+             * @return Buffer for the device's EmbMessenger
+             */
+            std::shared_ptr<shared::IBuffer> device() const;
+
+            /**
+             * @brief Gets what happened to the bytes the host wrote.
+             *
+             * @return Counters of the host to device direction
+             */
+            Counters hostToDevice() const;
+
+            /**
+             * @brief Gets what happened to the bytes the device wrote.
+             *
+             * @return Counters of the device to host direction
+             */
+            Counters deviceToHost() const;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_LINKEMULATOR_HPP
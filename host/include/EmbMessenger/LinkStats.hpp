@@ -0,0 +1,34 @@
+#ifndef EMBMESSENGER_LINKSTATS_HPP
+#define EMBMESSENGER_LINKSTATS_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Snapshot of the health of the link to the device, see EmbMessenger::getLinkStats.
+         */
+        struct LinkStats
+        {
+            std::chrono::microseconds smoothed_rtt{ 0 };            /// Smoothed round trip time
+            std::chrono::microseconds rtt_variance{ 0 };            /// Smoothed mean deviation of the round trip time
+            std::chrono::microseconds min_rtt{ 0 };                 /// Shortest round trip time measured
+            std::chrono::microseconds last_rtt{ 0 };                /// Last round trip time measured
+            std::chrono::microseconds retransmission_timeout{ 0 };  /// Current retransmission timeout
+            size_t rtt_samples = 0;                                 /// Number of round trips measured
+
+            size_t retransmissions = 0;  /// Messages retransmitted or resent
+            size_t timeouts = 0;         /// Commands that failed with CommandTimeout or RetriesExhausted
+
+            size_t keepalives_sent = 0;    /// Keepalive pings sent while the link was idle
+            size_t keepalives_missed = 0;  /// Keepalive pings the device didn't respond to in time
+
+            std::chrono::steady_clock::duration since_last_response{ 0 };  /// Time since the device last responded
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_LINKSTATS_HPP
@@ -0,0 +1,342 @@
+#ifndef EMBMESSENGER_METRICS_HPP
+#define EMBMESSENGER_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Counter that many threads can add to without contending.
+         *
+         * Each thread adds to one of a few shards, each on its own cache line. Reading the counter sums the shards.
+         */
+        class ShardedCounter
+        {
+        public:
+            static constexpr size_t kShards = 8;
+
+        private:
+            static constexpr size_t kCacheLineSize = 64;
+
+            struct Shard
+            {
+                std::atomic<uint64_t> value;
+                char padding[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+            };
+
+            Shard m_shards[kShards];
+
+            static size_t shardIndex();
+
+        public:
+            ShardedCounter();
+
+            ShardedCounter(const ShardedCounter&) = delete;
+            ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+            /**
+             * @brief Adds to the counter.
+             *
+             * @param count Amount to add
+             */
+            void add(uint64_t count = 1)
+            {
+                m_shards[shardIndex()].value.fetch_add(count, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Gets the value of the counter.
+             *
+             * Only a snapshot when other threads are adding to the counter.
+             *
+             * @return Sum of the shards
+             */
+            uint64_t load() const;
+        };
+
+        /**
+         * @brief Copy of a LatencyHistogram at one point in time.
+         *
+         * Latencies below 8 us have a bucket each, above that every power of two is split into 8 buckets, so a bucket
+         * is at most 12.5% wide. Latencies of 2^40 us and more all fall in the last bucket.
+         */
+        struct HistogramSnapshot
+        {
+            static constexpr size_t kSubBucketBits = 3;
+            static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+            static constexpr size_t kBuckets = (40 - kSubBucketBits + 1) * kSubBuckets;
+
+            std::array<uint64_t, kBuckets> counts{};  /// Number of latencies in each bucket
+            uint64_t count = 0;                       /// Number of latencies recorded
+            std::chrono::microseconds sum{ 0 };       /// Sum of the latencies recorded
+            std::chrono::microseconds min{ 0 };       /// Shortest latency recorded
+            std::chrono::microseconds max{ 0 };       /// Longest latency recorded
+
+            /**
+             * @brief Gets the bucket a latency falls in.
+             *
+             * @param latency Latency in microseconds
+             * @return Index of the bucket
+             */
+            static size_t bucket(uint64_t latency);
+
+            /**
+             * @brief Gets the longest latency that falls in a bucket.
+             *
+             * @param bucket Index of the bucket
+             * @return Upper bound of the bucket in microseconds
+             */
+            static uint64_t bucketUpperBound(size_t bucket);
+
+            /**
+             * @brief Gets the mean of the latencies recorded.
+             *
+             * @return Mean latency, `0` if nothing was recorded
+             */
+            std::chrono::microseconds mean() const;
+
+            /**
+             * @brief Gets the latency that @p percentile percent of the latencies recorded are at or below.
+             *
+             * Accurate to the width of the bucket the latency falls in, the upper bound of the bucket is returned.
+             * The 0th percentile is the shortest latency recorded.
+             *
+             * @param percentile Percentile from `0` to `100`
+             * @return Latency at the percentile, `0` if nothing was recorded
+             */
+            std::chrono::microseconds percentile(double percentile) const;
+        };
+
+        /**
+         * @brief Histogram of latencies with logarithmic buckets, see HistogramSnapshot.
+         *
+         * Recording is a handful of relaxed atomic operations and never allocates. It is meant to be recorded from
+         * one thread, reading a snapshot is safe from any thread.
+         */
+        class LatencyHistogram
+        {
+            std::array<std::atomic<uint64_t>, HistogramSnapshot::kBuckets> m_counts;
+            std::atomic<uint64_t> m_sum;
+            std::atomic<uint64_t> m_min;
+            std::atomic<uint64_t> m_max;
+
+        public:
+            LatencyHistogram();
+
+            LatencyHistogram(const LatencyHistogram&) = delete;
+            LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+            /**
+             * @brief Adds a latency to the histogram.
+             *
+             * @param latency Latency to add, negative latencies are counted as `0`
+             */
+            void record(std::chrono::microseconds latency);
+
+            /**
+             * @brief Copies the histogram.
+             *
+             * The counts are read one at a time, a latency recorded meanwhile may only be partly included.
+             *
+             * @return Snapshot of the histogram
+             */
+            HistogramSnapshot snapshot() const;
+        };
+
+        /**
+         * @brief Snapshot of the metrics of an EmbMessenger, see EmbMessenger::snapshot.
+         */
+        struct MetricsSnapshot
+        {
+            std::chrono::steady_clock::duration uptime{ 0 };  /// Time since the messenger was constructed
+
+            uint64_t tx_bytes = 0;   /// Bytes written to the buffer, retransmissions included
+            uint64_t tx_frames = 0;  /// Messages written to the buffer, retransmissions included
+            uint64_t rx_bytes = 0;   /// Bytes read from the buffer
+            uint64_t rx_frames = 0;  /// Messages read from the buffer
+
+            uint64_t crc_failures = 0;         /// Messages from the device that failed the CRC check on the host
+            uint64_t device_crc_failures = 0;  /// Messages the device reported failed the CRC check on the device
+
+            std::map<std::string, uint64_t> errors;  /// Errors thrown while processing messages, by exception name
+
+            size_t pending_commands = 0;    /// Commands waiting on a message from the device, periodic ones included
+            size_t queued_frames = 0;       /// Messages waiting for the write thread or flow control credit
+            size_t queued_completions = 0;  /// Completions waiting to be polled
+            size_t pending_callbacks = 0;   /// Callbacks handed to the executor that haven't finished
+
+            std::map<uint16_t, HistogramSnapshot> command_rtt;  /// Round trip times by command ID, once measured
+
+            /**
+             * @brief Gets the rate of one of the counters between two snapshots.
+             *
+             * e.g. `now.rate(&MetricsSnapshot::tx_bytes, before)` for the bytes sent per second.
+             * Compare to a default constructed snapshot for the average since the messenger was constructed.
+             *
+             * @param counter Counter to get the rate of
+             * @param previous Earlier snapshot of the same messenger
+             * @return Change of the counter per second, `0` if no time passed
+             */
+            double rate(uint64_t MetricsSnapshot::*counter, const MetricsSnapshot& previous) const
+            {
+                double seconds = std::chrono::duration<double>(uptime - previous.uptime).count();
+                if (seconds <= 0)
+                {
+                    return 0;
+                }
+                return static_cast<double>(this->*counter - previous.*counter) / seconds;
+            }
+        };
+
+        /**
+         * @brief Counters and round trip time histograms kept by the EmbMessenger.
+         *
+         * The counters are sharded relaxed atomics so the sending threads don't contend on them. The errors are
+         * counted in an array indexed by exception type, see BaseException::getTypeIndex, and the histograms are looked
+         * up by command ID without a lock.
+         */
+        class Metrics
+        {
+        public:
+            static constexpr size_t kErrorTypes = 64;
+
+        private:
+            static constexpr size_t kRttBlockSize = 256;
+
+            // The histograms of 256 consecutive command IDs
+            struct RttBlock
+            {
+                std::array<std::atomic<LatencyHistogram*>, kRttBlockSize> histograms;
+            };
+
+            std::chrono::steady_clock::time_point m_start;
+
+            ShardedCounter m_tx_bytes;
+            ShardedCounter m_tx_frames;
+            ShardedCounter m_rx_bytes;
+            ShardedCounter m_rx_frames;
+            ShardedCounter m_crc_failures;
+            ShardedCounter m_device_crc_failures;
+
+            // Indexed by the high byte of the command ID, then the low byte. Commands may be registered while the
+            // update thread records round trip times, the blocks and histograms are published with release stores
+            // and never removed, so they are recorded to without a lock.
+            std::array<std::atomic<RttBlock*>, 0x10000 / kRttBlockSize> m_command_rtt;
+
+            // Own the blocks and histograms, only changed and read under m_command_rtt_mutex
+            std::vector<std::unique_ptr<RttBlock>> m_rtt_blocks;
+            std::map<uint16_t, std::unique_ptr<LatencyHistogram>> m_rtt_histograms;
+
+#ifndef EMB_SINGLE_THREADED
+            mutable std::mutex m_command_rtt_mutex;
+#endif
+
+            // By exception type, with the name of each type once it was counted
+            std::array<std::atomic<uint64_t>, kErrorTypes> m_errors;
+            std::array<std::atomic<const char*>, kErrorTypes> m_error_names;
+            std::atomic<uint64_t> m_other_errors;
+            std::atomic<uint64_t> m_std_errors;
+            std::atomic<uint64_t> m_unknown_errors;
+
+        public:
+            Metrics();
+
+            /**
+             * @brief Adds a round trip time histogram for a command ID.
+             *
+             * @param command_id ID of the command
+             */
+            void addCommand(uint16_t command_id);
+
+            /**
+             * @brief Counts a message written to the buffer.
+             *
+             * @param bytes Length of the message
+             */
+            void countTransmitted(size_t bytes)
+            {
+                m_tx_bytes.add(bytes);
+                m_tx_frames.add();
+            }
+
+            /**
+             * @brief Counts a message read from the buffer.
+             */
+            void countReceivedFrame()
+            {
+                m_rx_frames.add();
+            }
+
+            /**
+             * @brief Counts bytes read from the buffer.
+             *
+             * @param bytes Number of bytes
+             */
+            void countReceivedBytes(size_t bytes)
+            {
+                m_rx_bytes.add(bytes);
+            }
+
+            /**
+             * @brief Counts a message from the device that failed the CRC check.
+             */
+            void countCrcFailure()
+            {
+                m_crc_failures.add();
+            }
+
+            /**
+             * @brief Counts a message the device reported failed the CRC check.
+             */
+            void countDeviceCrcFailure()
+            {
+                m_device_crc_failures.add();
+            }
+
+            /**
+             * @brief Counts an error by the type of its exception, see BaseException::getTypeIndex.
+             *
+             * The exception types past the first `kErrorTypes` are counted together under `"other"`.
+             *
+             * @param error The error
+             */
+            void countError(std::exception_ptr error);
+
+            /**
+             * @brief Adds a round trip time to the histogram of a command ID.
+             *
+             * Ignored for command IDs that weren't added.
+             *
+             * @param command_id ID of the command
+             * @param rtt Round trip time
+             */
+            void recordRtt(uint16_t command_id, std::chrono::microseconds rtt);
+
+            /**
+             * @brief Copies the counters and histograms.
+             *
+             * Only the counters kept by the metrics are filled in, the queue depths are left at `0`.
+             *
+             * @return Snapshot of the metrics
+             */
+            MetricsSnapshot snapshot() const;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_METRICS_HPP
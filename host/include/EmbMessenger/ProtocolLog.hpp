@@ -0,0 +1,94 @@
+#ifndef EMBMESSENGER_PROTOCOLLOG_HPP
+#define EMBMESSENGER_PROTOCOLLOG_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/DataType.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief What a ProtocolEvent describes.
+         */
+        enum class ProtocolEventType : uint8_t
+        {
+            Address,       /// The bus address a message starts with, only when decoding addressed messages
+            Message,       /// The start of a message, with its message id
+            Command,       /// The command id of a message from the host
+            Value,         /// A parameter of the message
+            Error,         /// An error reported by the device, with its code and data
+            EndOfMessage,  /// The end of the message and the result of the CRC check
+            Unknown,       /// A byte that isn't a data type, most likely a rogue print statement in the device code
+            Truncated,     /// A parameter that was cut off, the rest of the message is lost
+            Malformed      /// A message whose address, message id or command id can't be read
+        };
+
+        /**
+         * @brief One decoded piece of a message.
+         *
+         * Messages are logged as raw bytes, see CaptureBuffer, and only decoded into events offline, so the live
+         * process never formats anything.
+         */
+        struct ProtocolEvent
+        {
+            std::chrono::nanoseconds time{ 0 };                           /// Time of the message
+            CaptureDirection direction = CaptureDirection::HostToDevice;  /// Direction of the message
+            ProtocolEventType type = ProtocolEventType::Message;          /// What the event describes
+            uint16_t message_id = 0;                                      /// Message id of the message
+            uint16_t index = 0;                                           /// Index of the parameter
+            shared::DataType data_type = shared::DataType::kNull;         /// Data type of a Value or Unknown
+
+            uint64_t unsigned_value = 0;  /// Unsigned integers and bools, the Address, the Command id or the Error code
+            int64_t signed_value = 0;     /// Value of signed integers, or the data of an Error
+            float float_value = 0;        /// Value of floats
+            bool crc_valid = false;       /// Result of the CRC check at the EndOfMessage
+        };
+
+        /**
+         * @brief Decodes a message into events.
+         *
+         * @param direction Direction of the message
+         * @param time Time of the message
+         * @param data Bytes of the message
+         * @param size Number of bytes, at most `Frame::kMaxFrameSize`
+         * @param[out] events Vector the events are appended to
+         * @param addressed True if the message starts with a bus address, see IAddressable
+         */
+        void decodeMessage(CaptureDirection direction, std::chrono::nanoseconds time, const uint8_t* data,
+                           size_t size, std::vector<ProtocolEvent>& events, bool addressed = false);
+
+        /**
+         * @brief Decodes every message of a capture into events.
+         *
+         * @param records The messages, see readCapture
+         * @param addressed True if the messages start with a bus address, see readCaptureHeader
+         * @return The events of all the messages, in order
+         */
+        std::vector<ProtocolEvent> decodeLog(const std::vector<CaptureRecord>& records, bool addressed = false);
+
+        /**
+         * @brief Gets the name of a data type.
+         *
+         * @param type The data type
+         * @return Name of the type, `Unknown` if it isn't one
+         */
+        const char* dataTypeName(shared::DataType type);
+
+        /**
+         * @brief Formats an event as a line of text.
+         *
+         * @param event The event
+         * @return The line, without the time
+         */
+        std::string formatEvent(const ProtocolEvent& event);
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_PROTOCOLLOG_HPP
@@ -0,0 +1,119 @@
+#ifndef EMBMESSENGER_REPLAYBUFFER_HPP
+#define EMBMESSENGER_REPLAYBUFFER_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/Frame.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <string>
+#include <vector>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief How fast a ReplayBuffer plays back the messages from the device.
+         */
+        enum class ReplaySpeed
+        {
+            Original,  /// Each message waits as long after the host's previous message as it did in the capture
+            Maximum    /// Each message is available as soon as the host has sent the messages before it
+        };
+
+        /**
+         * @brief Buffer that plays the device's side of a capture back to the host.
+         *
+         * The messages the device sent are released in their captured order, each once the host has sent as many
+         * messages as it had before it in the capture, so responses never arrive before the commands they answer.
+         * At ReplaySpeed::Original they are also delayed like in the capture. The messages the host sends are
+         * compared to the captured ones, see mismatches.
+         *
+         * The host has to send the same commands in the same order as when the capture was made.
+         */
+        class ReplayBuffer : public shared::IBuffer
+        {
+            using clock_t = std::chrono::steady_clock;
+
+            std::vector<CaptureRecord> m_records;
+            std::vector<size_t> m_host_records;
+            ReplaySpeed m_speed;
+
+            // The next record to release, and the host message before it that its delay is measured from
+            size_t m_next_record;
+            size_t m_host_messages_released;
+            std::chrono::nanoseconds m_anchor_capture_time;
+            clock_t::time_point m_anchor_time;
+
+            // Messages from the device that were released and not read yet
+            std::deque<const CaptureRecord*> m_released;
+            size_t m_read_offset;
+            size_t m_released_bytes;
+
+            Frame m_written;
+            FrameSplitter m_splitter;
+            std::vector<clock_t::time_point> m_write_times;
+            size_t m_mismatches;
+
+#ifndef EMB_SINGLE_THREADED
+            mutable std::mutex m_mutex;
+#endif
+
+            void release();
+
+        public:
+            /**
+             * @brief Construct a new Replay Buffer from a capture stream.
+             *
+             * @param input Stream to read the capture from, it is read completely
+             * @param speed How fast to play the messages back
+             * @throws std::runtime_error If the stream isn't a capture file
+             */
+            explicit ReplayBuffer(std::istream& input, ReplaySpeed speed = ReplaySpeed::Original);
+
+            /**
+             * @brief Construct a new Replay Buffer from a capture file.
+             *
+             * @param path Path of the capture file
+             * @param speed How fast to play the messages back
+             * @throws std::runtime_error If the file can't be opened or isn't a capture file
+             */
+            explicit ReplayBuffer(const std::string& path, ReplaySpeed speed = ReplaySpeed::Original);
+
+            /**
+             * @brief Checks if every message from the device has been read.
+             *
+             * @return True once the replay is over
+             */
+            bool finished() const;
+
+            /**
+             * @brief Gets the number of messages the host sent that don't match the capture.
+             *
+             * Messages the host sends beyond the end of the capture are mismatches too.
+             *
+             * @return Number of mismatched messages
+             */
+            size_t mismatches() const;
+
+            virtual void writeByte(const uint8_t byte) override;
+            virtual uint8_t peek() const override;
+            virtual uint8_t readByte() override;
+            virtual bool empty() const override;
+            virtual size_t size() const override;
+            virtual uint8_t messages() const override;
+            virtual void update() override;
+            virtual void zero() override;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_REPLAYBUFFER_HPP
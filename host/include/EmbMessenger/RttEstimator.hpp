@@ -0,0 +1,100 @@
+#ifndef EMBMESSENGER_RTTESTIMATOR_HPP
+#define EMBMESSENGER_RTTESTIMATOR_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Smoothed round trip time estimator, as described by Jacobson and Karels.
+         *
+         * Each sample moves the smoothed RTT 1/8 of the way towards it and the variance 1/4 of the way towards its
+         * deviation from the smoothed RTT. The retransmission timeout is the smoothed RTT plus four times the
+         * variance, clamped to the minimum and maximum.
+         *
+         * Only feed it samples of messages that weren't retransmitted (Karn's rule), a response to a retransmitted
+         * message can't be matched to the copy that caused it.
+         */
+        class RttEstimator
+        {
+            // Kept scaled by 8 and 4 so the small steps aren't lost to rounding
+            std::chrono::microseconds m_smoothed_rtt_8;
+            std::chrono::microseconds m_rtt_variance_4;
+            std::chrono::microseconds m_min_rtt;
+            std::chrono::microseconds m_last_rtt;
+            std::chrono::microseconds m_min_timeout;
+            std::chrono::microseconds m_max_timeout;
+            size_t m_samples;
+
+        public:
+            /**
+             * @brief Construct a new RTT Estimator.
+             *
+             * @param min_timeout Lower bound of the retransmission timeout
+             * @param max_timeout Upper bound of the retransmission timeout
+             */
+            explicit RttEstimator(std::chrono::microseconds min_timeout = std::chrono::milliseconds(2),
+                                  std::chrono::microseconds max_timeout = std::chrono::seconds(60));
+
+            /**
+             * @brief Adds a measured round trip time.
+             *
+             * @param rtt Time from writing a message to receiving its response
+             */
+            void addSample(std::chrono::microseconds rtt);
+
+            /**
+             * @brief Forgets every sample.
+             */
+            void reset();
+
+            /**
+             * @brief Gets the number of samples added.
+             *
+             * @return Number of samples
+             */
+            size_t samples() const;
+
+            /**
+             * @brief Gets the smoothed round trip time.
+             *
+             * @return Smoothed RTT, `0` without samples
+             */
+            std::chrono::microseconds smoothedRtt() const;
+
+            /**
+             * @brief Gets the smoothed mean deviation of the round trip time.
+             *
+             * @return RTT variance, `0` without samples
+             */
+            std::chrono::microseconds rttVariance() const;
+
+            /**
+             * @brief Gets the shortest round trip time measured.
+             *
+             * @return Minimum RTT, `0` without samples
+             */
+            std::chrono::microseconds minRtt() const;
+
+            /**
+             * @brief Gets the last round trip time measured.
+             *
+             * @return Last RTT, `0` without samples
+             */
+            std::chrono::microseconds lastRtt() const;
+
+            /**
+             * @brief Gets the retransmission timeout.
+             *
+             * @param fallback Timeout to use before there are samples
+             * @return Smoothed RTT plus four times the variance, clamped to the bounds
+             */
+            std::chrono::microseconds timeout(std::chrono::microseconds fallback) const;
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_RTTESTIMATOR_HPP
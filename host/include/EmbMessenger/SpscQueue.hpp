@@ -0,0 +1,130 @@
+#ifndef EMBMESSENGER_SPSCQUEUE_HPP
+#define EMBMESSENGER_SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Bounded lock free queue for one producer thread and one consumer thread.
+         *
+         * All items are allocated up front, pushing and popping never allocates.
+         * Items are moved out when popped, so the queue doesn't keep anything alive.
+         *
+         * @tparam T Type of the items
+         */
+        template <typename T>
+        class SpscQueue
+        {
+            static constexpr size_t kCacheLineSize = 64;
+
+            std::vector<T> m_items;
+            size_t m_mask;
+
+            // The producer and consumer indices are kept on separate cache lines so the threads don't contend
+            char m_padding_front[kCacheLineSize];
+            std::atomic<size_t> m_head;
+            char m_padding_head[kCacheLineSize - sizeof(std::atomic<size_t>)];
+            std::atomic<size_t> m_tail;
+            char m_padding_tail[kCacheLineSize - sizeof(std::atomic<size_t>)];
+
+        public:
+            /**
+             * @brief Construct a new SPSC Queue.
+             *
+             * @param capacity Maximum number of items in the queue, rounded up to a power of two
+             */
+            explicit SpscQueue(size_t capacity) : m_head(0), m_tail(0)
+            {
+                if (capacity == 0)
+                {
+                    throw std::invalid_argument("SpscQueue capacity must be at least 1");
+                }
+
+                size_t slots = 1;
+                while (slots < capacity)
+                {
+                    slots <<= 1;
+                }
+
+                m_items.resize(slots);
+                m_mask = slots - 1;
+            }
+
+            SpscQueue(const SpscQueue&) = delete;
+            SpscQueue& operator=(const SpscQueue&) = delete;
+
+            /**
+             * @brief Adds an item to the queue. Only call from the producer thread.
+             *
+             * @param item Item to add
+             * @return False if the queue is full, the item is not added
+             */
+            bool push(T item)
+            {
+                size_t tail = m_tail.load(std::memory_order_relaxed);
+                if (tail - m_head.load(std::memory_order_acquire) == m_items.size())
+                {
+                    return false;
+                }
+
+                m_items[tail & m_mask] = std::move(item);
+                m_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * @brief Removes up to @p max items from the queue. Only call from the consumer thread.
+             *
+             * @param items Array to move the items into
+             * @param max Maximum number of items to remove
+             * @return Number of items removed
+             */
+            size_t pop(T* items, size_t max)
+            {
+                size_t head = m_head.load(std::memory_order_relaxed);
+                size_t available = m_tail.load(std::memory_order_acquire) - head;
+                size_t count = available < max ? available : max;
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    items[i] = std::move(m_items[(head + i) & m_mask]);
+                    m_items[(head + i) & m_mask] = T();
+                }
+
+                m_head.store(head + count, std::memory_order_release);
+                return count;
+            }
+
+            /**
+             * @brief Gets the number of items in the queue.
+             *
+             * Only a snapshot when the other thread is using the queue.
+             *
+             * @return Number of items in the queue
+             */
+            size_t size() const
+            {
+                return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+            }
+
+            /**
+             * @brief Gets the maximum number of items the queue can hold.
+             *
+             * @return Capacity of the queue
+             */
+            size_t capacity() const
+            {
+                return m_items.size();
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_SPSCQUEUE_HPP
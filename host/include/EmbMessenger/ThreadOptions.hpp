@@ -0,0 +1,46 @@
+#ifndef EMBMESSENGER_THREADOPTIONS_HPP
+#define EMBMESSENGER_THREADOPTIONS_HPP
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief How the Multi Threaded EmbMessenger writes messages to the buffer.
+         */
+        enum class TransmitMode
+        {
+            Dedicated,  /// Senders queue their messages and a write thread writes them to the buffer
+            Inline      /// Senders write their messages to the buffer themselves, one at a time
+        };
+
+        /**
+         * @brief How the Multi Threaded EmbMessenger reads messages from the buffer.
+         */
+        enum class ReceiveMode
+        {
+            Dedicated,  /// A receive thread reads the messages and runs the callbacks
+            External    /// Something else calls `EmbMessenger::poll`, like an EmbMessengerPool
+        };
+
+        /**
+         * @brief Options for the threads of the Multi Threaded EmbMessenger.
+         *
+         * The receive thread reads and decodes messages from the device and runs the callbacks.
+         * The transmit thread writes the messages queued by the senders to the buffer.
+         */
+        struct ThreadOptions
+        {
+            TransmitMode transmit_mode = TransmitMode::Dedicated;  /// How messages are written to the buffer
+            ReceiveMode receive_mode = ReceiveMode::Dedicated;     /// How messages are read from the buffer
+
+            int receive_cpu = -1;   /// CPU to pin the receive thread to, `-1` to let it run on any CPU
+            int transmit_cpu = -1;  /// CPU to pin the transmit thread to, `-1` to let it run on any CPU
+
+            const char* receive_name = "emb-rx";   /// Name of the receive thread, at most 15 characters
+            const char* transmit_name = "emb-tx";  /// Name of the transmit thread, at most 15 characters
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_THREADOPTIONS_HPP
@@ -0,0 +1,78 @@
+#ifndef EMBMESSENGER_THREADPOOLEXECUTOR_HPP
+#define EMBMESSENGER_THREADPOOLEXECUTOR_HPP
+
+#ifndef EMB_SINGLE_THREADED
+
+#include "EmbMessenger/IExecutor.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Executor that runs tasks on a fixed set of worker threads.
+         *
+         * Each key is always given to the same worker (`key % threads`), which runs its tasks in order, so the
+         * callbacks of a command never run concurrently or out of order.
+         * Tasks still queued when the executor is destroyed are run before the workers are joined.
+         */
+        class ThreadPoolExecutor : public IExecutor
+        {
+            struct Worker
+            {
+                std::mutex mutex;
+                std::condition_variable condition_variable;
+                std::deque<std::function<void()>> tasks;
+                bool running = true;
+                std::thread thread;
+            };
+
+            std::vector<std::unique_ptr<Worker>> m_workers;
+
+            static void work(Worker* worker);
+
+        public:
+            /**
+             * @brief Construct a new Thread Pool Executor.
+             *
+             * @param threads Number of worker threads, at least 1
+             */
+            explicit ThreadPoolExecutor(size_t threads);
+
+            /**
+             * @brief Destroy the Thread Pool Executor.
+             *
+             * Runs the remaining tasks and joins the workers.
+             */
+            virtual ~ThreadPoolExecutor();
+
+            ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+            ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+            virtual void execute(uint16_t key, std::function<void()> task) override;
+        };
+
+        /**
+         * @brief Executor that runs every task in order on one dedicated thread.
+         */
+        class ThreadExecutor : public ThreadPoolExecutor
+        {
+        public:
+            ThreadExecutor() : ThreadPoolExecutor(1)
+            {
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMB_SINGLE_THREADED
+
+#endif  // EMBMESSENGER_THREADPOOLEXECUTOR_HPP
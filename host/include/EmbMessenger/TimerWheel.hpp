@@ -0,0 +1,172 @@
+#ifndef EMBMESSENGER_TIMERWHEEL_HPP
+#define EMBMESSENGER_TIMERWHEEL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emb
+{
+    namespace host
+    {
+        /**
+         * @brief Hierarchical timer wheel with a fixed number of timers.
+         *
+         * Time is divided into ticks. The first level has a slot for each of the next 256 ticks, each further level
+         * covers 64 slots of the level below it. Scheduling and cancelling a timer is O(1), advancing the wheel is
+         * O(1) per tick plus the timers that expire. Timers further out than the wheel reaches are kept in the last
+         * level and placed again when it comes around.
+         *
+         * Timers are identified by an index chosen by the caller, nothing is allocated after construction.
+         */
+        class TimerWheel
+        {
+        public:
+            using clock_t = std::chrono::steady_clock;
+
+        private:
+            static constexpr size_t kLevels = 4;
+            static constexpr uint32_t kNone = 0xFFFFFFFF;
+
+            struct Timer
+            {
+                uint64_t expiry;
+                uint32_t previous;
+                uint32_t next;
+                uint32_t list;
+                bool scheduled;
+            };
+
+            std::vector<Timer> m_timers;
+            std::vector<uint32_t> m_lists;
+            clock_t::time_point m_start;
+            clock_t::duration m_tick;
+            uint64_t m_current_tick;
+            size_t m_size;
+            size_t m_first_level_size;
+
+            uint64_t toTick(clock_t::time_point time) const;
+            void place(uint32_t timer);
+            void unlink(uint32_t timer);
+            void cascade();
+            void skipIdleTicks(uint64_t target);
+            uint32_t popExpired();
+
+        public:
+            /**
+             * @brief Construct a new Timer Wheel.
+             *
+             * @param timers Number of timers, they are indexed from `0` to `timers - 1`
+             * @param tick Resolution of the timers
+             * @param start Time of the first tick
+             */
+            explicit TimerWheel(size_t timers, clock_t::duration tick = std::chrono::milliseconds(1),
+                                clock_t::time_point start = clock_t::now());
+
+            /**
+             * @brief Starts a timer, or moves it if it is already running.
+             *
+             * Timers never fire early, they fire in the first advance past the end of the tick the deadline falls in.
+             *
+             * @param timer Index of the timer
+             * @param deadline Time the timer expires
+             */
+            void schedule(uint32_t timer, clock_t::time_point deadline);
+
+            /**
+             * @brief Stops a timer, does nothing if the timer isn't running.
+             *
+             * @param timer Index of the timer
+             */
+            void cancel(uint32_t timer);
+
+            /**
+             * @brief Checks if a timer is running.
+             *
+             * @param timer Index of the timer
+             * @return True if the timer is scheduled and hasn't expired yet
+             */
+            bool scheduled(uint32_t timer) const;
+
+            /**
+             * @brief Gets the number of timers that are running.
+             *
+             * @return Number of scheduled timers
+             */
+            size_t size() const;
+
+            /**
+             * @brief Gets the number of timers.
+             *
+             * @return Number of timers the wheel was constructed with
+             */
+            size_t capacity() const;
+
+            /**
+             * @brief Gets the time the next tick ends.
+             *
+             * No timer can expire before then, so the wheel doesn't need to be advanced until that time.
+             *
+             * @return Time of the next tick
+             */
+            clock_t::time_point nextTick() const;
+
+            /**
+             * @brief Gets the time the wheel has advanced to.
+             *
+             * Inside the function passed to advance, this is when the expiring timers were due, rounded up to a tick.
+             *
+             * @return Time of the current tick
+             */
+            clock_t::time_point time() const;
+
+            /**
+             * @brief Moves the wheel forward to @p now and calls @p expired with the index of each expired timer.
+             *
+             * The timers may be scheduled and cancelled from @p expired.
+             *
+             * @tparam Function Type of the function, `void(uint32_t)`
+             * @param now Current time
+             * @param expired Function called for each expired timer
+             * @return Number of timers that expired
+             */
+            template <typename Function>
+            size_t advance(clock_t::time_point now, Function&& expired)
+            {
+                uint64_t target = toTick(now);
+                size_t count = 0;
+
+                while (m_current_tick < target)
+                {
+                    // Nothing to wait for, skip straight to the end
+                    if (m_size == 0)
+                    {
+                        m_current_tick = target;
+                        break;
+                    }
+
+                    skipIdleTicks(target);
+                    if (m_current_tick == target)
+                    {
+                        break;
+                    }
+
+                    ++m_current_tick;
+                    cascade();
+
+                    uint32_t timer;
+                    while ((timer = popExpired()) != kNone)
+                    {
+                        ++count;
+                        expired(timer);
+                    }
+                }
+
+                return count;
+            }
+        };
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_TIMERWHEEL_HPP
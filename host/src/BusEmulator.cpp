@@ -0,0 +1,211 @@
+#include "EmbMessenger/BusEmulator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#ifndef EMB_SINGLE_THREADED
+#include <mutex>
+#endif
+
+namespace emb
+{
+    namespace host
+    {
+        // The link and the devices on it, shared with the devices' drops
+        class BusEmulator::Line
+        {
+            LinkEmulator m_link;
+            std::vector<Drop*> m_drops;
+
+        public:
+#ifndef EMB_SINGLE_THREADED
+            // Guards the drops' buffers as well, updating one drop fills them all
+            std::mutex mutex;
+#endif
+
+            Line(LinkOptions host_to_devices, LinkOptions devices_to_host, std::shared_ptr<IClock> clock) :
+                m_link(host_to_devices, devices_to_host, std::move(clock))
+            {
+            }
+
+            const LinkEmulator& link() const
+            {
+                return m_link;
+            }
+
+            void attach(Drop* drop)
+            {
+                m_drops.push_back(drop);
+            }
+
+            void detach(Drop* drop)
+            {
+                m_drops.erase(std::remove(m_drops.begin(), m_drops.end(), drop), m_drops.end());
+            }
+
+            void transmit(const std::vector<uint8_t>& message)
+            {
+                for (uint8_t byte : message)
+                {
+                    m_link.device()->writeByte(byte);
+                }
+            }
+
+            void receive()
+            {
+                std::shared_ptr<shared::IBuffer> end = m_link.device();
+                end->update();
+                while (!end->empty())
+                {
+                    uint8_t byte = end->readByte();
+                    for (Drop* drop : m_drops)
+                    {
+                        drop->arrive(byte);
+                    }
+                }
+            }
+        };
+
+        BusEmulator::Drop::Drop(std::shared_ptr<Line> line) : m_line(std::move(line)), m_messages(0)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            m_line->attach(this);
+        }
+
+        BusEmulator::Drop::~Drop()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            m_line->detach(this);
+        }
+
+        void BusEmulator::Drop::arrive(uint8_t byte)
+        {
+            m_received.push_back(byte);
+            if (m_arrive_splitter.push(byte))
+            {
+                ++m_messages;
+            }
+        }
+
+        void BusEmulator::Drop::writeByte(const uint8_t byte)
+        {
+            m_outgoing.push_back(byte);
+            if (m_write_splitter.push(byte))
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+                m_line->transmit(m_outgoing);
+                m_outgoing.clear();
+            }
+        }
+
+        uint8_t BusEmulator::Drop::peek() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            return m_received.front();
+        }
+
+        uint8_t BusEmulator::Drop::readByte()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            uint8_t byte = m_received.front();
+            m_received.pop_front();
+
+            if (m_read_splitter.push(byte) && m_messages > 0)
+            {
+                --m_messages;
+            }
+            return byte;
+        }
+
+        bool BusEmulator::Drop::empty() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            return m_received.empty();
+        }
+
+        size_t BusEmulator::Drop::size() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            return m_received.size();
+        }
+
+        uint8_t BusEmulator::Drop::messages() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            return static_cast<uint8_t>(std::min<size_t>(m_messages, std::numeric_limits<uint8_t>::max()));
+        }
+
+        void BusEmulator::Drop::update()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            m_line->receive();
+        }
+
+        void BusEmulator::Drop::zero()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_line->mutex);
+#endif
+            m_received.clear();
+            m_messages = 0;
+            m_arrive_splitter.reset();
+            m_read_splitter.reset();
+        }
+
+        BusEmulator::BusEmulator(LinkOptions options, std::shared_ptr<IClock> clock) :
+            BusEmulator(options,
+                        [&options] {
+                            LinkOptions devices_to_host = options;
+                            ++devices_to_host.seed;
+                            return devices_to_host;
+                        }(),
+                        std::move(clock))
+        {
+        }
+
+        BusEmulator::BusEmulator(LinkOptions host_to_devices, LinkOptions devices_to_host,
+                                 std::shared_ptr<IClock> clock) :
+            m_line(std::make_shared<Line>(host_to_devices, devices_to_host, std::move(clock)))
+        {
+        }
+
+        std::shared_ptr<shared::IBuffer> BusEmulator::host() const
+        {
+            return m_line->link().host();
+        }
+
+        std::shared_ptr<shared::IBuffer> BusEmulator::addDevice()
+        {
+            return std::make_shared<Drop>(m_line);
+        }
+
+        LinkEmulator::Counters BusEmulator::hostToDevices() const
+        {
+            return m_line->link().hostToDevice();
+        }
+
+        LinkEmulator::Counters BusEmulator::devicesToHost() const
+        {
+            return m_line->link().deviceToHost();
+        }
+    }  // namespace host
+}  // namespace emb
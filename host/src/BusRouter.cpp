@@ -0,0 +1,239 @@
+#include "EmbMessenger/BusRouter.hpp"
+
+#include "EmbMessenger/BusAddress.hpp"
+#include "EmbMessenger/DataType.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace emb
+{
+    namespace host
+    {
+        // The state shared by the router and its endpoints
+        class BusRouter::Bus
+        {
+            std::shared_ptr<shared::IBuffer> m_buffer;
+            Endpoint* m_endpoints[256];
+            uint64_t m_unrouted;
+
+            // The message being read from the bus, it may arrive over several updates
+            std::vector<uint8_t> m_message;
+            FrameSplitter m_splitter;
+#ifndef EMB_SINGLE_THREADED
+            std::mutex m_write_mutex;
+            mutable std::mutex m_read_mutex;
+#endif
+
+            void route()
+            {
+                // The address is the message's first value, a positive fixint or a uint8_t
+                Endpoint* endpoint = nullptr;
+                if (m_message[0] <= 0x7F)
+                {
+                    endpoint = m_endpoints[m_message[0]];
+                }
+                else if (m_message[0] == shared::DataType::kUint8 && m_message.size() > 1)
+                {
+                    endpoint = m_endpoints[m_message[1]];
+                }
+
+                if (endpoint == nullptr)
+                {
+                    ++m_unrouted;
+                    return;
+                }
+                endpoint->deliver(m_message);
+            }
+
+        public:
+            explicit Bus(std::shared_ptr<shared::IBuffer> buffer) : m_buffer(std::move(buffer)), m_unrouted(0)
+            {
+                std::fill(std::begin(m_endpoints), std::end(m_endpoints), nullptr);
+            }
+
+            void attach(Endpoint* endpoint)
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_read_mutex);
+#endif
+                if (endpoint->address() == shared::kBroadcastAddress)
+                {
+                    throw std::invalid_argument("The broadcast address can't have an endpoint");
+                }
+
+                if (m_endpoints[endpoint->address()] != nullptr)
+                {
+                    throw std::invalid_argument("Address " + std::to_string(endpoint->address()) +
+                                                " already has an endpoint");
+                }
+                m_endpoints[endpoint->address()] = endpoint;
+            }
+
+            void detach(Endpoint* endpoint)
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_read_mutex);
+#endif
+                if (m_endpoints[endpoint->address()] == endpoint)
+                {
+                    m_endpoints[endpoint->address()] = nullptr;
+                }
+            }
+
+            void transmit(const std::vector<uint8_t>& message)
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_write_mutex);
+#endif
+                for (uint8_t byte : message)
+                {
+                    m_buffer->writeByte(byte);
+                }
+            }
+
+            void receive()
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_read_mutex);
+#endif
+                m_buffer->update();
+                while (!m_buffer->empty())
+                {
+                    uint8_t byte = m_buffer->readByte();
+                    m_message.push_back(byte);
+                    if (m_splitter.push(byte))
+                    {
+                        route();
+                        m_message.clear();
+                    }
+                }
+            }
+
+            uint64_t unrouted() const
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_read_mutex);
+#endif
+                return m_unrouted;
+            }
+        };
+
+        BusRouter::Endpoint::Endpoint(std::shared_ptr<Bus> bus, uint8_t address) :
+            m_bus(std::move(bus)),
+            m_address(address),
+            m_messages(0)
+        {
+            m_bus->attach(this);
+        }
+
+        BusRouter::Endpoint::~Endpoint()
+        {
+            m_bus->detach(this);
+        }
+
+        void BusRouter::Endpoint::deliver(const std::vector<uint8_t>& message)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            m_received.insert(m_received.end(), message.begin(), message.end());
+            ++m_messages;
+        }
+
+        void BusRouter::Endpoint::writeByte(const uint8_t byte)
+        {
+            // Messages go out whole, so they don't mix with the other endpoints' on the bus
+            m_outgoing.push_back(byte);
+            if (m_write_splitter.push(byte))
+            {
+                m_bus->transmit(m_outgoing);
+                m_outgoing.clear();
+            }
+        }
+
+        uint8_t BusRouter::Endpoint::peek() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return m_received.front();
+        }
+
+        uint8_t BusRouter::Endpoint::readByte()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            uint8_t byte = m_received.front();
+            m_received.pop_front();
+
+            if (m_read_splitter.push(byte) && m_messages > 0)
+            {
+                --m_messages;
+            }
+            return byte;
+        }
+
+        bool BusRouter::Endpoint::empty() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return m_received.empty();
+        }
+
+        size_t BusRouter::Endpoint::size() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return m_received.size();
+        }
+
+        uint8_t BusRouter::Endpoint::messages() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return static_cast<uint8_t>(std::min<size_t>(m_messages, std::numeric_limits<uint8_t>::max()));
+        }
+
+        void BusRouter::Endpoint::update()
+        {
+            m_bus->receive();
+        }
+
+        void BusRouter::Endpoint::zero()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            m_received.clear();
+            m_messages = 0;
+            m_read_splitter.reset();
+        }
+
+        uint8_t BusRouter::Endpoint::address() const
+        {
+            return m_address;
+        }
+
+        BusRouter::BusRouter(std::shared_ptr<shared::IBuffer> bus) : m_bus(std::make_shared<Bus>(std::move(bus)))
+        {
+        }
+
+        std::shared_ptr<shared::IBuffer> BusRouter::endpoint(uint8_t address)
+        {
+            return std::make_shared<Endpoint>(m_bus, address);
+        }
+
+        uint64_t BusRouter::unrouted() const
+        {
+            return m_bus->unrouted();
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,155 @@
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/DataType.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace
+        {
+            constexpr char kMagic[] = { 'E', 'M', 'B', 'C', 'A', 'P' };
+            // Version 1 had the flags byte reserved, always 0
+            constexpr uint8_t kVersion = 2;
+            constexpr uint8_t kFlagsVersion = 2;
+            constexpr uint8_t kAddressedFlag = 0x01;
+            constexpr uint8_t kKnownFlags = kAddressedFlag;
+
+            template <typename T>
+            void writeLittleEndian(std::ostream& output, T value)
+            {
+                char bytes[sizeof(T)];
+                for (size_t i = 0; i < sizeof(T); ++i)
+                {
+                    bytes[i] = static_cast<char>(value >> (8 * i));
+                }
+                output.write(bytes, sizeof(T));
+            }
+
+            template <typename T>
+            bool readLittleEndian(std::istream& input, T& value)
+            {
+                char bytes[sizeof(T)];
+                if (!input.read(bytes, sizeof(T)))
+                {
+                    return false;
+                }
+
+                value = 0;
+                for (size_t i = 0; i < sizeof(T); ++i)
+                {
+                    value |= static_cast<T>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+                }
+                return true;
+            }
+        }  // namespace
+
+        void writeCaptureHeader(std::ostream& output, bool addressed)
+        {
+            output.write(kMagic, sizeof(kMagic));
+            output.put(static_cast<char>(kVersion));
+            output.put(static_cast<char>(addressed ? kAddressedFlag : 0));
+        }
+
+        void writeCaptureRecord(std::ostream& output, std::chrono::nanoseconds time, CaptureDirection direction,
+                                const uint8_t* data, size_t size)
+        {
+            writeLittleEndian(output, static_cast<uint64_t>(time.count()));
+            output.put(static_cast<char>(direction));
+            writeLittleEndian(output, static_cast<uint16_t>(size));
+            output.write(reinterpret_cast<const char*>(data), size);
+        }
+
+        bool readCaptureHeader(std::istream& input)
+        {
+            char header[sizeof(kMagic) + 2];
+            if (!input.read(header, sizeof(header)) ||
+                !std::equal(std::begin(kMagic), std::end(kMagic), std::begin(header)))
+            {
+                throw std::runtime_error("Not an EmbMessenger capture");
+            }
+
+            uint8_t version = static_cast<uint8_t>(header[sizeof(kMagic)]);
+            if (version == 0 || version > kVersion)
+            {
+                throw std::runtime_error("Unsupported capture version " + std::to_string(version));
+            }
+
+            // A flag this version doesn't know about could change how the messages are decoded
+            uint8_t flags = static_cast<uint8_t>(header[sizeof(kMagic) + 1]);
+            uint8_t known_flags = version >= kFlagsVersion ? kKnownFlags : 0;
+            if ((flags & ~known_flags) != 0)
+            {
+                throw std::runtime_error("Unsupported capture flags " + std::to_string(flags));
+            }
+
+            return (flags & kAddressedFlag) != 0;
+        }
+
+        bool readCaptureRecord(std::istream& input, CaptureRecord& record)
+        {
+            uint64_t time = 0;
+            uint8_t direction = 0;
+            uint16_t size = 0;
+            if (!readLittleEndian(input, time) || !readLittleEndian(input, direction) ||
+                !readLittleEndian(input, size))
+            {
+                return false;
+            }
+
+            record.time = std::chrono::nanoseconds(time);
+            record.direction = static_cast<CaptureDirection>(direction);
+            record.data.resize(size);
+            return size == 0 || input.read(reinterpret_cast<char*>(record.data.data()), size);
+        }
+
+        std::vector<CaptureRecord> readCapture(std::istream& input)
+        {
+            bool addressed = false;
+            return readCapture(input, addressed);
+        }
+
+        std::vector<CaptureRecord> readCapture(std::istream& input, bool& addressed)
+        {
+            addressed = readCaptureHeader(input);
+
+            std::vector<CaptureRecord> records;
+            CaptureRecord record;
+            while (readCaptureRecord(input, record))
+            {
+                records.push_back(std::move(record));
+            }
+            return records;
+        }
+
+        FrameSplitter::FrameSplitter()
+        {
+            reset();
+        }
+
+        bool FrameSplitter::push(uint8_t byte)
+        {
+            if (m_remaining == 0)
+            {
+                shared::DataType type = static_cast<shared::DataType>(byte);
+                m_remaining = shared::dataBytes(type);
+                m_end_of_message = type == shared::DataType::kEndOfMessage;
+                return false;
+            }
+
+            // The end of message is followed by the CRC
+            --m_remaining;
+            return m_remaining == 0 && m_end_of_message;
+        }
+
+        void FrameSplitter::reset()
+        {
+            m_remaining = 0;
+            m_end_of_message = false;
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,234 @@
+#include "EmbMessenger/CaptureBuffer.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace emb
+{
+    namespace host
+    {
+        constexpr size_t CaptureBuffer::kBatchSize;
+
+        namespace
+        {
+            std::shared_ptr<std::ostream> openCapture(const std::string& path)
+            {
+                std::shared_ptr<std::ofstream> file =
+                    std::make_shared<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+                if (!file->is_open())
+                {
+                    throw std::runtime_error("Unable to open capture file " + path);
+                }
+                return file;
+            }
+        }  // namespace
+
+        CaptureBuffer::CaptureBuffer(std::shared_ptr<shared::IBuffer> buffer, std::shared_ptr<std::ostream> output,
+                                     size_t capacity, bool addressed) :
+            m_buffer(buffer),
+            m_output(output),
+            m_start(std::chrono::steady_clock::now()),
+            m_transmitted(capacity),
+            m_received(capacity),
+            m_dropped(0),
+            m_transmitted_batch(kBatchSize),
+            m_received_batch(kBatchSize),
+            m_transmitted_index(0),
+            m_transmitted_count(0),
+            m_received_index(0),
+            m_received_count(0)
+        {
+            writeCaptureHeader(*m_output, addressed);
+
+#ifndef EMB_SINGLE_THREADED
+            m_writing = true;
+            m_writer = std::thread(&CaptureBuffer::writeThread, this);
+#endif
+        }
+
+        CaptureBuffer::CaptureBuffer(std::shared_ptr<shared::IBuffer> buffer, const std::string& path,
+                                     size_t capacity, bool addressed) :
+            CaptureBuffer(buffer, openCapture(path), capacity, addressed)
+        {
+        }
+
+        CaptureBuffer::~CaptureBuffer()
+        {
+#ifndef EMB_SINGLE_THREADED
+            m_writing = false;
+            m_writer.join();
+#endif
+            flush();
+        }
+
+#ifndef EMB_SINGLE_THREADED
+        void CaptureBuffer::writeThread()
+        {
+            while (true)
+            {
+                size_t written = 0;
+                {
+                    std::lock_guard<std::mutex> lock(m_output_mutex);
+                    written = writeQueued();
+                }
+
+                if (written == 0)
+                {
+                    if (!m_writing)
+                    {
+                        break;
+                    }
+
+                    // Polled so capturing a message never has to wake the writer
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        }
+#endif
+
+        void CaptureBuffer::capture(SpscQueue<Entry>& queue, Frame& frame, FrameSplitter& splitter, uint8_t byte)
+        {
+            frame.writeByte(byte);
+            bool end = splitter.push(byte);
+            if (!end && !frame.overflowed())
+            {
+                return;
+            }
+
+            std::chrono::nanoseconds time = std::chrono::steady_clock::now() - m_start;
+            if (!queue.push(Entry{ time, frame }))
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // A message that long means the stream is out of sync, start over
+            if (!end)
+            {
+                splitter.reset();
+            }
+            frame.clear();
+        }
+
+        size_t CaptureBuffer::writeQueued()
+        {
+            // Each direction is in order, merge them by time. A direction only runs ahead of the other once the
+            // other's queue is empty, so a long run of messages in one direction doesn't get ahead of the other.
+            size_t written = 0;
+            while (written < 2 * kBatchSize)
+            {
+                if (m_transmitted_index == m_transmitted_count)
+                {
+                    m_transmitted_count = m_transmitted.pop(m_transmitted_batch.data(), kBatchSize);
+                    m_transmitted_index = 0;
+                }
+                if (m_received_index == m_received_count)
+                {
+                    m_received_count = m_received.pop(m_received_batch.data(), kBatchSize);
+                    m_received_index = 0;
+                }
+
+                bool transmitted = m_transmitted_index < m_transmitted_count;
+                bool received = m_received_index < m_received_count;
+                if (!transmitted && !received)
+                {
+                    break;
+                }
+
+                if (!received || (transmitted && m_transmitted_batch[m_transmitted_index].time <=
+                                                     m_received_batch[m_received_index].time))
+                {
+                    const Entry& entry = m_transmitted_batch[m_transmitted_index++];
+                    writeCaptureRecord(*m_output, entry.time, CaptureDirection::HostToDevice, entry.frame.data(),
+                                       entry.frame.size());
+                }
+                else
+                {
+                    const Entry& entry = m_received_batch[m_received_index++];
+                    writeCaptureRecord(*m_output, entry.time, CaptureDirection::DeviceToHost, entry.frame.data(),
+                                       entry.frame.size());
+                }
+                ++written;
+            }
+
+            return written;
+        }
+
+        void CaptureBuffer::flush()
+        {
+#ifndef EMB_SINGLE_THREADED
+            // Taking turns with the background thread, so the queues still only have one consumer at a time
+            std::lock_guard<std::mutex> lock(m_output_mutex);
+#endif
+            while (writeQueued() != 0)
+            {
+            }
+            m_output->flush();
+        }
+
+        size_t CaptureBuffer::dropped() const
+        {
+            return m_dropped;
+        }
+
+        void CaptureBuffer::writeByte(const uint8_t byte)
+        {
+            m_buffer->writeByte(byte);
+            capture(m_transmitted, m_transmit_frame, m_transmit_splitter, byte);
+        }
+
+        uint8_t CaptureBuffer::peek() const
+        {
+            return m_buffer->peek();
+        }
+
+        uint8_t CaptureBuffer::readByte()
+        {
+            uint8_t byte = m_buffer->readByte();
+            capture(m_received, m_receive_frame, m_receive_splitter, byte);
+            return byte;
+        }
+
+        bool CaptureBuffer::empty() const
+        {
+            return m_buffer->empty();
+        }
+
+        size_t CaptureBuffer::size() const
+        {
+            return m_buffer->size();
+        }
+
+        uint8_t CaptureBuffer::messages() const
+        {
+            return m_buffer->messages();
+        }
+
+        size_t CaptureBuffer::capacity() const
+        {
+            return m_buffer->capacity();
+        }
+
+        void CaptureBuffer::update()
+        {
+            m_buffer->update();
+#ifdef EMB_SINGLE_THREADED
+            while (writeQueued() != 0)
+            {
+            }
+#endif
+        }
+
+        void CaptureBuffer::zero()
+        {
+            // The rest of the message being read is gone
+            m_receive_frame.clear();
+            m_receive_splitter.reset();
+            m_buffer->zero();
+        }
+
+        void CaptureBuffer::print() const
+        {
+            m_buffer->print();
+        }
+    }  // namespace host
+}  // namespace emb
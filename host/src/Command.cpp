@@ -1,10 +1,41 @@
 #include "EmbMessenger/Command.hpp"
 
+#ifndef EMB_SINGLE_THREADED
+#include <condition_variable>
+#include <mutex>
+#endif
+
 namespace emb
 {
     namespace host
     {
-        Command::Command() : m_type_index(typeid(Command))
+#ifndef EMB_SINGLE_THREADED
+        namespace
+        {
+            // Waiting threads park on a bucket shared by many commands instead of each command owning a mutex and
+            // condition variable. Notifiers only touch the bucket when somebody is waiting on it.
+            struct alignas(64) WaitBucket
+            {
+                std::mutex mutex;
+                std::condition_variable condition_variable;
+                std::atomic<uint32_t> waiters{ 0 };
+            };
+
+            constexpr size_t kWaitBuckets = 64;
+
+            WaitBucket& waitBucket(const void* address)
+            {
+                static WaitBucket buckets[kWaitBuckets];
+                uintptr_t key = reinterpret_cast<uintptr_t>(address);
+                return buckets[((key >> 4) ^ (key >> 12)) % kWaitBuckets];
+            }
+        }  // namespace
+#endif
+
+        Command::Command() :
+            m_type_index(typeid(Command)),
+            m_command_state(CommandState::NotSent),
+            m_continuation_state(ContinuationState::None)
         {
         }
 
@@ -35,13 +66,102 @@ namespace emb
             return m_command_state;
         }
 
+        std::exception_ptr Command::getException() const
+        {
+            return m_exception;
+        }
+
+        void Command::setTimeout(std::chrono::milliseconds timeout)
+        {
+            m_timeout = timeout;
+        }
+
+        std::chrono::milliseconds Command::getTimeout() const
+        {
+            return m_timeout;
+        }
+
+        bool Command::isPeriodic() const
+        {
+            return m_is_periodic;
+        }
+
+        void Command::complete()
+        {
+            // Sequentially consistent with the waiter count, either the waiter sees the new state or we see the waiter
+            m_command_state = CommandState::Received;
+
+#ifndef EMB_SINGLE_THREADED
+            WaitBucket& bucket = waitBucket(this);
+            if (bucket.waiters != 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(bucket.mutex);
+                }
+                bucket.condition_variable.notify_all();
+            }
+#endif
+
+            if (m_continuation_state.exchange(ContinuationState::Fired) == ContinuationState::Set)
+            {
+                m_continuation(m_continuation_argument);
+            }
+        }
+
+        void Command::fail(std::exception_ptr exception)
+        {
+            m_exception = exception;
+            complete();
+        }
+
+        bool Command::setContinuation(void (*continuation)(void*), void* argument)
+        {
+            m_continuation = continuation;
+            m_continuation_argument = argument;
+            return m_continuation_state.exchange(ContinuationState::Set) != ContinuationState::Fired;
+        }
+
 #ifndef EMB_SINGLE_THREADED
         void Command::wait()
         {
-            m_is_waiting = true;
-            std::unique_lock<std::mutex> lk(m_mutex);
-            m_condition_variable.wait(lk, [&] { return m_command_state == CommandState::Received; });
+            if (m_command_state == CommandState::Received)
+            {
+                return;
+            }
+
+            WaitBucket& bucket = waitBucket(this);
+            ++bucket.waiters;
+            {
+                std::unique_lock<std::mutex> lock(bucket.mutex);
+                bucket.condition_variable.wait(lock, [&] { return m_command_state == CommandState::Received; });
+            }
+            --bucket.waiters;
+        }
+
+        bool Command::waitFor(std::chrono::nanoseconds timeout)
+        {
+            return waitUntil(std::chrono::steady_clock::now() + timeout);
+        }
+
+        bool Command::waitUntil(std::chrono::steady_clock::time_point deadline)
+        {
+            if (m_command_state == CommandState::Received)
+            {
+                return true;
+            }
+
+            WaitBucket& bucket = waitBucket(this);
+            bool received = false;
+            ++bucket.waiters;
+            {
+                std::unique_lock<std::mutex> lock(bucket.mutex);
+                received = bucket.condition_variable.wait_until(
+                    lock, deadline, [&] { return m_command_state == CommandState::Received; });
+            }
+            --bucket.waiters;
+
+            return received;
         }
 #endif
     }  // namespace host
-}  // namespace emb
\ No newline at end of file
+}  // namespace emb
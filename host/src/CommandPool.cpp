@@ -0,0 +1,85 @@
+#include "EmbMessenger/CommandPool.hpp"
+
+#include <new>
+
+namespace emb
+{
+    namespace host
+    {
+        constexpr size_t CommandPool::kBlockAlignment;
+        constexpr size_t CommandPool::kMaxBlockSize;
+
+        // Index of the free list for blocks of the given size
+        static size_t sizeClass(size_t bytes)
+        {
+            return (bytes + CommandPool::kBlockAlignment - 1) / CommandPool::kBlockAlignment - 1;
+        }
+
+        CommandPool::CommandPool() : m_free_blocks(), m_system_allocations(0)
+        {
+        }
+
+        CommandPool::~CommandPool()
+        {
+            for (Block*& head : m_free_blocks)
+            {
+                while (head != nullptr)
+                {
+                    Block* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+
+        void* CommandPool::allocate(size_t bytes)
+        {
+            if (bytes == 0 || bytes > kMaxBlockSize)
+            {
+                return ::operator new(bytes);
+            }
+
+            size_t index = sizeClass(bytes);
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+                Block* block = m_free_blocks[index];
+                if (block != nullptr)
+                {
+                    m_free_blocks[index] = block->next;
+                    return block;
+                }
+                ++m_system_allocations;
+            }
+
+            return ::operator new((index + 1) * kBlockAlignment);
+        }
+
+        void CommandPool::deallocate(void* pointer, size_t bytes)
+        {
+            if (bytes == 0 || bytes > kMaxBlockSize)
+            {
+                ::operator delete(pointer);
+                return;
+            }
+
+            size_t index = sizeClass(bytes);
+            Block* block = static_cast<Block*>(pointer);
+
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            block->next = m_free_blocks[index];
+            m_free_blocks[index] = block;
+        }
+
+        size_t CommandPool::systemAllocations()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return m_system_allocations;
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,102 @@
+#include "EmbMessenger/CommandTable.hpp"
+#include "EmbMessenger/Command.hpp"
+#include "EmbMessenger/Exceptions.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        CommandTable::CommandTable(size_t capacity) : m_next_message_id(0), m_size(0)
+        {
+            if (capacity == 0 || capacity > 0x8000)
+            {
+                throw std::invalid_argument("CommandTable capacity must be between 1 and 32768");
+            }
+
+            // Round up to a power of two so the slots divide the message ID space evenly
+            size_t slots = 1;
+            while (slots < capacity)
+            {
+                slots <<= 1;
+            }
+
+            m_slots.resize(slots);
+            m_mask = static_cast<uint16_t>(slots - 1);
+        }
+
+        uint16_t CommandTable::insert(std::shared_ptr<Command> command)
+        {
+            if (m_size == m_slots.size())
+            {
+                throw OutOfCommandSlots("Too many commands are waiting on the device", command);
+            }
+
+            // Skip message IDs whose slot is still in use, there is at least one free slot
+            while (m_slots[m_next_message_id & m_mask].command != nullptr)
+            {
+                ++m_next_message_id;
+            }
+
+            uint16_t message_id = m_next_message_id++;
+            Slot& slot = m_slots[message_id & m_mask];
+            slot.command = std::move(command);
+            slot.message_id = message_id;
+            ++m_size;
+
+            return message_id;
+        }
+
+        void CommandTable::assign(uint16_t message_id, std::shared_ptr<Command> command)
+        {
+            Slot& slot = m_slots[message_id & m_mask];
+            if (slot.command == nullptr)
+            {
+                ++m_size;
+            }
+            slot.command = std::move(command);
+            slot.message_id = message_id;
+        }
+
+        std::shared_ptr<Command> CommandTable::find(uint16_t message_id) const
+        {
+            const Slot& slot = m_slots[message_id & m_mask];
+            if (slot.command == nullptr || slot.message_id != message_id)
+            {
+                return nullptr;
+            }
+            return slot.command;
+        }
+
+        bool CommandTable::erase(uint16_t message_id)
+        {
+            Slot& slot = m_slots[message_id & m_mask];
+            if (slot.command == nullptr || slot.message_id != message_id)
+            {
+                return false;
+            }
+
+            slot.command = nullptr;
+            --m_size;
+            return true;
+        }
+
+        void CommandTable::clear()
+        {
+            for (Slot& slot : m_slots)
+            {
+                slot.command = nullptr;
+            }
+            m_size = 0;
+        }
+
+        size_t CommandTable::size() const
+        {
+            return m_size;
+        }
+
+        size_t CommandTable::capacity() const
+        {
+            return m_slots.size();
+        }
+    }  // namespace host
+}  // namespace emb
@@ -1,255 +1,221 @@
 #include "EmbMessenger/DebugBuffer.hpp"
-#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/ProtocolLog.hpp"
 
-#include <cstdio>
-#include <sstream>
-#include <iomanip>
+#include <stdexcept>
 
 namespace emb
 {
     namespace host
     {
-        // Helper for getting the number of used bytes
-        constexpr const uint8_t getWidth(uint16_t value16)
+        constexpr size_t DebugBuffer::kBatchSize;
+
+        namespace
         {
-            return (value16 == static_cast<uint8_t>(value16)) ? 2 : 4;
-        }
+            DebugSeverity severityOf(const ProtocolEvent& event)
+            {
+                switch (event.type)
+                {
+                    case ProtocolEventType::Value:
+                        return DebugSeverity::Trace;
+                    case ProtocolEventType::Address:
+                    case ProtocolEventType::Message:
+                    case ProtocolEventType::Command:
+                        return DebugSeverity::Info;
+                    case ProtocolEventType::EndOfMessage:
+                        return event.crc_valid ? DebugSeverity::Info : DebugSeverity::Error;
+                    default:
+                        return DebugSeverity::Error;
+                }
+            }
+        }  // namespace
 
-        // Helper for getting the number of used bytes
-        constexpr const uint8_t getWidth(uint32_t value32)
+        DebugBuffer::Direction::Direction(size_t capacity) : queue(capacity)
         {
-            return (value32 == static_cast<uint16_t>(value32)) ? getWidth(static_cast<uint16_t>(value32)) : 8;
         }
 
-        // Helper for getting the number of used bytes
-        constexpr const uint8_t getWidth(uint64_t value64)
+        DebugBuffer::DebugBuffer(std::shared_ptr<emb::shared::IBuffer> buffer,
+                                 std::function<void(std::string)> print_func, DebugOptions options) :
+            m_real_buffer(buffer),
+            m_print_func(print_func),
+            m_options(options),
+            m_write(options.capacity),
+            m_read(options.capacity),
+            m_sequence(0),
+            m_dropped(0),
+            m_write_batch(kBatchSize),
+            m_read_batch(kBatchSize),
+            m_write_index(0),
+            m_write_count(0),
+            m_read_index(0),
+            m_read_count(0)
         {
-            return (value64 == static_cast<uint32_t>(value64)) ? getWidth(static_cast<uint32_t>(value64)) : 16;
+            if (m_options.sample_every == 0)
+            {
+                throw std::invalid_argument("DebugBuffer must sample at least one of every message");
+            }
+
+#ifndef EMB_SINGLE_THREADED
+            m_decoding = true;
+            m_decoder = std::thread(&DebugBuffer::decodeThread, this);
+#endif
         }
 
-        DebugBuffer::DecodeBuffer::DecodeBuffer(BufferType type, std::function<void(std::string)> print_func) :
-            m_type(type), m_print_func(print_func)
+        DebugBuffer::~DebugBuffer()
         {
-            zero();
+#ifndef EMB_SINGLE_THREADED
+            m_decoding = false;
+            m_decoder.join();
+#endif
+            flush();
         }
 
-        // Primary function decoding a message
-        void DebugBuffer::DecodeBuffer::decode()
+#ifndef EMB_SINGLE_THREADED
+        void DebugBuffer::decodeThread()
         {
-            using namespace emb::shared;
-            Reader reader(this);
-            uint16_t message_id;
-            uint16_t param = 0;
-            std::stringstream ss;
-
-            // All messages have a message id
-            if (!reader.read(message_id))
-            {
-                m_print_func("Error reading message id");
-            }
-            ss << (m_type == BufferType::Write ? "Write" : "Read ") << " Message Id: " << message_id;
-            m_print_func(ss.str());
-            ss.str("");
-
-            // Messages from the host have command ids
-            if (m_type == BufferType::Write)
+            while (true)
             {
-                uint16_t command_id = 0;
-                if (!reader.read(command_id))
+                size_t decoded = 0;
                 {
-                    m_print_func("Write Error reading command id");
+                    std::lock_guard<std::mutex> lock(m_decode_mutex);
+                    decoded = decodeQueued();
                 }
-                ss << "Write Command Id: " << command_id;
-                m_print_func(ss.str());
-                ss.str("");
-            }
 
-            emb::shared::DataType type;
-            while (reader.getType(type))
-            {
-                // Print the message's source
-                ss.str("");
-                if (m_type == BufferType::Read)
-                {
-                    ss << "Read  ";
-                }
-                else if (m_type == BufferType::Write)
+                if (decoded == 0)
                 {
-                    ss << "Write ";
-                }
-
-                // Print the parameter index
-                ss << std::setw(3) << param << ": ";
+                    if (!m_decoding)
+                    {
+                        break;
+                    }
 
-                switch (type)
-                {
-                    case kNull: {
-                        // Read the null parameter
-                        reader.readNull();
-                        ss << "Null";
-                    } break;
-
-                    case kBoolFalse:
-                    case kBoolTrue: {
-                        // Read the bool parameter
-                        bool value;
-                        reader.read(value);
-                        ss << (value) ? "True" : "False";
-                    } break;
-
-                    case kPosFixInt:
-                    case kUint8:
-                    case kUint16:
-                    case kUint32:
-                    case kUint64: {
-                        // Read the unsigned integer parameter
-                        uint64_t value;
-                        reader.read(value);
-                        // Print it with '0x' and leading 0's
-                        ss << value << " 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(getWidth(value)) << value
-                           << std::setfill(' ') << std::dec;
-                    } break;
-
-                    case kNegFixInt:
-                    case kInt8:
-                    case kInt16:
-                    case kInt32:
-                    case kInt64: {
-                        // Read the integer parameter
-                        int64_t value;
-                        reader.read(value);
-                        ss << value;
-                        if (type == kInt8 && value >= 0x20 && value <= 0x7E) // If the int is a printable char
-                        {
-                            ss << " '" << static_cast<int8_t>(type) << "'";
-                        }
-                    } break;
-
-                    case kFloat: {
-                        // Read the float parameter
-                        float value;
-                        reader.read(value);
-                        ss << value;
-                    } break;
-
-                    case kError: {
-                        // Read the error code
-                        uint8_t code;
-                        reader.readError(code);
-                        ss << +code << " 0x" << std::hex << +code;
-
-                        // Read the associated data
-                        int16_t data;
-                        reader.read(data);
-                        ss << " " << data;
-                    } break;
-
-                    case kEndOfMessage: {
-                        // Read end of message and check the CRC
-                        ss.str("");
-                        ss << (m_type == BufferType::Write ? "Write" : "Read ") << " Message " << message_id << " CRC "
-                           << (reader.readCrc() ? "Valid" : "Invalid");
-                    } break;
-
-                    default: {
-                        // Most likely a rogue print statement in the device code
-                        ss << "Unknown Type";
-                    } break;
+                    // Polled so intercepting a message never has to wake the decoder
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
                 }
-                m_print_func(ss.str());
-                ++param;
             }
         }
+#endif
 
-        void DebugBuffer::DecodeBuffer::writeByte(const uint8_t byte)
+        // Copy the byte into the direction's frame, and queue the frame once the message is complete
+        void DebugBuffer::intercept(Direction& direction, uint8_t byte)
         {
-            m_buf.emplace_back(byte);
-            if (m_writeBytes == 0)
-            {
-                m_writeType = (emb::shared::DataType)byte;
-                m_writeBytes = emb::shared::dataBytes(m_writeType);
-            }
-            else
+            bool end = direction.splitter.push(byte);
+            if (direction.sampled)
             {
-                --m_writeBytes;
+                direction.frame.writeByte(byte);
             }
 
-            if (m_writeBytes == 0 && m_writeType == emb::shared::DataType::kEndOfMessage)
+            if (!end && !direction.frame.overflowed())
             {
-                ++m_numberMessages;
-                decode();
+                return;
             }
-        }
-
-        uint8_t DebugBuffer::DecodeBuffer::peek() const
-        {
-            return m_buf.at(0);
-        }
 
-        uint8_t DebugBuffer::DecodeBuffer::readByte()
-        {
-            uint8_t byte = m_buf.at(0);
-            m_buf.erase(m_buf.begin());
-
-            if (m_readBytes == 0)
-            {
-                m_readType = (emb::shared::DataType)byte;
-                m_readBytes = emb::shared::dataBytes(m_readType);
-            }
-            else
+            if (direction.sampled &&
+                !direction.queue.push(Entry{ m_sequence.fetch_add(1, std::memory_order_relaxed), direction.frame }))
             {
-                --m_readBytes;
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
             }
 
-            if (m_readBytes == 0 && m_readType == emb::shared::DataType::kEndOfMessage)
+            // A message that long means the stream is out of sync, start over
+            if (!end)
             {
-                --m_numberMessages;
+                direction.splitter.reset();
             }
+            direction.frame.clear();
 
-            return byte;
+            ++direction.messages;
+            direction.sampled = direction.messages % m_options.sample_every == 0;
         }
 
-        bool DebugBuffer::DecodeBuffer::empty() const
+        size_t DebugBuffer::decodeQueued()
         {
-            return m_buf.empty();
-        }
+            // Each direction is in order, merge them by sequence. A direction only runs ahead of the other once the
+            // other's queue is empty.
+            size_t decoded = 0;
+            while (decoded < 2 * kBatchSize)
+            {
+                if (m_write_index == m_write_count)
+                {
+                    m_write_count = m_write.queue.pop(m_write_batch.data(), kBatchSize);
+                    m_write_index = 0;
+                }
+                if (m_read_index == m_read_count)
+                {
+                    m_read_count = m_read.queue.pop(m_read_batch.data(), kBatchSize);
+                    m_read_index = 0;
+                }
 
-        size_t DebugBuffer::DecodeBuffer::size() const
-        {
-            return m_buf.size();
+                bool written = m_write_index < m_write_count;
+                bool read = m_read_index < m_read_count;
+                if (!written && !read)
+                {
+                    break;
+                }
+
+                if (!read || (written && m_write_batch[m_write_index].sequence < m_read_batch[m_read_index].sequence))
+                {
+                    decode(CaptureDirection::HostToDevice, m_write_batch[m_write_index++].frame);
+                }
+                else
+                {
+                    decode(CaptureDirection::DeviceToHost, m_read_batch[m_read_index++].frame);
+                }
+                ++decoded;
+            }
+
+            return decoded;
         }
 
-        uint8_t DebugBuffer::DecodeBuffer::messages() const
+        void DebugBuffer::print(DebugSeverity severity, const std::string& line) const
         {
-            return m_numberMessages;
+            if (severity >= m_options.severity)
+            {
+                m_print_func(line);
+            }
         }
 
-        void DebugBuffer::DecodeBuffer::update()
+        // Decode a message into events, and print the ones that are severe enough
+        void DebugBuffer::decode(CaptureDirection direction, const Frame& frame)
         {
+            if (frame.overflowed())
+            {
+                const char* source = (direction == CaptureDirection::HostToDevice ? "Write" : "Read ");
+                print(DebugSeverity::Error,
+                      std::string(source) + " Message longer than " + std::to_string(Frame::kMaxFrameSize) + " bytes");
+                return;
+            }
+
+            m_events.clear();
+            decodeMessage(direction, std::chrono::nanoseconds(0), frame.data(), frame.size(), m_events,
+                          m_options.addressed);
+            for (const ProtocolEvent& event : m_events)
+            {
+                // Only format the lines that get printed
+                if (severityOf(event) >= m_options.severity)
+                {
+                    m_print_func(formatEvent(event));
+                }
+            }
         }
 
-        void DebugBuffer::DecodeBuffer::zero()
+        void DebugBuffer::flush()
         {
-            m_buf.clear();
-            m_readType = emb::shared::DataType::kNull;
-            m_readBytes = 0;
-            m_writeType = emb::shared::DataType::kNull;
-            m_writeBytes = 0;
-            m_numberMessages = 0;
+#ifndef EMB_SINGLE_THREADED
+            // Taking turns with the background thread, so the queues still only have one consumer at a time
+            std::lock_guard<std::mutex> lock(m_decode_mutex);
+#endif
+            while (decodeQueued() != 0)
+            {
+            }
         }
 
-        DebugBuffer::DebugBuffer(std::shared_ptr<emb::shared::IBuffer> buffer,
-                                 std::function<void(std::string)> print_func) :
-            m_real_buffer(buffer),
-            m_read_buffer(BufferType::Read, print_func),
-            m_write_buffer(BufferType::Write, print_func)
+        size_t DebugBuffer::dropped() const
         {
+            return m_dropped;
         }
 
-        // Copy the byte into the write decode buffer, then forward it to the real buffer
+        // Copy the byte into the write queue, then forward it to the real buffer
         void DebugBuffer::writeByte(const uint8_t byte)
         {
-            m_write_buffer.writeByte(byte);
+            intercept(m_write, byte);
             m_real_buffer->writeByte(byte);
         }
 
@@ -259,11 +225,11 @@ namespace emb
             return m_real_buffer->peek();
         }
 
-        // Read the byte from the real buffer, copy it into the read decode buffer, then forward it
+        // Read the byte from the real buffer, copy it into the read queue, then forward it
         uint8_t DebugBuffer::readByte()
         {
             uint8_t byte = m_real_buffer->readByte();
-            m_read_buffer.writeByte(byte);
+            intercept(m_read, byte);
             return byte;
         }
 
@@ -285,18 +251,35 @@ namespace emb
             return m_real_buffer->messages();
         }
 
-        // Update the real buffer
+        // Use the real buffer's capacity
+        size_t DebugBuffer::capacity() const
+        {
+            return m_real_buffer->capacity();
+        }
+
+        // Update the real buffer, and print the queued messages in the Single Threaded EmbMessenger
         void DebugBuffer::update()
         {
             m_real_buffer->update();
+#ifdef EMB_SINGLE_THREADED
+            while (decodeQueued() != 0)
+            {
+            }
+#endif
         }
 
-        // Zero out all buffers
+        // Drop the rest of the message being read, and zero out the real buffer
         void DebugBuffer::zero()
         {
-            m_read_buffer.zero();
-            m_write_buffer.zero();
+            m_read.frame.clear();
+            m_read.splitter.reset();
             m_real_buffer->zero();
         }
+
+        // Use the real buffer's print
+        void DebugBuffer::print() const
+        {
+            m_real_buffer->print();
+        }
     }  // namespace host
 }  // namespace emb
@@ -1,31 +1,108 @@
 #include "EmbMessenger/EmbMessenger.hpp"
+#include "EmbMessenger/BusAddress.hpp"
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/Crc.hpp"
+#include "EmbMessenger/IAddressable.hpp"
 #include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <thread>
 
+#if !defined(EMB_SINGLE_THREADED) && defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace emb
 {
     namespace host
     {
+#ifndef EMB_SINGLE_THREADED
+        namespace
+        {
+            // Naming and pinning threads is best effort, it's only supported on Linux
+            void configureThread(std::thread& thread, int cpu, const char* name)
+            {
+#ifdef __linux__
+                if (name != nullptr)
+                {
+                    pthread_setname_np(thread.native_handle(), name);
+                }
+
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                {
+                    cpu_set_t cpus;
+                    CPU_ZERO(&cpus);
+                    CPU_SET(cpu, &cpus);
+                    pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+                }
+#else
+                (void)thread;
+                (void)cpu;
+                (void)name;
+#endif
+            }
+        }  // namespace
+#endif
+
 #ifdef EMB_SINGLE_THREADED
-        EmbMessenger::EmbMessenger(std::shared_ptr<shared::IBuffer> buffer, std::chrono::milliseconds init_timeout) :
+        EmbMessenger::EmbMessenger(std::shared_ptr<shared::IBuffer> buffer, std::chrono::milliseconds init_timeout,
+                                   size_t command_capacity) :
 #else
         EmbMessenger::EmbMessenger(std::shared_ptr<shared::IBuffer> buffer,
                                    std::function<bool(std::exception_ptr)> exception_handler,
-                                   std::chrono::milliseconds init_timeout) :
-            m_exception_handler(exception_handler),
+                                   std::chrono::milliseconds init_timeout, ThreadOptions thread_options,
+                                   size_t command_capacity) :
 #endif
             m_buffer(buffer),
-            m_writer(buffer.get()),
-            m_reader(buffer.get())
+            m_reader(&m_received_frame),
+            m_addressed(dynamic_cast<IAddressable*>(buffer.get()) != nullptr),
+            m_address(m_addressed ? dynamic_cast<IAddressable*>(buffer.get())->address() : 0),
+            m_commands(command_capacity),
+            m_command_pool(std::make_shared<CommandPool>()),
+            m_completion_queue(nullptr),
+            m_dropped_completions(0),
+#ifdef EMB_SINGLE_THREADED
+            // Only the messages waiting on credit are queued, each one holds a command slot
+            m_frame_queue(command_capacity),
+#endif
+            m_flow_control(false),
+            m_window_bytes(0),
+            m_window_messages(0),
+            m_bytes_in_flight(0),
+            m_messages_in_flight(0),
+            m_retransmission(false),
+            m_retransmit_timeout(0),
+            m_max_retries(0),
+            m_retransmissions(0),
+            m_timers(2 * m_commands.capacity() + 1),
+            m_deadline_message_ids(m_commands.capacity()),
+            m_default_timeout(0),
+            m_next_tick(std::numeric_limits<TimerWheel::clock_t::rep>::max()),
+            m_timeouts(0),
+            m_sent_messages(m_commands.capacity()),
+            m_last_response(TimerWheel::clock_t::now().time_since_epoch().count()),
+            m_last_activity(m_last_response.load()),
+            m_keepalive_interval(0),
+            m_keepalive_due(false),
+            m_keepalives_sent(0),
+            m_keepalives_missed(0)
+#ifndef EMB_SINGLE_THREADED
+            , m_exception_handler(exception_handler),
+            m_thread_options(thread_options),
+            m_writing(true),
+            m_writer_waiting(false),
+            m_pending_callbacks(0),
+            m_dropped_samples(0)
+#endif
         {
-            m_message_id = 0;
-
             registerCommand<ResetCommand>(0xFFFF);
             registerCommand<RegisterPeriodicCommand>(0xFFFE);
             registerCommand<UnregisterPeriodicCommand>(0xFFFD);
+            registerCommand<BufferCapacityCommand>(0xFFFC);
+            registerCommand<KeepaliveCommand>(0xFFFC);
 
             using clock_t = std::chrono::steady_clock;
             bool initializing = true;
@@ -33,7 +110,7 @@ namespace emb
 
             while (clock_t::now() < initializingEnd && initializing)
             {
-                auto resetCommand = std::make_shared<ResetCommand>();
+                auto resetCommand = makeCommand<ResetCommand>();
                 resetCommand->setCallback<ResetCommand>([&](auto&& cmd) { initializing = false; });
                 send(resetCommand);
 
@@ -59,6 +136,9 @@ namespace emb
             {
                 m_commands.clear();
                 m_buffer->zero();
+
+                // The responses to the resets may be stale ones from before, they don't measure the link
+                m_rtt.reset();
             }
             else
             {
@@ -66,7 +146,19 @@ namespace emb
             }
 
 #ifndef EMB_SINGLE_THREADED
-            m_update_thread = std::thread(&EmbMessenger::updateThread, this);
+            if (m_thread_options.transmit_mode == TransmitMode::Dedicated)
+            {
+                m_write_thread = std::thread(&EmbMessenger::writeThread, this);
+                configureThread(m_write_thread, m_thread_options.transmit_cpu, m_thread_options.transmit_name);
+            }
+
+            // Set before the update thread starts, a destructor that runs first mustn't have it set back
+            m_running = true;
+            if (m_thread_options.receive_mode != ReceiveMode::External)
+            {
+                m_update_thread = std::thread(&EmbMessenger::updateThread, this);
+                configureThread(m_update_thread, m_thread_options.receive_cpu, m_thread_options.receive_name);
+            }
 #endif
         }
 
@@ -74,7 +166,25 @@ namespace emb
         EmbMessenger::~EmbMessenger()
         {
             m_running = false;
-            m_update_thread.join();
+            if (m_update_thread.joinable())
+            {
+                m_update_thread.join();
+            }
+
+            if (m_write_thread.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_write_mutex);
+                    m_writing = false;
+                }
+                m_write_condition.notify_one();
+                m_write_thread.join();
+            }
+
+            while (m_pending_callbacks != 0)
+            {
+                std::this_thread::yield();
+            }
         }
 
         bool EmbMessenger::running() const
@@ -87,37 +197,205 @@ namespace emb
             m_running = false;
         }
 
+        size_t EmbMessenger::poll()
+        {
+            if (m_update_thread.joinable())
+            {
+                throw std::logic_error("Only an EmbMessenger with ReceiveMode::External can be polled");
+            }
+
+            if (!m_running)
+            {
+                return 0;
+            }
+
+            m_receive_thread = std::this_thread::get_id();
+            size_t processed = 0;
+            try
+            {
+                processed = processMessages(std::numeric_limits<size_t>::max());
+            }
+            catch (...)
+            {
+                processed = 1;
+                if (m_exception_handler && m_exception_handler(std::current_exception()))
+                {
+                    m_running = false;
+                }
+            }
+            m_receive_thread = std::thread::id();
+            return processed;
+        }
+
         void EmbMessenger::updateThread()
         {
-            m_running = true;
+            m_receive_thread = std::this_thread::get_id();
 
             while (m_running)
             {
                 try
                 {
-                    update();
+                    processMessages(std::numeric_limits<size_t>::max());
                 }
                 catch (...)
                 {
-                    if (m_exception_handler)
+                    // Only ever stops the thread, the destructor may have stopped it meanwhile
+                    if (m_exception_handler && m_exception_handler(std::current_exception()))
                     {
-                        m_running = !m_exception_handler(std::current_exception());
+                        m_running = false;
                     }
+                }
+            }
+        }
 
-#ifndef EMB_SINGLE_THREADED
-                    if (m_current_command != nullptr)
+        void EmbMessenger::writeThread()
+        {
+            Frame frame;
+
+            while (true)
+            {
+                bool wrote = false;
+                while (m_frame_queue.pop(frame))
+                {
+                    writeFrame(frame);
+                    wrote = true;
+                }
+
+                if (wrote)
+                {
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_write_mutex);
+                if (!m_writing)
+                {
+                    break;
+                }
+
+                // Pairs with the fence in flushFrame, either we see the new frame or the sender sees us waiting
+                m_writer_waiting = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_write_condition.wait(lock, [this] { return !m_frame_queue.empty() || !m_writing; });
+                m_writer_waiting = false;
+            }
+        }
+#endif
+
+        namespace
+        {
+            // Counts the bytes a batch takes out of the buffer, however the batch ends
+            class ReceivedBytes
+            {
+                Metrics& m_metrics;
+                shared::IBuffer& m_buffer;
+                size_t m_size;
+
+            public:
+                ReceivedBytes(Metrics& metrics, shared::IBuffer& buffer) :
+                    m_metrics(metrics),
+                    m_buffer(buffer),
+                    m_size(buffer.size())
+                {
+                }
+
+                ~ReceivedBytes()
+                {
+                    size_t size = m_buffer.size();
+                    if (size < m_size)
                     {
-                        m_current_command->m_command_state = CommandState::Received;
-                        if (m_current_command->m_is_waiting)
-                        {
-                            m_current_command->m_condition_variable.notify_all();
-                        }
+                        m_metrics.countReceivedBytes(m_size - size);
                     }
-#endif
                 }
+            };
+
+            // Each thread encodes its commands into its own frame, so senders never share a writer
+            struct StagingFrame
+            {
+                Frame frame;
+                shared::Writer writer;
+
+                StagingFrame() : writer(&frame)
+                {
+                }
+            };
+
+            StagingFrame& stagingFrame()
+            {
+                static thread_local StagingFrame staging;
+                return staging;
             }
+        }  // namespace
+
+        shared::Writer& EmbMessenger::frameWriter()
+        {
+            return stagingFrame().writer;
         }
+
+        void EmbMessenger::flushFrame(const Frame& frame, bool take_credit)
+        {
+#ifndef EMB_SINGLE_THREADED
+            // Before the write thread starts the constructor writes its messages itself
+            if (m_thread_options.transmit_mode == TransmitMode::Dedicated && m_write_thread.joinable())
+            {
+                while (!m_frame_queue.push(frame))
+                {
+                    m_write_condition.notify_one();
+                    std::this_thread::yield();
+                }
+
+                // Pairs with the fence in writeThread, either we see the writer waiting or it sees the new frame
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_writer_waiting)
+                {
+                    std::lock_guard<std::mutex> lock(m_write_mutex);
+                    m_write_condition.notify_one();
+                }
+                return;
+            }
+
+            // The credit was taken by acquireCredit, before the message was encoded
+            (void)take_credit;
+            std::lock_guard<std::mutex> lock(m_write_mutex);
+#else
+            if (m_flow_control && take_credit)
+            {
+                // Nothing jumps the queue, the messages are written in the order they were sent
+                if (!m_frame_queue.empty() || !hasCredit(frame.size()))
+                {
+                    if (!m_frame_queue.push(frame))
+                    {
+                        throw OutOfCommandSlots("Too many messages are waiting on flow control credit");
+                    }
+                    return;
+                }
+
+                m_bytes_in_flight += frame.size();
+                ++m_messages_in_flight;
+            }
 #endif
+            writeFrame(frame);
+        }
+
+        void EmbMessenger::writeFrame(const Frame& frame)
+        {
+            const uint8_t* data = frame.data();
+            for (size_t i = 0; i < frame.size(); ++i)
+            {
+                m_buffer->writeByte(data[i]);
+            }
+            m_metrics.countTransmitted(frame.size());
+            EMB_TRACE(m_tracer, frameFlushed, data, frame.size());
+        }
+
+        std::shared_ptr<CommandPool> EmbMessenger::getCommandPool() const
+        {
+            return m_command_pool;
+        }
+
+        std::shared_ptr<shared::IBuffer> EmbMessenger::getBuffer() const
+        {
+            return m_buffer;
+        }
 
         std::shared_ptr<Command> EmbMessenger::send(std::shared_ptr<Command> command)
         {
@@ -137,151 +415,459 @@ namespace emb
 
         std::shared_ptr<Command> EmbMessenger::send(std::shared_ptr<Command> command, uint16_t command_id)
         {
-            command->m_message_id = m_message_id;
+            // Set before the command is visible to the update thread, the response may arrive before send returns
+            command->m_exception = nullptr;
+            command->m_continuation_state = Command::ContinuationState::None;
+            command->m_command_state = CommandState::Sent;
+
+#ifndef EMB_SINGLE_THREADED
+            // The callback of its last response is still reading its values. It is sent once the callback returns, so
+            // its next response never has to wait on the executor.
+            command->m_deferred_command_id = command_id;
+            Command::CallbackState callback_state = command->m_callback_state;
+            while (callback_state != Command::CallbackState::Idle)
+            {
+                if (command->m_callback_state.compare_exchange_weak(callback_state,
+                                                                    Command::CallbackState::PendingSend))
+                {
+                    return command;
+                }
+            }
+#endif
+
             {
 #ifndef EMB_SINGLE_THREADED
                 std::lock_guard<std::mutex> lock(m_commands_mutex);
 #endif
-                m_commands.emplace(m_message_id, command);
+                try
+                {
+                    command->m_message_id = m_commands.insert(command);
+                }
+                catch (...)
+                {
+                    command->m_command_state = CommandState::NotSent;
+                    throw;
+                }
             }
 
-            write(m_message_id++, command_id);
-            command->send(this);
-            command->m_command_state = CommandState::Sent;
-            m_writer.writeCrc();
+            StagingFrame& staging = stagingFrame();
+            staging.frame.clear();
+            staging.writer = shared::Writer(&staging.frame);
 
-            return command;
-        }
+            try
+            {
+                if (m_addressed)
+                {
+                    write(m_address);
+                }
+                write(command->m_message_id, command_id);
+                command->send(this);
+                staging.writer.writeCrc();
 
-        void EmbMessenger::update()
-        {
-            m_buffer->update();
+                if (staging.frame.overflowed())
+                {
+                    throw FrameTooLarge("The command's message is longer than " +
+                                            std::to_string(Frame::kMaxFrameSize) + " bytes",
+                                        command);
+                }
+                EMB_TRACE(m_tracer, frameEncoded, command->m_message_id, command_id, staging.frame.data(),
+                          staging.frame.size());
 
-            if (m_buffer->messages() == 0)
-            {
-                return;
-            }
+                if (m_retransmission)
+                {
+#ifndef EMB_SINGLE_THREADED
+                    std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+                    // Stored before the message is written, the response can't arrive before it
+                    PendingFrame& pending = pendingFrame(command->m_message_id);
+                    pending.frame.assign(staging.frame.data(), staging.frame.size());
+                    pending.message_id = command->m_message_id;
+                    pending.retries = m_max_retries;
+                    pending.active = true;
+                }
 
-            m_reader.resetCrc();
+                acquireCredit(*command, staging.frame.size());
+                flushFrame(staging.frame);
 
-            try
-            {
-                readErrors();
+#ifdef EMB_SINGLE_THREADED
+                // Left at the back of the queue for credit, flushPendingFrames starts the timers when it is written.
+                // Otherwise a retransmission could be written before the message itself.
+                if (!m_frame_queue.empty())
+                {
+                    m_queued_commands.push_back(QueuedCommand{ command, command_id });
+                    return command;
+                }
+#endif
+
+                // The timers start once the message is written, it may have had to wait for credit
+                startTimers(command, command_id);
             }
             catch (...)
             {
-                consumeMessage();
+                {
+#ifndef EMB_SINGLE_THREADED
+                    std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+                    m_commands.erase(command->m_message_id);
+                    cancelTimers(command->m_message_id);
+                }
+                command->m_command_state = CommandState::NotSent;
                 throw;
             }
 
-            uint16_t message_id = 0;
-            if (!m_reader.read(message_id))
-            {
-                consumeMessage();
-                throw MessageIdReadError(ExceptionSource::Host, "Error reading message Id");
-            }
+            return command;
+        }
 
+        void EmbMessenger::broadcast(std::shared_ptr<Command> command)
+        {
+            std::type_index type_index = command->getTypeIndex();
+            uint16_t command_id = 0;
             try
             {
-#ifndef EMB_SINGLE_THREADED
-                std::lock_guard<std::mutex> lock(m_commands_mutex);
-#endif
-                m_current_command = m_commands.at(message_id);
+                command_id = m_command_ids.at(type_index);
             }
-            catch (std::out_of_range e)
+            catch (const std::out_of_range& e)
             {
-                consumeMessage();
-                throw MessageIdInvalid("No command to receive message from the device", m_current_command);
+                throw UnregisteredCommand("The command was not registered.");
             }
 
-            m_parameter_index = 0;
-            try
+            broadcast(command, command_id);
+        }
+
+        void EmbMessenger::broadcast(std::shared_ptr<Command> command, uint16_t command_id)
+        {
+            if (!m_addressed)
             {
-                m_current_command->receive(this);
+                throw std::logic_error("Only an EmbMessenger on a bus can broadcast");
             }
-            catch (...)
+
+            StagingFrame& staging = stagingFrame();
+            staging.frame.clear();
+            staging.writer = shared::Writer(&staging.frame);
+
+            // The devices don't respond or remember broadcasts, so they don't need a message ID of their own
+            write(shared::kBroadcastAddress, uint16_t(0), command_id);
+            command->send(this);
+            staging.writer.writeCrc();
+
+            if (staging.frame.overflowed())
             {
-                consumeMessage();
-#ifndef EMB_SINGLE_THREADED
-                std::lock_guard<std::mutex> lock(m_commands_mutex);
-#endif
-                m_commands.erase(message_id);
-                throw;
+                throw FrameTooLarge("The command's message is longer than " + std::to_string(Frame::kMaxFrameSize) +
+                                        " bytes",
+                                    command);
             }
 
+            // Nothing comes back to give the credit back
+            flushFrame(staging.frame, false);
+        }
+
+        void EmbMessenger::update()
+        {
+            processMessages(1);
+        }
+
+#ifdef EMB_SINGLE_THREADED
+        size_t EmbMessenger::updateAll()
+        {
+            return processMessages(std::numeric_limits<size_t>::max());
+        }
+#endif
+
+        size_t EmbMessenger::processMessages(size_t max)
+        {
             try
             {
-                readErrors();
+                return receiveMessages(max);
             }
             catch (...)
             {
-                consumeMessage();
-#ifndef EMB_SINGLE_THREADED
-                std::lock_guard<std::mutex> lock(m_commands_mutex);
-#endif
-                m_commands.erase(message_id);
+                m_metrics.countError(std::current_exception());
+                EMB_TRACE(m_tracer, error, std::current_exception());
                 throw;
             }
+        }
 
-            if (m_reader.nextCrc())
+        size_t EmbMessenger::receiveMessages(size_t max)
+        {
+            expireTimers();
+
+            m_buffer->update();
+
+            // Only the messages that are already buffered, so a steady stream from the device can't keep us here
+            size_t count = m_buffer->messages();
+            if (count > max)
             {
-                if (!m_reader.readCrc())
-                {
-#ifndef EMB_SINGLE_THREADED
-                    std::lock_guard<std::mutex> lock(m_commands_mutex);
-#endif
-                    m_commands.erase(message_id);
-                    throw CrcInvalid(ExceptionSource::Host, "Crc from the device was invalid", m_current_command);
-                }
+                count = max;
             }
-            else
+
+            if (count == 0)
             {
-                consumeMessage();
-#ifndef EMB_SINGLE_THREADED
-                std::lock_guard<std::mutex> lock(m_commands_mutex);
-#endif
-                m_commands.erase(message_id);
-                throw ExtraParameters(ExceptionSource::Host, "Message has extra parameters from the device",
-                                      m_current_command);
+                return 0;
             }
 
-            m_current_command->m_command_state = CommandState::Received;
 #ifndef EMB_SINGLE_THREADED
-            if (m_current_command->m_is_waiting)
-            {
-                m_current_command->m_condition_variable.notify_all();
-            }
+            // Held for the whole batch, it is only released while commands are completed and callbacks run
+            std::unique_lock<std::mutex> lock(m_commands_mutex);
 #endif
+            std::shared_ptr<IExecutor> executor = m_executor;
+            ReceivedBytes received_bytes(m_metrics, *m_buffer);
 
-            if (m_current_command->m_callback != nullptr)
+            for (size_t processed = 0; processed < count; ++processed)
             {
-                m_current_command->m_callback(m_current_command);
-            }
+                m_metrics.countReceivedFrame();
+                m_reader.resetCrc();
+                m_current_command = nullptr;
 
-            m_current_command = nullptr;
-
-            {
-#ifndef EMB_SINGLE_THREADED
-                std::lock_guard<std::mutex> lock(m_commands_mutex);
-#endif
-                if (!m_commands.at(message_id)->m_is_periodic)
+                // Nothing in a corrupted message is acted on, its errors, message id and parameters can't be trusted
+                bool crc_valid = receiveFrame();
+                if (!crc_valid)
                 {
-                    m_commands.erase(message_id);
+                    m_metrics.countCrcFailure();
                 }
-            }
-        }
-
-        void EmbMessenger::write()
-        {
-            (void)0;  // Noop
-        }
 
-        void EmbMessenger::read()
-        {
-            (void)0;  // Noop
-        }
+                // The router only passes on this device's messages, a corrupted address fails the CRC
+                if (m_addressed)
+                {
+                    uint8_t address = 0;
+                    if (!m_reader.read(address))
+                    {
+                        consumeMessage();
+                        throw MessageIdReadError(ExceptionSource::Host, "Error reading the device's address");
+                    }
+                }
 
-        void EmbMessenger::readErrors()
+                try
+                {
+                    if (crc_valid)
+                    {
+                        readErrors();
+                    }
+                }
+                catch (...)
+                {
+                    consumeMessage();
+                    throw;
+                }
+
+                uint16_t message_id = 0;
+                if (!m_reader.read(message_id))
+                {
+                    consumeMessage();
+                    if (!crc_valid)
+                    {
+                        throw CrcInvalid(ExceptionSource::Host, "Crc from the device was invalid");
+                    }
+                    throw MessageIdReadError(ExceptionSource::Host, "Error reading message Id");
+                }
+
+                // A corrupted response is left for the timeout, the message id it carried can't be trusted
+                if (!crc_valid && m_retransmission)
+                {
+                    consumeMessage();
+                    continue;
+                }
+                EMB_TRACE(m_tracer, frameReceived, message_id);
+
+                // The device is alive even if the response is late
+                TimerWheel::clock_t::time_point now = TimerWheel::clock_t::now();
+                m_last_response = now.time_since_epoch().count();
+                m_last_activity = m_last_response.load();
+
+                m_current_command = m_commands.find(message_id);
+                if (m_current_command == nullptr)
+                {
+                    consumeMessage();
+
+                    // A late response to a message that was retransmitted, the command already completed
+                    if (m_retransmission)
+                    {
+                        continue;
+                    }
+                    if (!crc_valid)
+                    {
+                        throw CrcInvalid(ExceptionSource::Host, "Crc from the device was invalid");
+                    }
+                    throw MessageIdInvalid("No command to receive message from the device");
+                }
+
+                if (crc_valid)
+                {
+                    recordResponse(message_id, now);
+                }
+
+#ifndef EMB_SINGLE_THREADED
+                // Don't overwrite the values of the command while its last callback is still reading them.
+                // Periodic samples arriving faster than their callback can keep up with are dropped instead of stalling.
+                // Any other command is only sent again once its callback has returned.
+                if (m_current_command->m_callback_state != Command::CallbackState::Idle &&
+                    m_current_command->m_is_periodic)
+                {
+                    consumeMessage();
+                    m_current_command = nullptr;
+                    m_dropped_samples.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+#endif
+
+                m_parameter_index = 0;
+                try
+                {
+                    // The command's values are only overwritten by a message that passed the CRC check
+                    if (!crc_valid)
+                    {
+                        consumeMessage();
+                        throw CrcInvalid(ExceptionSource::Host, "Crc from the device was invalid", m_current_command);
+                    }
+
+                    try
+                    {
+                        m_current_command->receive(this);
+                        readErrors();
+                    }
+                    catch (...)
+                    {
+                        consumeMessage();
+                        throw;
+                    }
+
+                    if (!m_reader.nextCrc())
+                    {
+                        consumeMessage();
+                        throw ExtraParameters(ExceptionSource::Host, "Message has extra parameters from the device",
+                                              m_current_command);
+                    }
+
+                    if (!m_reader.readCrc())
+                    {
+                        m_metrics.countCrcFailure();
+                        throw CrcInvalid(ExceptionSource::Host, "Crc from the device was invalid", m_current_command);
+                    }
+                }
+                catch (...)
+                {
+                    Recovery recovery =
+                        m_retransmission ? recoverMessage(std::current_exception(), message_id) : Recovery::None;
+                    if (recovery == Recovery::Retransmit)
+                    {
+                        m_current_command = nullptr;
+                        continue;
+                    }
+
+                    m_commands.erase(message_id);
+                    cancelTimers(message_id);
+                    releaseCredit(*m_current_command);
+
+                    if (recovery == Recovery::Resend)
+                    {
+                        std::shared_ptr<Command> command = std::move(m_current_command);
+                        m_current_command = nullptr;
+                        ++m_retransmissions;
+#ifndef EMB_SINGLE_THREADED
+                        lock.unlock();
+#endif
+                        try
+                        {
+                            send(command);
+                        }
+                        catch (...)
+                        {
+                            command->fail(std::current_exception());
+                            pushCompletion(command, std::current_exception());
+                            throw;
+                        }
+#ifndef EMB_SINGLE_THREADED
+                        lock.lock();
+#endif
+                        continue;
+                    }
+
+#ifndef EMB_SINGLE_THREADED
+                    // Completed outside the lock, a coroutine resumed by the failure may send its next command
+                    lock.unlock();
+#endif
+                    // Complete the command so anybody waiting on it sees the error
+                    m_current_command->fail(std::current_exception());
+                    pushCompletion(m_current_command, std::current_exception());
+                    throw;
+                }
+
+                EMB_TRACE(m_tracer, decodeComplete, message_id, *m_current_command);
+                cancelTimers(message_id);
+                releaseCredit(*m_current_command);
+
+                bool dispatch = m_current_command->m_callback != nullptr && executor != nullptr &&
+                                !isBuiltInCommand(*m_current_command);
+
+#ifndef EMB_SINGLE_THREADED
+                // Marked before the command is woken, so a waiter sending it again right away waits for the callback
+                if (dispatch)
+                {
+                    m_current_command->m_callback_state = Command::CallbackState::Pending;
+                    ++m_pending_callbacks;
+                }
+
+                // Waking the command may resume a coroutine, and callbacks may send commands or, for the messenger's
+                // own commands, change the command table
+                lock.unlock();
+#endif
+                m_current_command->complete();
+
+                // Also run when an inline callback throws, the command would otherwise hold its slot forever
+                auto finish = [&] {
+                    pushCompletion(m_current_command, nullptr);
+#ifndef EMB_SINGLE_THREADED
+                    lock.lock();
+#endif
+
+                    m_current_command = nullptr;
+
+                    // The command may have been replaced by a periodic command in its callback
+                    std::shared_ptr<Command> command = m_commands.find(message_id);
+                    if (command != nullptr && !command->m_is_periodic)
+                    {
+                        m_commands.erase(message_id);
+                    }
+                };
+
+                if (m_current_command->m_callback != nullptr)
+                {
+                    try
+                    {
+                        if (dispatch)
+                        {
+                            dispatchCallback(*executor, message_id, m_current_command);
+                        }
+                        else
+                        {
+                            EMB_TRACE(m_tracer, callbackStart, message_id, *m_current_command);
+                            m_current_command->m_callback(m_current_command);
+                            EMB_TRACE(m_tracer, callbackEnd, message_id, *m_current_command);
+                        }
+                    }
+                    catch (...)
+                    {
+                        finish();
+                        throw;
+                    }
+                }
+
+                finish();
+            }
+
+            return count;
+        }
+
+        void EmbMessenger::write()
+        {
+            (void)0;  // Noop
+        }
+
+        void EmbMessenger::read()
+        {
+            (void)0;  // Noop
+        }
+
+        void EmbMessenger::readErrors()
         {
             while (m_reader.nextError())
             {
@@ -295,6 +881,8 @@ namespace emb
                     case shared::DataError::kExtraParameters:
                         throw ExtraParameters(ExceptionSource::Device,
                                               "The device received one or more extra parameters", m_current_command);
+                    case shared::DataError::kDuplicateMessage:
+                        throw DuplicateMessage("The device already executed the message", m_current_command);
                     case shared::DataError::kOutOfPeriodicCommandSlots:
                         throw OutOfPeriodicCommandSlots("The device ran out of periodic command slots",
                                                         m_current_command);
@@ -315,6 +903,7 @@ namespace emb
                     case shared::DataError::kCommandIdInvalid:
                         throw CommandIdInvalid("The device read an invalid command id", m_current_command);
                     case shared::DataError::kCrcInvalid:
+                        m_metrics.countDeviceCrcFailure();
                         throw CrcInvalid(ExceptionSource::Device, "The device read an invalid CRC", m_current_command);
                     default:
                         m_current_command->reportError(error, data, m_current_command);
@@ -328,10 +917,29 @@ namespace emb
             }
         }
 
+        bool EmbMessenger::receiveFrame()
+        {
+            // The CRC byte is last, over the whole message including it the CRC comes to 0
+            uint8_t crc = 0;
+            FrameSplitter splitter;
+            m_received_frame.clear();
+            while (!m_buffer->empty())
+            {
+                uint8_t byte = m_buffer->readByte();
+                crc = shared::crc::Calculate8(crc, byte);
+                m_received_frame.writeByte(byte);
+                if (splitter.push(byte))
+                {
+                    break;
+                }
+            }
+
+            return crc == 0 && !m_received_frame.overflowed();
+        }
+
         void EmbMessenger::consumeMessage()
         {
-            for (uint8_t n = m_buffer->messages(); n > 0 && n == m_buffer->messages(); m_buffer->readByte())
-                ;
+            m_received_frame.clear();
         }
 
         EmbMessenger::ResetCommand::ResetCommand()
@@ -339,15 +947,19 @@ namespace emb
             m_type_index = typeid(ResetCommand);
         }
 
-        EmbMessenger::RegisterPeriodicCommand::RegisterPeriodicCommand(uint16_t commandId, uint32_t period) :
+        EmbMessenger::RegisterPeriodicCommand::RegisterPeriodicCommand(uint16_t commandId, uint32_t period,
+                                                                       std::shared_ptr<Command> periodicCommand) :
             m_command_id(commandId),
-            m_period(period)
+            m_period(period),
+            m_periodic_command(std::move(periodicCommand))
         {
             m_type_index = typeid(RegisterPeriodicCommand);
         }
 
         void EmbMessenger::RegisterPeriodicCommand::send(EmbMessenger* messenger)
         {
+            // The message ID is assigned by now and nothing has been written, the response can't arrive before this
+            m_periodic_command->m_message_id = m_message_id;
             messenger->write(m_command_id, m_period);
         }
 
@@ -366,25 +978,672 @@ namespace emb
             messenger->read(m_periodic_message_id);
         }
 
+        EmbMessenger::BufferCapacityCommand::BufferCapacityCommand()
+        {
+            m_type_index = typeid(BufferCapacityCommand);
+        }
+
+        void EmbMessenger::BufferCapacityCommand::receive(EmbMessenger* messenger)
+        {
+            messenger->read(m_capacity);
+        }
+
+        EmbMessenger::KeepaliveCommand::KeepaliveCommand()
+        {
+            m_type_index = typeid(KeepaliveCommand);
+        }
+
         bool EmbMessenger::commandsReceived()
         {
 #ifndef EMB_SINGLE_THREADED
             std::lock_guard<std::mutex> lock(m_commands_mutex);
 #endif
-            for (const auto& x : m_commands)
+            bool received = true;
+            m_commands.forEach([&](const std::shared_ptr<Command>& command) {
+                received = received && command->getCommandState() == CommandState::Received;
+            });
+
+            return received;
+        }
+
+        void EmbMessenger::setExecutor(std::shared_ptr<IExecutor> executor)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+            m_executor = executor;
+        }
+
+#ifndef EMB_SINGLE_THREADED
+        size_t EmbMessenger::droppedSamples() const
+        {
+            return m_dropped_samples;
+        }
+#endif
+
+        void EmbMessenger::dispatchCallback(IExecutor& executor, uint16_t key, const std::shared_ptr<Command>& command)
+        {
+#ifdef EMB_SINGLE_THREADED
+            executor.execute(key, [this, key, command] {
+                EMB_TRACE(m_tracer, callbackStart, key, *command);
+                command->m_callback(command);
+                EMB_TRACE(m_tracer, callbackEnd, key, *command);
+            });
+#else
+            // Marked pending by receiveMessages, before the command was woken
+            executor.execute(key, [this, key, command] {
+                EMB_TRACE(m_tracer, callbackStart, key, *command);
+                try
+                {
+                    command->m_callback(command);
+                }
+                catch (...)
+                {
+                    if (m_exception_handler && m_exception_handler(std::current_exception()))
+                    {
+                        m_running = false;
+                    }
+                }
+                EMB_TRACE(m_tracer, callbackEnd, key, *command);
+
+                Command::CallbackState callback_state = Command::CallbackState::Pending;
+                if (!command->m_callback_state.compare_exchange_strong(callback_state, Command::CallbackState::Idle))
+                {
+                    // Sent again while the callback ran
+                    command->m_callback_state = Command::CallbackState::Idle;
+                    try
+                    {
+                        send(command, command->m_deferred_command_id);
+                    }
+                    catch (...)
+                    {
+                        command->fail(std::current_exception());
+                        pushCompletion(command, std::current_exception());
+                        if (m_exception_handler && m_exception_handler(std::current_exception()))
+                        {
+                            m_running = false;
+                        }
+                    }
+                }
+                --m_pending_callbacks;
+            });
+#endif
+        }
+
+        bool EmbMessenger::isBuiltInCommand(const Command& command)
+        {
+            std::type_index type_index = command.getTypeIndex();
+            return type_index == typeid(ResetCommand) || type_index == typeid(RegisterPeriodicCommand) ||
+                   type_index == typeid(UnregisterPeriodicCommand) || type_index == typeid(BufferCapacityCommand) ||
+                   type_index == typeid(KeepaliveCommand);
+        }
+
+        bool EmbMessenger::hasCredit(size_t bytes) const
+        {
+            if (m_messages_in_flight == 0)
+            {
+                return true;
+            }
+
+            return (m_window_bytes == 0 || m_bytes_in_flight + bytes <= m_window_bytes) &&
+                   (m_window_messages == 0 || m_messages_in_flight < m_window_messages);
+        }
+
+        void EmbMessenger::acquireCredit(Command& command, size_t bytes)
+        {
+            command.m_frame_size = 0;
+            if (!m_flow_control)
+            {
+                return;
+            }
+
+#ifndef EMB_SINGLE_THREADED
+            std::unique_lock<std::mutex> lock(m_write_mutex);
+
+            // The update thread gives the credit back, so it can't wait for it
+            if (std::this_thread::get_id() != m_receive_thread.load())
+            {
+                m_credit_condition.wait(lock, [&] { return !m_flow_control || hasCredit(bytes); });
+            }
+
+            m_bytes_in_flight += bytes;
+            ++m_messages_in_flight;
+#endif
+            // In the Single Threaded EmbMessenger the credit is taken when the message is written
+            command.m_frame_size = static_cast<uint16_t>(bytes);
+        }
+
+        void EmbMessenger::releaseCredit(Command& command)
+        {
+            if (command.m_frame_size == 0)
+            {
+                return;
+            }
+
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_write_mutex);
+#endif
+                m_bytes_in_flight -= command.m_frame_size;
+                --m_messages_in_flight;
+            }
+            command.m_frame_size = 0;
+
+#ifndef EMB_SINGLE_THREADED
+            m_credit_condition.notify_all();
+#else
+            flushPendingFrames();
+#endif
+        }
+
+#ifdef EMB_SINGLE_THREADED
+        void EmbMessenger::flushPendingFrames()
+        {
+            Frame frame;
+            while (!m_frame_queue.empty() && hasCredit(m_frame_queue.frontSize()))
+            {
+                m_frame_queue.pop(frame);
+                m_bytes_in_flight += frame.size();
+                ++m_messages_in_flight;
+                writeFrame(frame);
+
+                QueuedCommand queued = std::move(m_queued_commands.front());
+                m_queued_commands.pop_front();
+                startTimers(queued.command, queued.command_id);
+            }
+        }
+#endif
+
+        void EmbMessenger::setFlowControlWindow(size_t bytes, size_t messages)
+        {
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_write_mutex);
+#endif
+                m_window_bytes = bytes;
+                m_window_messages = messages;
+                m_flow_control = bytes != 0 || messages != 0;
+            }
+
+#ifndef EMB_SINGLE_THREADED
+            m_credit_condition.notify_all();
+#else
+            flushPendingFrames();
+#endif
+        }
+
+        void EmbMessenger::negotiateFlowControl(size_t messages)
+        {
+            std::shared_ptr<BufferCapacityCommand> capacityCommand = makeCommand<BufferCapacityCommand>();
+#ifdef EMB_SINGLE_THREADED
+            capacityCommand->setCallback<BufferCapacityCommand>([this, messages](auto&& capacityCommand) {
+                setFlowControlWindow(capacityCommand->m_capacity, messages);
+            });
+            send(capacityCommand);
+#else
+            send(capacityCommand);
+
+            // Set here rather than in a callback, the callback runs after wait returns and could undo a window the
+            // caller sets next
+            capacityCommand->wait();
+            if (capacityCommand->getException() != nullptr)
+            {
+                std::rethrow_exception(capacityCommand->getException());
+            }
+            setFlowControlWindow(capacityCommand->m_capacity, messages);
+#endif
+        }
+
+        size_t EmbMessenger::bytesInFlight()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_write_mutex);
+#endif
+            return m_bytes_in_flight;
+        }
+
+        size_t EmbMessenger::messagesInFlight()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_write_mutex);
+#endif
+            return m_messages_in_flight;
+        }
+
+        void EmbMessenger::enableRetransmission(std::chrono::milliseconds timeout, uint8_t retries)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+            if (m_pending_frames.empty())
+            {
+                m_pending_frames.resize(m_commands.capacity());
+            }
+
+            m_retransmit_timeout = timeout;
+            m_max_retries = retries;
+            m_retransmission = true;
+        }
+
+        size_t EmbMessenger::retransmissions() const
+        {
+            return m_retransmissions;
+        }
+
+        EmbMessenger::PendingFrame& EmbMessenger::pendingFrame(uint16_t message_id)
+        {
+            // Same slot as the command table, the table has the same power of two capacity
+            return m_pending_frames[message_id & (m_pending_frames.size() - 1)];
+        }
+
+        void EmbMessenger::setDefaultTimeout(std::chrono::milliseconds timeout)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+            m_default_timeout = timeout;
+        }
+
+        void EmbMessenger::startTimers(const std::shared_ptr<Command>& command, uint16_t command_id)
+        {
+            std::chrono::milliseconds timeout = command->m_timeout;
+            uint16_t message_id = command->m_message_id;
+            uint32_t slot = message_id & (m_commands.capacity() - 1);
+
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+            // The response may have been processed already
+            if (m_commands.find(message_id) != command || command->getCommandState() != CommandState::Sent)
+            {
+                return;
+            }
+
+            TimerWheel::clock_t::time_point now = TimerWheel::clock_t::now();
+            if (timeout == std::chrono::milliseconds::zero())
+            {
+                timeout = m_default_timeout;
+            }
+
+            if (timeout != std::chrono::milliseconds::zero())
+            {
+                m_deadline_message_ids[slot] = message_id;
+                m_timers.schedule(slot, now + timeout);
+            }
+
+            if (m_retransmission && pendingFrame(message_id).active)
+            {
+                m_timers.schedule(m_commands.capacity() + slot, now + retransmitTimeout(0));
+            }
+
+            m_sent_messages[slot] = SentMessage{ now, message_id, command_id, true };
+            m_last_activity = now.time_since_epoch().count();
+
+            m_next_tick = m_timers.nextTick().time_since_epoch().count();
+        }
+
+        void EmbMessenger::cancelTimers(uint16_t message_id)
+        {
+            uint32_t slot = message_id & (m_commands.capacity() - 1);
+            if (m_deadline_message_ids[slot] == message_id)
+            {
+                m_timers.cancel(slot);
+            }
+
+            if (m_pending_frames.empty())
+            {
+                return;
+            }
+
+            PendingFrame& pending = pendingFrame(message_id);
+            if (pending.message_id == message_id)
+            {
+                pending.active = false;
+                m_timers.cancel(m_commands.capacity() + slot);
+            }
+        }
+
+        void EmbMessenger::expireTimers()
+        {
+            TimerWheel::clock_t::time_point now = TimerWheel::clock_t::now();
+            if (now.time_since_epoch().count() < m_next_tick)
+            {
+                return;
+            }
+
+            bool keepalive_due = false;
+            std::chrono::milliseconds keepalive_timeout;
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+                m_timers.advance(now, [&](uint32_t timer) { expireTimer(timer, now); });
+
+                m_next_tick = m_timers.size() == 0 ? std::numeric_limits<TimerWheel::clock_t::rep>::max()
+                                                   : m_timers.nextTick().time_since_epoch().count();
+
+                keepalive_due = m_keepalive_due;
+                keepalive_timeout = m_keepalive_interval;
+                m_keepalive_due = false;
+            }
+
+            // Under flow control the keepalive would need credit, which the update thread can't wait for. The
+            // responses to the messages in flight show the device is alive, or their deadlines show it isn't.
+            if (keepalive_due && m_flow_control)
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_write_mutex);
+#endif
+                keepalive_due = m_messages_in_flight == 0;
+            }
+
+            if (keepalive_due)
+            {
+                std::shared_ptr<KeepaliveCommand> keepalive = makeCommand<KeepaliveCommand>();
+                keepalive->setTimeout(keepalive_timeout);
+                send(keepalive);
+                ++m_keepalives_sent;
+            }
+
+            if (m_expired.empty())
+            {
+                return;
+            }
+
+            // Completed outside the lock, waking the commands may run their continuations
+            std::exception_ptr first = nullptr;
+            for (Completion& expired : m_expired)
+            {
+                releaseCredit(*expired.command);
+                expired.command->fail(expired.exception);
+                pushCompletion(expired.command, expired.exception);
+
+                // A missed keepalive only shows in the link stats
+                if (expired.command->getTypeIndex() == typeid(KeepaliveCommand))
+                {
+                    ++m_keepalives_missed;
+                    continue;
+                }
+
+                ++m_timeouts;
+                if (first == nullptr)
+                {
+                    first = expired.exception;
+                }
+                else
+                {
+                    // Only the first is thrown and counted on its way out
+                    m_metrics.countError(expired.exception);
+                    EMB_TRACE(m_tracer, error, expired.exception);
+                }
+            }
+            m_expired.clear();
+
+            if (first != nullptr)
+            {
+                std::rethrow_exception(first);
+            }
+        }
+
+        void EmbMessenger::expireTimer(uint32_t timer, TimerWheel::clock_t::time_point now)
+        {
+            uint32_t capacity = static_cast<uint32_t>(m_commands.capacity());
+            uint16_t message_id;
+
+            if (timer == keepaliveTimer())
+            {
+                TimerWheel::clock_t::time_point last_activity{ TimerWheel::clock_t::duration(m_last_activity) };
+                if (now - last_activity >= m_keepalive_interval)
+                {
+                    m_keepalive_due = true;
+                    m_timers.schedule(timer, now + m_keepalive_interval);
+                }
+                else
+                {
+                    m_timers.schedule(timer, last_activity + m_keepalive_interval);
+                }
+                return;
+            }
+
+            if (timer >= capacity)
+            {
+                PendingFrame& pending = m_pending_frames[timer - capacity];
+                if (!pending.active)
+                {
+                    return;
+                }
+
+                if (pending.retries != 0)
+                {
+                    --pending.retries;
+                    ++m_retransmissions;
+                    m_timers.schedule(timer, now + retransmitTimeout(m_max_retries - pending.retries));
+
+                    // Karn's rule, the response can't be matched to one of the copies
+                    m_sent_messages[timer - capacity].sample = false;
+
+                    // Still holds the credit from the first time it was sent
+                    flushFrame(pending.frame, false);
+                    return;
+                }
+
+                message_id = pending.message_id;
+            }
+            else
+            {
+                message_id = m_deadline_message_ids[timer];
+            }
+
+            std::shared_ptr<Command> command = m_commands.find(message_id);
+            if (command == nullptr || command->getCommandState() != CommandState::Sent)
+            {
+                return;
+            }
+
+            m_commands.erase(message_id);
+            cancelTimers(message_id);
+
+            if (timer >= capacity)
+            {
+                m_expired.push_back(Completion{ command, std::make_exception_ptr(RetriesExhausted(
+                                                             "The device didn't respond to the command", command)) });
+            }
+            else
+            {
+                m_expired.push_back(Completion{ command, std::make_exception_ptr(CommandTimeout(
+                                                             "The device didn't respond in time", command)) });
+            }
+        }
+
+        uint32_t EmbMessenger::keepaliveTimer() const
+        {
+            return static_cast<uint32_t>(2 * m_commands.capacity());
+        }
+
+        std::chrono::microseconds EmbMessenger::retransmitTimeout(uint8_t retransmissions) const
+        {
+            // Backs off exponentially, a link that keeps losing messages is likely congested or down
+            std::chrono::microseconds timeout = m_rtt.timeout(m_retransmit_timeout);
+            for (uint8_t i = 0; i < retransmissions && timeout < std::chrono::seconds(60); ++i)
+            {
+                timeout *= 2;
+            }
+            return timeout;
+        }
+
+        void EmbMessenger::recordResponse(uint16_t message_id, TimerWheel::clock_t::time_point now)
+        {
+            SentMessage& sent = m_sent_messages[message_id & (m_commands.capacity() - 1)];
+            if (sent.sample && sent.message_id == message_id)
+            {
+                std::chrono::microseconds rtt = std::chrono::duration_cast<std::chrono::microseconds>(now - sent.time);
+                m_rtt.addSample(rtt);
+                m_metrics.recordRtt(sent.command_id, rtt);
+                sent.sample = false;
+            }
+        }
+
+        void EmbMessenger::enableKeepalive(std::chrono::milliseconds interval)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+            m_keepalive_interval = interval;
+            if (interval == std::chrono::milliseconds::zero())
             {
-                if (x.second->getCommandState() != CommandState::Received)
+                m_timers.cancel(keepaliveTimer());
+                return;
+            }
+
+            m_timers.schedule(keepaliveTimer(), TimerWheel::clock_t::now() + interval);
+            m_next_tick = m_timers.nextTick().time_since_epoch().count();
+        }
+
+        LinkStats EmbMessenger::getLinkStats()
+        {
+            LinkStats stats;
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+                stats.smoothed_rtt = m_rtt.smoothedRtt();
+                stats.rtt_variance = m_rtt.rttVariance();
+                stats.min_rtt = m_rtt.minRtt();
+                stats.last_rtt = m_rtt.lastRtt();
+                stats.retransmission_timeout = m_rtt.timeout(m_retransmit_timeout);
+                stats.rtt_samples = m_rtt.samples();
+            }
+
+            stats.retransmissions = m_retransmissions;
+            stats.timeouts = m_timeouts;
+            stats.keepalives_sent = m_keepalives_sent;
+            stats.keepalives_missed = m_keepalives_missed;
+            stats.since_last_response = TimerWheel::clock_t::now() -
+                                        TimerWheel::clock_t::time_point(TimerWheel::clock_t::duration(m_last_response));
+            return stats;
+        }
+
+        MetricsSnapshot EmbMessenger::snapshot()
+        {
+            MetricsSnapshot snapshot = m_metrics.snapshot();
+            {
+#ifndef EMB_SINGLE_THREADED
+                std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+                snapshot.pending_commands = m_commands.size();
+            }
+
+            snapshot.queued_frames = m_frame_queue.size();
+            SpscQueue<Completion>* queue = m_completion_queue;
+            snapshot.queued_completions = queue != nullptr ? queue->size() : 0;
+#ifndef EMB_SINGLE_THREADED
+            snapshot.pending_callbacks = m_pending_callbacks;
+#endif
+            return snapshot;
+        }
+
+#ifdef EMB_TRACING
+        void EmbMessenger::setTracer(std::shared_ptr<ITracer> tracer)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_commands_mutex);
+#endif
+            if (tracer != nullptr)
+            {
+                m_tracers.push_back(tracer);
+            }
+            m_tracer.store(tracer.get(), std::memory_order_release);
+        }
+#endif
+
+        EmbMessenger::Recovery EmbMessenger::recoverMessage(std::exception_ptr error, uint16_t message_id)
+        {
+            try
+            {
+                std::rethrow_exception(error);
+            }
+            catch (const CrcInvalid& e)
+            {
+                PendingFrame& pending = pendingFrame(message_id);
+                if (!pending.active || pending.message_id != message_id)
+                {
+                    return Recovery::None;
+                }
+
+                // The device got a corrupted copy, send it again now instead of waiting for the timeout.
+                // The message id comes from a response that passed the CRC check.
+                if (e.getSource() == ExceptionSource::Device)
                 {
-                    return false;
+                    m_sent_messages[message_id & (m_commands.capacity() - 1)].sample = false;
+                    m_timers.schedule(m_commands.capacity() + (message_id & (m_commands.capacity() - 1)),
+                                      TimerWheel::clock_t::now());
+                    m_next_tick = m_timers.nextTick().time_since_epoch().count();
                 }
+                return Recovery::Retransmit;
+            }
+            catch (const DuplicateMessage&)
+            {
+                if (m_idempotent_commands.count(m_current_command->getTypeIndex()) != 0)
+                {
+                    return Recovery::Resend;
+                }
+            }
+            catch (...)
+            {
+            }
+
+            return Recovery::None;
+        }
+
+        void EmbMessenger::enableCompletionQueue(size_t capacity)
+        {
+            if (m_completion_queue_storage != nullptr)
+            {
+                throw std::logic_error("The completion queue is already enabled");
             }
 
-            return true;
+            m_completion_queue_storage.reset(new SpscQueue<Completion>(capacity));
+            m_completion_queue = m_completion_queue_storage.get();
+        }
+
+        size_t EmbMessenger::pollCompletions(Completion* completions, size_t max)
+        {
+            SpscQueue<Completion>* queue = m_completion_queue;
+            if (queue == nullptr)
+            {
+                return 0;
+            }
+            return queue->pop(completions, max);
+        }
+
+        size_t EmbMessenger::droppedCompletions() const
+        {
+            return m_dropped_completions;
+        }
+
+        void EmbMessenger::pushCompletion(const std::shared_ptr<Command>& command, std::exception_ptr exception)
+        {
+            SpscQueue<Completion>* queue = m_completion_queue;
+            if (queue == nullptr)
+            {
+                return;
+            }
+
+            // The messenger's own commands are not the application's business
+            if (isBuiltInCommand(*command))
+            {
+                return;
+            }
+
+            if (!queue->push(Completion{ command, exception }))
+            {
+                m_dropped_completions.fetch_add(1, std::memory_order_relaxed);
+            }
         }
 
         void EmbMessenger::resetDevice()
         {
-            std::shared_ptr<ResetCommand> resetCommand = std::make_shared<ResetCommand>();
+            std::shared_ptr<ResetCommand> resetCommand = makeCommand<ResetCommand>();
             send(resetCommand);
 #ifndef EMB_SINGLE_THREADED
             resetCommand->wait();
@@ -0,0 +1,422 @@
+#include "EmbMessenger/EmbMessengerPool.hpp"
+
+#if !defined(EMB_SINGLE_THREADED) && defined(__linux__)
+
+#include "EmbMessenger/IPollable.hpp"
+
+#include <cerrno>
+#include <pthread.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace
+        {
+            // Event IDs of the pool's own file descriptors, the messengers' IDs come after them
+            const uint64_t kTimerId = 0;
+            const uint64_t kWakeId = 1;
+            const uint64_t kStopId = 2;
+            const uint64_t kFirstEntryId = 3;
+
+            const int kMaxEvents = 64;
+
+            std::system_error systemError(const char* what)
+            {
+                return std::system_error(errno, std::generic_category(), what);
+            }
+
+            void control(int epoll, int operation, int fd, uint32_t events, uint64_t id)
+            {
+                epoll_event event = {};
+                event.events = events;
+                event.data.u64 = id;
+                if (epoll_ctl(epoll, operation, fd, &event) != 0)
+                {
+                    throw systemError("Unable to add file descriptor to epoll");
+                }
+            }
+
+            void drain(int fd)
+            {
+                uint64_t count;
+                while (read(fd, &count, sizeof(count)) < 0 && errno == EINTR)
+                {
+                }
+            }
+        }  // namespace
+
+        EmbMessengerPool::EmbMessengerPool(PoolOptions options) :
+            m_next_id(kFirstEntryId),
+            m_epoll(-1),
+            m_timer(-1),
+            m_wake(-1),
+            m_stop(-1),
+            m_running(true)
+        {
+            if (options.threads == 0)
+            {
+                throw std::invalid_argument("EmbMessengerPool needs at least 1 thread");
+            }
+
+            if (options.tick <= std::chrono::microseconds::zero())
+            {
+                throw std::invalid_argument("EmbMessengerPool tick must be positive");
+            }
+
+            try
+            {
+                m_epoll = epoll_create1(EPOLL_CLOEXEC);
+                m_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+                m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                m_stop = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (m_epoll < 0 || m_timer < 0 || m_wake < 0 || m_stop < 0)
+                {
+                    throw systemError("Unable to create EmbMessengerPool file descriptors");
+                }
+
+                itimerspec period = {};
+                period.it_interval.tv_sec = options.tick.count() / 1000000;
+                period.it_interval.tv_nsec = (options.tick.count() % 1000000) * 1000;
+                period.it_value = period.it_interval;
+                if (timerfd_settime(m_timer, 0, &period, nullptr) != 0)
+                {
+                    throw systemError("Unable to start EmbMessengerPool tick");
+                }
+
+                control(m_epoll, EPOLL_CTL_ADD, m_timer, EPOLLIN | EPOLLONESHOT, kTimerId);
+                control(m_epoll, EPOLL_CTL_ADD, m_wake, EPOLLIN | EPOLLONESHOT, kWakeId);
+
+                // Level triggered and never read, so it wakes every thread
+                control(m_epoll, EPOLL_CTL_ADD, m_stop, EPOLLIN, kStopId);
+            }
+            catch (...)
+            {
+                closeAll();
+                throw;
+            }
+
+            for (size_t i = 0; i < options.threads; ++i)
+            {
+                m_workers.emplace_back(new Worker());
+            }
+
+            for (size_t i = 0; i < options.threads; ++i)
+            {
+                m_workers[i]->thread = std::thread(&EmbMessengerPool::work, this, i);
+                pthread_setname_np(m_workers[i]->thread.native_handle(), options.name);
+            }
+        }
+
+        EmbMessengerPool::~EmbMessengerPool()
+        {
+            m_running = false;
+            uint64_t one = 1;
+            while (write(m_stop, &one, sizeof(one)) < 0 && errno == EINTR)
+            {
+            }
+
+            for (std::unique_ptr<Worker>& worker : m_workers)
+            {
+                worker->thread.join();
+            }
+
+            // The messengers may close their buffers when they are released
+            for (auto& entry : m_entries)
+            {
+                if (entry.second->fd >= 0 && entry.second->state != State::Stopped)
+                {
+                    epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry.second->fd, nullptr);
+                }
+            }
+            m_entries.clear();
+
+            closeAll();
+        }
+
+        void EmbMessengerPool::closeAll()
+        {
+            for (int fd : { m_epoll, m_timer, m_wake, m_stop })
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+        }
+
+        void EmbMessengerPool::add(std::shared_ptr<EmbMessenger> messenger)
+        {
+            if (!messenger)
+            {
+                throw std::invalid_argument("EmbMessengerPool can't add a null messenger");
+            }
+
+            std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+            IPollable* pollable = dynamic_cast<IPollable*>(messenger->getBuffer().get());
+            entry->messenger = std::move(messenger);
+            entry->fd = pollable ? pollable->fileDescriptor() : -1;
+            entry->state = State::Idle;
+            entry->removed = false;
+
+            std::lock_guard<std::mutex> lock(m_entries_mutex);
+            entry->id = m_next_id++;
+            if (entry->fd >= 0)
+            {
+                control(m_epoll, EPOLL_CTL_ADD, entry->fd, EPOLLIN | EPOLLONESHOT, entry->id);
+            }
+            m_entries.emplace(entry->id, entry);
+        }
+
+        bool EmbMessengerPool::remove(const std::shared_ptr<EmbMessenger>& messenger)
+        {
+            std::shared_ptr<Entry> entry;
+            {
+                std::lock_guard<std::mutex> lock(m_entries_mutex);
+                for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+                {
+                    if (it->second->messenger == messenger)
+                    {
+                        entry = it->second;
+                        m_entries.erase(it);
+                        break;
+                    }
+                }
+            }
+
+            if (!entry)
+            {
+                return false;
+            }
+
+            // A running messenger is left idle, queued or removed by the thread polling it, however busy it is
+            entry->removed = true;
+            State state = entry->state;
+            while (state != State::Stopped && state != State::Removed)
+            {
+                if ((state == State::Idle || state == State::Queued) &&
+                    entry->state.compare_exchange_weak(state, State::Removed))
+                {
+                    break;
+                }
+
+                std::this_thread::yield();
+                state = entry->state;
+            }
+
+            if (state != State::Stopped && entry->fd >= 0)
+            {
+                epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry->fd, nullptr);
+            }
+            return true;
+        }
+
+        size_t EmbMessengerPool::size() const
+        {
+            std::lock_guard<std::mutex> lock(m_entries_mutex);
+            return m_entries.size();
+        }
+
+        void EmbMessengerPool::work(size_t index)
+        {
+            epoll_event events[kMaxEvents];
+
+            while (m_running)
+            {
+                std::shared_ptr<Entry> entry = take(index);
+                if (entry)
+                {
+                    run(index, entry);
+                    continue;
+                }
+
+                int count = epoll_wait(m_epoll, events, kMaxEvents, -1);
+                for (int i = 0; i < count; ++i)
+                {
+                    handleEvent(index, events[i].data.u64);
+                }
+
+                // More than this thread can start on, let another one steal
+                bool busy;
+                {
+                    std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+                    busy = m_workers[index]->queue.size() > 1;
+                }
+
+                if (busy)
+                {
+                    uint64_t one = 1;
+                    while (write(m_wake, &one, sizeof(one)) < 0 && errno == EINTR)
+                    {
+                    }
+                }
+            }
+        }
+
+        void EmbMessengerPool::handleEvent(size_t index, uint64_t id)
+        {
+            if (id == kStopId)
+            {
+                return;
+            }
+
+            if (id == kWakeId)
+            {
+                drain(m_wake);
+                rearm(m_wake, kWakeId);
+                return;
+            }
+
+            if (id == kTimerId)
+            {
+                drain(m_timer);
+                rearm(m_timer, kTimerId);
+
+                std::vector<std::shared_ptr<Entry>> entries;
+                {
+                    std::lock_guard<std::mutex> lock(m_entries_mutex);
+                    entries.reserve(m_entries.size());
+                    for (auto& entry : m_entries)
+                    {
+                        entries.push_back(entry.second);
+                    }
+                }
+
+                for (std::shared_ptr<Entry>& entry : entries)
+                {
+                    schedule(index, entry);
+                }
+                return;
+            }
+
+            std::shared_ptr<Entry> entry;
+            {
+                std::lock_guard<std::mutex> lock(m_entries_mutex);
+                auto it = m_entries.find(id);
+                if (it == m_entries.end())
+                {
+                    // Removed after the event was returned
+                    return;
+                }
+                entry = it->second;
+            }
+            schedule(index, entry);
+        }
+
+        void EmbMessengerPool::schedule(size_t index, const std::shared_ptr<Entry>& entry)
+        {
+            State state = entry->state;
+            while (true)
+            {
+                if (state == State::Idle)
+                {
+                    if (entry->state.compare_exchange_weak(state, State::Queued))
+                    {
+                        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+                        m_workers[index]->queue.push_back(entry);
+                        return;
+                    }
+                }
+                else if (state == State::Running)
+                {
+                    // The thread polling it polls it again
+                    if (entry->state.compare_exchange_weak(state, State::RunningAgain))
+                    {
+                        return;
+                    }
+                }
+                else
+                {
+                    return;
+                }
+            }
+        }
+
+        std::shared_ptr<EmbMessengerPool::Entry> EmbMessengerPool::take(size_t index)
+        {
+            std::shared_ptr<Entry> entry;
+            for (size_t i = 0; i < m_workers.size() && !entry; ++i)
+            {
+                // Own queue from the front, the others' from the back
+                Worker& worker = *m_workers[(index + i) % m_workers.size()];
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                if (worker.queue.empty())
+                {
+                    continue;
+                }
+
+                if (i == 0)
+                {
+                    entry = std::move(worker.queue.front());
+                    worker.queue.pop_front();
+                }
+                else
+                {
+                    entry = std::move(worker.queue.back());
+                    worker.queue.pop_back();
+                }
+            }
+            return entry;
+        }
+
+        void EmbMessengerPool::run(size_t index, const std::shared_ptr<Entry>& entry)
+        {
+            // Removed while it was queued
+            State state = State::Queued;
+            if (!entry->state.compare_exchange_strong(state, State::Running))
+            {
+                return;
+            }
+            size_t processed = entry->messenger->poll();
+
+            if (!entry->messenger->running())
+            {
+                if (entry->fd >= 0)
+                {
+                    epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry->fd, nullptr);
+                }
+                entry->state = State::Stopped;
+                return;
+            }
+
+            if (entry->removed)
+            {
+                entry->state = State::Removed;
+                return;
+            }
+
+            // Re-armed while still running, data arriving from here on makes it run again
+            if (entry->fd >= 0)
+            {
+                rearm(entry->fd, entry->id);
+            }
+
+            state = State::Running;
+            if (processed == 0 && entry->state.compare_exchange_strong(state, State::Idle))
+            {
+                return;
+            }
+
+            // It may have more, it goes to the back so the others get their turn
+            entry->state = State::Queued;
+            std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+            m_workers[index]->queue.push_back(entry);
+        }
+
+        void EmbMessengerPool::rearm(int fd, uint64_t id)
+        {
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLONESHOT;
+            event.data.u64 = id;
+            epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event);
+        }
+    }  // namespace host
+}  // namespace emb
+
+#endif  // !EMB_SINGLE_THREADED && __linux__
@@ -0,0 +1,89 @@
+#include "EmbMessenger/Frame.hpp"
+
+#include <cstring>
+
+namespace emb
+{
+    namespace host
+    {
+        constexpr size_t Frame::kMaxFrameSize;
+
+        Frame::Frame() : m_size(0), m_read_index(0), m_overflowed(false)
+        {
+        }
+
+        void Frame::clear()
+        {
+            m_size = 0;
+            m_read_index = 0;
+            m_overflowed = false;
+        }
+
+        void Frame::assign(const uint8_t* data, size_t size)
+        {
+            clear();
+            if (size > kMaxFrameSize)
+            {
+                size = kMaxFrameSize;
+                m_overflowed = true;
+            }
+
+            std::memcpy(m_data, data, size);
+            m_size = size;
+        }
+
+        const uint8_t* Frame::data() const
+        {
+            return m_data + m_read_index;
+        }
+
+        bool Frame::overflowed() const
+        {
+            return m_overflowed;
+        }
+
+        void Frame::writeByte(const uint8_t byte)
+        {
+            if (m_size == kMaxFrameSize)
+            {
+                m_overflowed = true;
+                return;
+            }
+            m_data[m_size++] = byte;
+        }
+
+        uint8_t Frame::peek() const
+        {
+            return empty() ? 0 : m_data[m_read_index];
+        }
+
+        uint8_t Frame::readByte()
+        {
+            return empty() ? 0 : m_data[m_read_index++];
+        }
+
+        bool Frame::empty() const
+        {
+            return m_read_index == m_size;
+        }
+
+        size_t Frame::size() const
+        {
+            return m_size - m_read_index;
+        }
+
+        uint8_t Frame::messages() const
+        {
+            return empty() ? 0 : 1;
+        }
+
+        void Frame::update()
+        {
+        }
+
+        void Frame::zero()
+        {
+            clear();
+        }
+    }  // namespace host
+}  // namespace emb
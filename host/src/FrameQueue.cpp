@@ -0,0 +1,133 @@
+#include "EmbMessenger/FrameQueue.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace emb
+{
+    namespace host
+    {
+        FrameQueue::FrameQueue(size_t capacity) : m_enqueue_position(0), m_dequeue_position(0)
+        {
+            if (capacity == 0)
+            {
+                throw std::invalid_argument("FrameQueue capacity must be at least 1");
+            }
+
+            size_t cells = 1;
+            while (cells < capacity)
+            {
+                cells <<= 1;
+            }
+
+            m_cells.reset(new Cell[cells]);
+            m_mask = cells - 1;
+
+            for (size_t i = 0; i < cells; ++i)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool FrameQueue::push(const Frame& frame)
+        {
+            Cell* cell;
+            size_t position = m_enqueue_position.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                cell = &m_cells[position & m_mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+                if (difference == 0)
+                {
+                    // The cell is free, claim it
+                    if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // The cell still holds a frame from the previous lap, the queue is full
+                    return false;
+                }
+                else
+                {
+                    position = m_enqueue_position.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->size = static_cast<uint16_t>(frame.size());
+            std::memcpy(cell->data, frame.data(), cell->size);
+            cell->sequence.store(position + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool FrameQueue::pop(Frame& frame)
+        {
+            Cell* cell;
+            size_t position = m_dequeue_position.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                cell = &m_cells[position & m_mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+                if (difference == 0)
+                {
+                    if (m_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // Nothing has been pushed to the cell yet, the queue is empty
+                    return false;
+                }
+                else
+                {
+                    position = m_dequeue_position.load(std::memory_order_relaxed);
+                }
+            }
+
+            frame.assign(cell->data, cell->size);
+            cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        size_t FrameQueue::frontSize() const
+        {
+            size_t position = m_dequeue_position.load(std::memory_order_relaxed);
+            const Cell& cell = m_cells[position & m_mask];
+            if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+            {
+                return 0;
+            }
+            return cell.size;
+        }
+
+        bool FrameQueue::empty() const
+        {
+            size_t position = m_dequeue_position.load(std::memory_order_relaxed);
+            return m_cells[position & m_mask].sequence.load(std::memory_order_acquire) != position + 1;
+        }
+
+        size_t FrameQueue::size() const
+        {
+            // The dequeue position is read first, it can't pass the enqueue position read after it
+            size_t dequeue_position = m_dequeue_position.load(std::memory_order_relaxed);
+            return m_enqueue_position.load(std::memory_order_relaxed) - dequeue_position;
+        }
+
+        size_t FrameQueue::capacity() const
+        {
+            return m_mask + 1;
+        }
+    }  // namespace host
+}  // namespace emb
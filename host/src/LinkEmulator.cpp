@@ -0,0 +1,205 @@
+#include "EmbMessenger/LinkEmulator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace emb
+{
+    namespace host
+    {
+        LinkEmulator::Channel::Channel(LinkOptions options, std::shared_ptr<IClock> clock) :
+            m_options(options),
+            m_clock(std::move(clock)),
+            m_random(options.seed),
+            m_byte_time(0),
+            m_line_free(0),
+            m_last_arrival(0)
+        {
+            if (m_options.drop_rate < 0 || m_options.drop_rate > 1 || m_options.bit_error_rate < 0 ||
+                m_options.bit_error_rate > 1)
+            {
+                throw std::invalid_argument("Link drop and bit error rates must be between 0 and 1");
+            }
+
+            if (m_options.bytes_per_second != 0)
+            {
+                m_byte_time = std::chrono::nanoseconds(1000000000) / m_options.bytes_per_second;
+            }
+        }
+
+        void LinkEmulator::Channel::send(uint8_t byte)
+        {
+            std::chrono::nanoseconds now = m_clock->now();
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            ++m_counters.bytes;
+
+            // The byte waits for the ones before it to go out, and takes the line even if it gets lost
+            m_line_free = std::max(now, m_line_free) + m_byte_time;
+
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            if (m_options.drop_rate > 0 && chance(m_random) < m_options.drop_rate)
+            {
+                ++m_counters.dropped;
+                return;
+            }
+
+            if (m_options.bit_error_rate > 0)
+            {
+                uint8_t flips = 0;
+                for (uint8_t bit = 0; bit < 8; ++bit)
+                {
+                    if (chance(m_random) < m_options.bit_error_rate)
+                    {
+                        flips |= static_cast<uint8_t>(1 << bit);
+                    }
+                }
+
+                if (flips != 0)
+                {
+                    byte ^= flips;
+                    ++m_counters.corrupted;
+                }
+            }
+
+            std::chrono::nanoseconds arrival = m_line_free + m_options.latency;
+            if (m_options.jitter.count() > 0)
+            {
+                std::uniform_int_distribution<int64_t> jitter(0, m_options.jitter.count());
+                arrival += std::chrono::nanoseconds(jitter(m_random));
+            }
+
+            // A serial line can't reorder bytes, so a byte never arrives before the one sent ahead of it
+            m_last_arrival = std::max(arrival, m_last_arrival);
+            m_in_flight.push_back({ m_last_arrival, byte });
+        }
+
+        template <typename F>
+        void LinkEmulator::Channel::receive(F&& deliver)
+        {
+            std::chrono::nanoseconds now = m_clock->now();
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            while (!m_in_flight.empty() && m_in_flight.front().arrival <= now)
+            {
+                deliver(m_in_flight.front().byte);
+                m_in_flight.pop_front();
+            }
+        }
+
+        LinkEmulator::Counters LinkEmulator::Channel::counters() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return m_counters;
+        }
+
+        LinkEmulator::End::End(std::shared_ptr<Channel> incoming, std::shared_ptr<Channel> outgoing) :
+            m_incoming(std::move(incoming)),
+            m_outgoing(std::move(outgoing)),
+            m_messages(0)
+        {
+        }
+
+        void LinkEmulator::End::writeByte(const uint8_t byte)
+        {
+            m_outgoing->send(byte);
+        }
+
+        uint8_t LinkEmulator::End::peek() const
+        {
+            return m_received.front();
+        }
+
+        uint8_t LinkEmulator::End::readByte()
+        {
+            uint8_t byte = m_received.front();
+            m_received.pop_front();
+
+            if (m_read_splitter.push(byte) && m_messages > 0)
+            {
+                --m_messages;
+            }
+            return byte;
+        }
+
+        bool LinkEmulator::End::empty() const
+        {
+            return m_received.empty();
+        }
+
+        size_t LinkEmulator::End::size() const
+        {
+            return m_received.size();
+        }
+
+        uint8_t LinkEmulator::End::messages() const
+        {
+            return static_cast<uint8_t>(std::min<size_t>(m_messages, std::numeric_limits<uint8_t>::max()));
+        }
+
+        void LinkEmulator::End::update()
+        {
+            m_incoming->receive([this](uint8_t byte) {
+                m_received.push_back(byte);
+                if (m_arrive_splitter.push(byte))
+                {
+                    ++m_messages;
+                }
+            });
+        }
+
+        void LinkEmulator::End::zero()
+        {
+            m_received.clear();
+            m_messages = 0;
+            m_arrive_splitter.reset();
+            m_read_splitter.reset();
+        }
+
+        LinkEmulator::LinkEmulator(LinkOptions options, std::shared_ptr<IClock> clock) :
+            LinkEmulator(options,
+                         [&options] {
+                             LinkOptions device_to_host = options;
+                             ++device_to_host.seed;
+                             return device_to_host;
+                         }(),
+                         std::move(clock))
+        {
+        }
+
+        LinkEmulator::LinkEmulator(LinkOptions host_to_device, LinkOptions device_to_host,
+                                   std::shared_ptr<IClock> clock) :
+            m_to_device(std::make_shared<Channel>(host_to_device, clock)),
+            m_to_host(std::make_shared<Channel>(device_to_host, clock)),
+            m_host(std::make_shared<End>(m_to_host, m_to_device)),
+            m_device(std::make_shared<End>(m_to_device, m_to_host))
+        {
+        }
+
+        std::shared_ptr<shared::IBuffer> LinkEmulator::host() const
+        {
+            return m_host;
+        }
+
+        std::shared_ptr<shared::IBuffer> LinkEmulator::device() const
+        {
+            return m_device;
+        }
+
+        LinkEmulator::Counters LinkEmulator::hostToDevice() const
+        {
+            return m_to_device->counters();
+        }
+
+        LinkEmulator::Counters LinkEmulator::deviceToHost() const
+        {
+            return m_to_host->counters();
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,298 @@
+#include "EmbMessenger/Metrics.hpp"
+
+#include <memory>
+#include <utility>
+
+#include "EmbMessenger/Exceptions.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        constexpr size_t ShardedCounter::kShards;
+        constexpr size_t HistogramSnapshot::kSubBucketBits;
+        constexpr size_t HistogramSnapshot::kSubBuckets;
+        constexpr size_t HistogramSnapshot::kBuckets;
+        constexpr size_t Metrics::kErrorTypes;
+        constexpr size_t Metrics::kRttBlockSize;
+
+        ShardedCounter::ShardedCounter()
+        {
+            for (Shard& shard : m_shards)
+            {
+                shard.value = 0;
+            }
+        }
+
+        size_t ShardedCounter::shardIndex()
+        {
+            // Threads are dealt out to the shards in the order they first count something
+            static std::atomic<size_t> next_shard(0);
+            static thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+            return shard;
+        }
+
+        uint64_t ShardedCounter::load() const
+        {
+            uint64_t sum = 0;
+            for (const Shard& shard : m_shards)
+            {
+                sum += shard.value.load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+
+        size_t HistogramSnapshot::bucket(uint64_t latency)
+        {
+            if (latency < kSubBuckets)
+            {
+                return static_cast<size_t>(latency);
+            }
+
+            size_t exponent = kSubBucketBits;
+            while (exponent < 63 && (latency >> (exponent + 1)) != 0)
+            {
+                ++exponent;
+            }
+
+            // The bits below the leading one pick the sub bucket
+            size_t index = (exponent - kSubBucketBits + 1) * kSubBuckets +
+                           ((latency >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+            return index < kBuckets ? index : kBuckets - 1;
+        }
+
+        uint64_t HistogramSnapshot::bucketUpperBound(size_t bucket)
+        {
+            if (bucket < kSubBuckets)
+            {
+                return bucket;
+            }
+
+            size_t shift = bucket / kSubBuckets - 1;
+            uint64_t lower = static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets) << shift;
+            return lower + (uint64_t(1) << shift) - 1;
+        }
+
+        std::chrono::microseconds HistogramSnapshot::mean() const
+        {
+            if (count == 0)
+            {
+                return std::chrono::microseconds::zero();
+            }
+            return sum / static_cast<std::chrono::microseconds::rep>(count);
+        }
+
+        std::chrono::microseconds HistogramSnapshot::percentile(double percentile) const
+        {
+            if (count == 0)
+            {
+                return std::chrono::microseconds::zero();
+            }
+
+            if (percentile <= 0)
+            {
+                return min;
+            }
+
+            uint64_t rank = static_cast<uint64_t>(percentile / 100 * count + 0.5);
+            if (rank < 1)
+            {
+                rank = 1;
+            }
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                {
+                    // The last bucket may only be partly used
+                    std::chrono::microseconds upper(static_cast<std::chrono::microseconds::rep>(bucketUpperBound(i)));
+                    return upper < max ? upper : max;
+                }
+            }
+            return max;
+        }
+
+        LatencyHistogram::LatencyHistogram() : m_sum(0), m_min(UINT64_MAX), m_max(0)
+        {
+            for (std::atomic<uint64_t>& count : m_counts)
+            {
+                count = 0;
+            }
+        }
+
+        void LatencyHistogram::record(std::chrono::microseconds latency)
+        {
+            uint64_t value = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+
+            m_counts[HistogramSnapshot::bucket(value)].fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(value, std::memory_order_relaxed);
+
+            uint64_t min = m_min.load(std::memory_order_relaxed);
+            while (value < min && !m_min.compare_exchange_weak(min, value, std::memory_order_relaxed))
+            {
+            }
+
+            uint64_t max = m_max.load(std::memory_order_relaxed);
+            while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        HistogramSnapshot LatencyHistogram::snapshot() const
+        {
+            HistogramSnapshot snapshot;
+            for (size_t i = 0; i < HistogramSnapshot::kBuckets; ++i)
+            {
+                snapshot.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+                snapshot.count += snapshot.counts[i];
+            }
+
+            if (snapshot.count != 0)
+            {
+                snapshot.sum = std::chrono::microseconds(m_sum.load(std::memory_order_relaxed));
+                snapshot.min = std::chrono::microseconds(m_min.load(std::memory_order_relaxed));
+                snapshot.max = std::chrono::microseconds(m_max.load(std::memory_order_relaxed));
+            }
+            return snapshot;
+        }
+
+        Metrics::Metrics() :
+            m_start(std::chrono::steady_clock::now()),
+            m_other_errors(0),
+            m_std_errors(0),
+            m_unknown_errors(0)
+        {
+            for (std::atomic<RttBlock*>& block : m_command_rtt)
+            {
+                block = nullptr;
+            }
+
+            for (size_t i = 0; i < kErrorTypes; ++i)
+            {
+                m_errors[i] = 0;
+                m_error_names[i] = nullptr;
+            }
+        }
+
+        void Metrics::addCommand(uint16_t command_id)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_command_rtt_mutex);
+#endif
+            std::unique_ptr<LatencyHistogram>& histogram = m_rtt_histograms[command_id];
+            if (histogram != nullptr)
+            {
+                return;
+            }
+            histogram.reset(new LatencyHistogram());
+
+            std::atomic<RttBlock*>& block = m_command_rtt[command_id / kRttBlockSize];
+            if (block.load(std::memory_order_relaxed) == nullptr)
+            {
+                m_rtt_blocks.emplace_back(new RttBlock());
+                for (std::atomic<LatencyHistogram*>& slot : m_rtt_blocks.back()->histograms)
+                {
+                    slot = nullptr;
+                }
+                block.store(m_rtt_blocks.back().get(), std::memory_order_release);
+            }
+            block.load(std::memory_order_relaxed)
+                ->histograms[command_id % kRttBlockSize]
+                .store(histogram.get(), std::memory_order_release);
+        }
+
+        void Metrics::countError(std::exception_ptr error)
+        {
+            try
+            {
+                std::rethrow_exception(error);
+            }
+            catch (const BaseException& e)
+            {
+                size_t index = e.getTypeIndex();
+                if (index >= kErrorTypes)
+                {
+                    m_other_errors.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                // Released with the count, a snapshot that sees the count sees the name
+                m_error_names[index].store(e.getName(), std::memory_order_relaxed);
+                m_errors[index].fetch_add(1, std::memory_order_release);
+            }
+            catch (const std::exception&)
+            {
+                m_std_errors.fetch_add(1, std::memory_order_relaxed);
+            }
+            catch (...)
+            {
+                m_unknown_errors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void Metrics::recordRtt(uint16_t command_id, std::chrono::microseconds rtt)
+        {
+            RttBlock* block = m_command_rtt[command_id / kRttBlockSize].load(std::memory_order_acquire);
+            if (block == nullptr)
+            {
+                return;
+            }
+
+            LatencyHistogram* histogram = block->histograms[command_id % kRttBlockSize].load(std::memory_order_acquire);
+            if (histogram != nullptr)
+            {
+                histogram->record(rtt);
+            }
+        }
+
+        MetricsSnapshot Metrics::snapshot() const
+        {
+            MetricsSnapshot snapshot;
+            snapshot.uptime = std::chrono::steady_clock::now() - m_start;
+
+            snapshot.tx_bytes = m_tx_bytes.load();
+            snapshot.tx_frames = m_tx_frames.load();
+            snapshot.rx_bytes = m_rx_bytes.load();
+            snapshot.rx_frames = m_rx_frames.load();
+            snapshot.crc_failures = m_crc_failures.load();
+            snapshot.device_crc_failures = m_device_crc_failures.load();
+
+            for (size_t i = 0; i < kErrorTypes; ++i)
+            {
+                uint64_t count = m_errors[i].load(std::memory_order_acquire);
+                const char* name = m_error_names[i].load(std::memory_order_relaxed);
+                if (count != 0 && name != nullptr)
+                {
+                    snapshot.errors[name] = count;
+                }
+            }
+
+            const std::pair<const char*, const std::atomic<uint64_t>*> others[] = {
+                { "other", &m_other_errors }, { "std::exception", &m_std_errors }, { "unknown", &m_unknown_errors }
+            };
+            for (const auto& other : others)
+            {
+                uint64_t count = other.second->load(std::memory_order_relaxed);
+                if (count != 0)
+                {
+                    snapshot.errors[other.first] = count;
+                }
+            }
+
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_command_rtt_mutex);
+#endif
+            for (const auto& command : m_rtt_histograms)
+            {
+                HistogramSnapshot histogram = command.second->snapshot();
+                if (histogram.count != 0)
+                {
+                    snapshot.command_rtt.emplace(command.first, histogram);
+                }
+            }
+            return snapshot;
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,299 @@
+#include "EmbMessenger/ProtocolLog.hpp"
+#include "EmbMessenger/BusAddress.hpp"
+#include "EmbMessenger/Frame.hpp"
+#include "EmbMessenger/Reader.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace
+        {
+            // Number of hex digits for printing an unsigned value with leading 0's
+            int hexWidth(uint64_t value)
+            {
+                int width = 2;
+                while (width < 16 && (value >> (width * 4)) != 0)
+                {
+                    width *= 2;
+                }
+                return width;
+            }
+
+            bool isUnsigned(shared::DataType type)
+            {
+                return type == shared::kPosFixInt || type == shared::kUint8 || type == shared::kUint16 ||
+                       type == shared::kUint32 || type == shared::kUint64;
+            }
+
+            bool isSigned(shared::DataType type)
+            {
+                return type == shared::kNegFixInt || type == shared::kInt8 || type == shared::kInt16 ||
+                       type == shared::kInt32 || type == shared::kInt64;
+            }
+
+            // Reads the value of the next parameter into the event
+            bool readValue(shared::Reader& reader, ProtocolEvent& event)
+            {
+                switch (event.data_type)
+                {
+                    case shared::kNull:
+                        return reader.readNull();
+
+                    case shared::kBoolFalse:
+                    case shared::kBoolTrue: {
+                        bool value = false;
+                        bool valid = reader.read(value);
+                        event.unsigned_value = value;
+                        return valid;
+                    }
+
+                    case shared::kFloat:
+                        return reader.read(event.float_value);
+
+                    case shared::kError: {
+                        uint8_t code = 0;
+                        bool valid = reader.readError(code);
+                        event.type = ProtocolEventType::Error;
+                        event.unsigned_value = code;
+
+                        // Errors reported by commands are followed by their data
+                        int16_t data = 0;
+                        if (valid && reader.read(data))
+                        {
+                            event.signed_value = data;
+                        }
+                        return valid;
+                    }
+
+                    default:
+                        if (isUnsigned(event.data_type))
+                        {
+                            return reader.read(event.unsigned_value);
+                        }
+                        return reader.read(event.signed_value);
+                }
+            }
+        }  // namespace
+
+        void decodeMessage(CaptureDirection direction, std::chrono::nanoseconds time, const uint8_t* data,
+                           size_t size, std::vector<ProtocolEvent>& events, bool addressed)
+        {
+            Frame frame;
+            frame.assign(data, size);
+            shared::Reader reader(&frame);
+
+            ProtocolEvent event;
+            event.time = time;
+            event.direction = direction;
+
+            // Messages on a bus start with the address, all messages have a message id and messages from the host
+            // also have a command id
+            uint8_t address = 0;
+            uint16_t command_id = 0;
+            if ((addressed && !reader.read(address)) || !reader.read(event.message_id) ||
+                (direction == CaptureDirection::HostToDevice && !reader.read(command_id)))
+            {
+                event.type = ProtocolEventType::Malformed;
+                events.push_back(event);
+                return;
+            }
+
+            if (addressed)
+            {
+                event.type = ProtocolEventType::Address;
+                event.unsigned_value = address;
+                events.push_back(event);
+
+                event.type = ProtocolEventType::Message;
+                event.unsigned_value = 0;
+            }
+            events.push_back(event);
+
+            if (direction == CaptureDirection::HostToDevice)
+            {
+                event.type = ProtocolEventType::Command;
+                event.unsigned_value = command_id;
+                events.push_back(event);
+            }
+
+            uint16_t index = 0;
+            while (!frame.empty())
+            {
+                ProtocolEvent value;
+                value.time = time;
+                value.direction = direction;
+                value.message_id = event.message_id;
+                value.index = index;
+
+                if (!reader.getType(value.data_type))
+                {
+                    value.type = ProtocolEventType::Unknown;
+                    value.data_type = static_cast<shared::DataType>(frame.readByte());
+                }
+                else if (value.data_type == shared::kEndOfMessage)
+                {
+                    value.type = ProtocolEventType::EndOfMessage;
+                    value.crc_valid = reader.readCrc();
+                }
+                else
+                {
+                    value.type = ProtocolEventType::Value;
+                    if (!readValue(reader, value))
+                    {
+                        value.type = ProtocolEventType::Truncated;
+                        events.push_back(value);
+                        return;
+                    }
+                }
+
+                events.push_back(value);
+                ++index;
+            }
+        }
+
+        std::vector<ProtocolEvent> decodeLog(const std::vector<CaptureRecord>& records, bool addressed)
+        {
+            std::vector<ProtocolEvent> events;
+            for (const CaptureRecord& record : records)
+            {
+                decodeMessage(record.direction, record.time, record.data.data(), record.data.size(), events,
+                              addressed);
+            }
+            return events;
+        }
+
+        const char* dataTypeName(shared::DataType type)
+        {
+            switch (type)
+            {
+                case shared::kNull:
+                    return "Null";
+                case shared::kBoolFalse:
+                case shared::kBoolTrue:
+                    return "Bool";
+                case shared::kFloat:
+                    return "Float";
+                case shared::kPosFixInt:
+                    return "PosFixInt";
+                case shared::kUint8:
+                    return "Uint8";
+                case shared::kUint16:
+                    return "Uint16";
+                case shared::kUint32:
+                    return "Uint32";
+                case shared::kUint64:
+                    return "Uint64";
+                case shared::kNegFixInt:
+                    return "NegFixInt";
+                case shared::kInt8:
+                    return "Int8";
+                case shared::kInt16:
+                    return "Int16";
+                case shared::kInt32:
+                    return "Int32";
+                case shared::kInt64:
+                    return "Int64";
+                case shared::kEndOfMessage:
+                    return "EndOfMessage";
+                case shared::kError:
+                    return "Error";
+                default:
+                    return "Unknown";
+            }
+        }
+
+        std::string formatEvent(const ProtocolEvent& event)
+        {
+            const char* source = (event.direction == CaptureDirection::HostToDevice ? "Write" : "Read ");
+            std::stringstream ss;
+            ss << source << " ";
+
+            switch (event.type)
+            {
+                case ProtocolEventType::Address:
+                    ss << "Address: " << event.unsigned_value;
+                    if (event.unsigned_value == shared::kBroadcastAddress)
+                    {
+                        ss << " Broadcast";
+                    }
+                    return ss.str();
+
+                case ProtocolEventType::Message:
+                    ss << "Message Id: " << event.message_id;
+                    return ss.str();
+
+                case ProtocolEventType::Command:
+                    ss << "Command Id: " << event.unsigned_value;
+                    return ss.str();
+
+                case ProtocolEventType::EndOfMessage:
+                    ss << "Message " << event.message_id << " CRC " << (event.crc_valid ? "Valid" : "Invalid");
+                    return ss.str();
+
+                case ProtocolEventType::Malformed:
+                    ss << "Malformed Message";
+                    return ss.str();
+
+                default:
+                    break;
+            }
+
+            // Everything else is about a parameter
+            ss << std::setw(3) << event.index << ": ";
+            switch (event.type)
+            {
+                case ProtocolEventType::Error:
+                    ss << "Error " << event.unsigned_value << " 0x" << std::hex << std::uppercase
+                       << event.unsigned_value << std::dec << " " << event.signed_value;
+                    break;
+
+                case ProtocolEventType::Unknown:
+                    ss << "Unknown Type 0x" << std::hex << std::uppercase << +static_cast<uint8_t>(event.data_type)
+                       << std::dec;
+                    break;
+
+                case ProtocolEventType::Truncated:
+                    ss << "Truncated";
+                    break;
+
+                default:
+                    if (event.data_type == shared::kNull)
+                    {
+                        ss << "Null";
+                    }
+                    else if (event.data_type == shared::kBoolFalse || event.data_type == shared::kBoolTrue)
+                    {
+                        ss << (event.unsigned_value ? "True" : "False");
+                    }
+                    else if (event.data_type == shared::kFloat)
+                    {
+                        ss << event.float_value;
+                    }
+                    else if (isUnsigned(event.data_type))
+                    {
+                        // Print it with '0x' and leading 0's
+                        ss << event.unsigned_value << " 0x" << std::hex << std::uppercase << std::setfill('0')
+                           << std::setw(hexWidth(event.unsigned_value)) << event.unsigned_value << std::setfill(' ')
+                           << std::dec;
+                    }
+                    else if (isSigned(event.data_type))
+                    {
+                        ss << event.signed_value;
+                        // If the int is a printable char
+                        if (event.data_type == shared::kInt8 && event.signed_value >= 0x20 &&
+                            event.signed_value <= 0x7E)
+                        {
+                            ss << " '" << static_cast<char>(event.signed_value) << "'";
+                        }
+                    }
+                    break;
+            }
+
+            return ss.str();
+        }
+    }  // namespace host
+}  // namespace emb
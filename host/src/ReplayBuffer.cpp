@@ -0,0 +1,212 @@
+#include "EmbMessenger/ReplayBuffer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace
+        {
+            std::unique_ptr<std::ifstream> openReplay(const std::string& path)
+            {
+                std::unique_ptr<std::ifstream> file(new std::ifstream(path, std::ios::binary));
+                if (!file->is_open())
+                {
+                    throw std::runtime_error("Unable to open capture file " + path);
+                }
+                return file;
+            }
+        }  // namespace
+
+        ReplayBuffer::ReplayBuffer(std::istream& input, ReplaySpeed speed) :
+            m_records(readCapture(input)),
+            m_speed(speed),
+            m_next_record(0),
+            m_host_messages_released(0),
+            m_anchor_capture_time(0),
+            m_anchor_time(clock_t::now()),
+            m_read_offset(0),
+            m_released_bytes(0),
+            m_mismatches(0)
+        {
+            for (size_t i = 0; i < m_records.size(); ++i)
+            {
+                if (m_records[i].direction == CaptureDirection::HostToDevice)
+                {
+                    m_host_records.push_back(i);
+                }
+            }
+            m_write_times.reserve(m_host_records.size());
+        }
+
+        ReplayBuffer::ReplayBuffer(const std::string& path, ReplaySpeed speed) : ReplayBuffer(*openReplay(path), speed)
+        {
+        }
+
+        void ReplayBuffer::release()
+        {
+            clock_t::time_point now = clock_t::now();
+
+            while (m_next_record < m_records.size())
+            {
+                const CaptureRecord& record = m_records[m_next_record];
+                if (record.direction == CaptureDirection::HostToDevice)
+                {
+                    // Nothing after it until the host sends it
+                    if (m_write_times.size() <= m_host_messages_released)
+                    {
+                        break;
+                    }
+
+                    m_anchor_capture_time = record.time;
+                    m_anchor_time = m_write_times[m_host_messages_released];
+                    ++m_host_messages_released;
+                }
+                else
+                {
+                    if (m_speed == ReplaySpeed::Original && now < m_anchor_time + (record.time - m_anchor_capture_time))
+                    {
+                        break;
+                    }
+
+                    if (!record.data.empty())
+                    {
+                        m_released.push_back(&record);
+                        m_released_bytes += record.data.size();
+                    }
+                }
+
+                ++m_next_record;
+            }
+        }
+
+        bool ReplayBuffer::finished() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            if (!m_released.empty())
+            {
+                return false;
+            }
+
+            return std::none_of(m_records.begin() + m_next_record, m_records.end(), [](const CaptureRecord& record) {
+                return record.direction == CaptureDirection::DeviceToHost && !record.data.empty();
+            });
+        }
+
+        size_t ReplayBuffer::mismatches() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return m_mismatches;
+        }
+
+        void ReplayBuffer::writeByte(const uint8_t byte)
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            m_written.writeByte(byte);
+            bool end = m_splitter.push(byte);
+            if (!end && !m_written.overflowed())
+            {
+                return;
+            }
+
+            size_t index = m_write_times.size();
+            if (index >= m_host_records.size() ||
+                m_records[m_host_records[index]].data.size() != m_written.size() ||
+                !std::equal(m_written.data(), m_written.data() + m_written.size(),
+                            m_records[m_host_records[index]].data.begin()))
+            {
+                ++m_mismatches;
+            }
+            m_write_times.push_back(clock_t::now());
+
+            if (!end)
+            {
+                m_splitter.reset();
+            }
+            m_written.clear();
+        }
+
+        uint8_t ReplayBuffer::peek() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            if (m_released.empty())
+            {
+                return 0;
+            }
+            return m_released.front()->data[m_read_offset];
+        }
+
+        uint8_t ReplayBuffer::readByte()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            if (m_released.empty())
+            {
+                return 0;
+            }
+
+            const std::vector<uint8_t>& data = m_released.front()->data;
+            uint8_t byte = data[m_read_offset++];
+            --m_released_bytes;
+
+            if (m_read_offset == data.size())
+            {
+                m_released.pop_front();
+                m_read_offset = 0;
+            }
+            return byte;
+        }
+
+        bool ReplayBuffer::empty() const
+        {
+            return size() == 0;
+        }
+
+        size_t ReplayBuffer::size() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return m_released_bytes;
+        }
+
+        uint8_t ReplayBuffer::messages() const
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            return static_cast<uint8_t>(std::min<size_t>(m_released.size(), 0xFF));
+        }
+
+        void ReplayBuffer::update()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            release();
+        }
+
+        void ReplayBuffer::zero()
+        {
+#ifndef EMB_SINGLE_THREADED
+            std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+            m_released.clear();
+            m_read_offset = 0;
+            m_released_bytes = 0;
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,92 @@
+#include "EmbMessenger/RttEstimator.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        RttEstimator::RttEstimator(std::chrono::microseconds min_timeout, std::chrono::microseconds max_timeout) :
+            m_min_timeout(min_timeout),
+            m_max_timeout(max_timeout)
+        {
+            reset();
+        }
+
+        void RttEstimator::addSample(std::chrono::microseconds rtt)
+        {
+            if (rtt < std::chrono::microseconds::zero())
+            {
+                rtt = std::chrono::microseconds::zero();
+            }
+
+            m_last_rtt = rtt;
+            if (m_samples++ == 0)
+            {
+                m_smoothed_rtt_8 = rtt * 8;
+                m_rtt_variance_4 = rtt * 2;
+                m_min_rtt = rtt;
+                return;
+            }
+
+            std::chrono::microseconds error = rtt - m_smoothed_rtt_8 / 8;
+            m_smoothed_rtt_8 += error;
+            if (error < std::chrono::microseconds::zero())
+            {
+                error = -error;
+            }
+            m_rtt_variance_4 += error - m_rtt_variance_4 / 4;
+
+            if (rtt < m_min_rtt)
+            {
+                m_min_rtt = rtt;
+            }
+        }
+
+        void RttEstimator::reset()
+        {
+            m_smoothed_rtt_8 = std::chrono::microseconds::zero();
+            m_rtt_variance_4 = std::chrono::microseconds::zero();
+            m_min_rtt = std::chrono::microseconds::zero();
+            m_last_rtt = std::chrono::microseconds::zero();
+            m_samples = 0;
+        }
+
+        size_t RttEstimator::samples() const
+        {
+            return m_samples;
+        }
+
+        std::chrono::microseconds RttEstimator::smoothedRtt() const
+        {
+            return m_smoothed_rtt_8 / 8;
+        }
+
+        std::chrono::microseconds RttEstimator::rttVariance() const
+        {
+            return m_rtt_variance_4 / 4;
+        }
+
+        std::chrono::microseconds RttEstimator::minRtt() const
+        {
+            return m_min_rtt;
+        }
+
+        std::chrono::microseconds RttEstimator::lastRtt() const
+        {
+            return m_last_rtt;
+        }
+
+        std::chrono::microseconds RttEstimator::timeout(std::chrono::microseconds fallback) const
+        {
+            std::chrono::microseconds timeout = m_samples == 0 ? fallback : m_smoothed_rtt_8 / 8 + m_rtt_variance_4;
+            if (timeout < m_min_timeout)
+            {
+                return m_min_timeout;
+            }
+            if (timeout > m_max_timeout)
+            {
+                return m_max_timeout;
+            }
+            return timeout;
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,76 @@
+#include "EmbMessenger/ThreadPoolExecutor.hpp"
+
+#ifndef EMB_SINGLE_THREADED
+
+#include <stdexcept>
+
+namespace emb
+{
+    namespace host
+    {
+        ThreadPoolExecutor::ThreadPoolExecutor(size_t threads)
+        {
+            if (threads == 0)
+            {
+                throw std::invalid_argument("ThreadPoolExecutor needs at least 1 thread");
+            }
+
+            for (size_t i = 0; i < threads; ++i)
+            {
+                m_workers.emplace_back(new Worker());
+                m_workers.back()->thread = std::thread(&ThreadPoolExecutor::work, m_workers.back().get());
+            }
+        }
+
+        ThreadPoolExecutor::~ThreadPoolExecutor()
+        {
+            for (std::unique_ptr<Worker>& worker : m_workers)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(worker->mutex);
+                    worker->running = false;
+                }
+                worker->condition_variable.notify_one();
+            }
+
+            for (std::unique_ptr<Worker>& worker : m_workers)
+            {
+                worker->thread.join();
+            }
+        }
+
+        void ThreadPoolExecutor::execute(uint16_t key, std::function<void()> task)
+        {
+            Worker& worker = *m_workers[key % m_workers.size()];
+            {
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                worker.tasks.emplace_back(std::move(task));
+            }
+            worker.condition_variable.notify_one();
+        }
+
+        void ThreadPoolExecutor::work(Worker* worker)
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+
+            while (true)
+            {
+                worker->condition_variable.wait(lock, [worker] { return !worker->tasks.empty() || !worker->running; });
+
+                if (worker->tasks.empty())
+                {
+                    break;
+                }
+
+                std::function<void()> task = std::move(worker->tasks.front());
+                worker->tasks.pop_front();
+
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMB_SINGLE_THREADED
@@ -0,0 +1,244 @@
+#include "EmbMessenger/TimerWheel.hpp"
+
+#include <stdexcept>
+
+namespace emb
+{
+    namespace host
+    {
+        constexpr size_t TimerWheel::kLevels;
+        constexpr uint32_t TimerWheel::kNone;
+
+        namespace
+        {
+            // The first level has 256 slots, the others 64
+            constexpr unsigned kFirstBits = 8;
+            constexpr unsigned kLevelBits = 6;
+            constexpr uint64_t kFirstSlots = 1 << kFirstBits;
+            constexpr uint64_t kLevelSlots = 1 << kLevelBits;
+
+            constexpr unsigned levelShift(unsigned level)
+            {
+                return kFirstBits + (level - 1) * kLevelBits;
+            }
+
+            constexpr uint32_t levelOffset(unsigned level)
+            {
+                return kFirstSlots + (level - 1) * kLevelSlots;
+            }
+
+            // Ticks covered by the whole wheel
+            constexpr uint64_t kReach = uint64_t(1) << levelShift(4);
+        }  // namespace
+
+        TimerWheel::TimerWheel(size_t timers, clock_t::duration tick, clock_t::time_point start) :
+            m_timers(timers),
+            m_lists(kFirstSlots + (kLevels - 1) * kLevelSlots, kNone),
+            m_start(start),
+            m_tick(tick),
+            m_current_tick(0),
+            m_size(0),
+            m_first_level_size(0)
+        {
+            if (timers >= kNone)
+            {
+                throw std::invalid_argument("TimerWheel can have at most 4294967294 timers");
+            }
+
+            if (tick <= clock_t::duration::zero())
+            {
+                throw std::invalid_argument("TimerWheel tick must be positive");
+            }
+
+            for (Timer& timer : m_timers)
+            {
+                timer.scheduled = false;
+            }
+        }
+
+        uint64_t TimerWheel::toTick(clock_t::time_point time) const
+        {
+            if (time <= m_start)
+            {
+                return 0;
+            }
+            return (time - m_start) / m_tick;
+        }
+
+        void TimerWheel::place(uint32_t index)
+        {
+            Timer& timer = m_timers[index];
+            uint64_t delta = timer.expiry - m_current_tick;
+
+            uint32_t list;
+            if (timer.expiry <= m_current_tick || delta < kFirstSlots)
+            {
+                list = timer.expiry & (kFirstSlots - 1);
+            }
+            else if (delta < (uint64_t(1) << levelShift(2)))
+            {
+                list = levelOffset(1) + ((timer.expiry >> levelShift(1)) & (kLevelSlots - 1));
+            }
+            else if (delta < (uint64_t(1) << levelShift(3)))
+            {
+                list = levelOffset(2) + ((timer.expiry >> levelShift(2)) & (kLevelSlots - 1));
+            }
+            else
+            {
+                // Out of reach, parked at the far end of the last level until it comes around
+                uint64_t expiry = delta < kReach ? timer.expiry : m_current_tick + kReach - 1;
+                list = levelOffset(3) + ((expiry >> levelShift(3)) & (kLevelSlots - 1));
+            }
+
+            if (list < kFirstSlots)
+            {
+                ++m_first_level_size;
+            }
+
+            timer.list = list;
+            timer.previous = kNone;
+            timer.next = m_lists[list];
+            if (timer.next != kNone)
+            {
+                m_timers[timer.next].previous = index;
+            }
+            m_lists[list] = index;
+        }
+
+        void TimerWheel::unlink(uint32_t index)
+        {
+            Timer& timer = m_timers[index];
+            if (timer.list < kFirstSlots)
+            {
+                --m_first_level_size;
+            }
+
+            if (timer.previous != kNone)
+            {
+                m_timers[timer.previous].next = timer.next;
+            }
+            else
+            {
+                m_lists[timer.list] = timer.next;
+            }
+
+            if (timer.next != kNone)
+            {
+                m_timers[timer.next].previous = timer.previous;
+            }
+        }
+
+        void TimerWheel::cascade()
+        {
+            // Each time a level wraps around, the next slot of the level above is spread over the levels below
+            for (unsigned level = 1; level < kLevels; ++level)
+            {
+                if ((m_current_tick & ((uint64_t(1) << levelShift(level)) - 1)) != 0)
+                {
+                    break;
+                }
+
+                uint32_t list = levelOffset(level) + ((m_current_tick >> levelShift(level)) & (kLevelSlots - 1));
+                uint32_t index = m_lists[list];
+                m_lists[list] = kNone;
+
+                while (index != kNone)
+                {
+                    uint32_t next = m_timers[index].next;
+                    place(index);
+                    index = next;
+                }
+            }
+        }
+
+        void TimerWheel::skipIdleTicks(uint64_t target)
+        {
+            if (m_first_level_size != 0)
+            {
+                return;
+            }
+
+            // Nothing can expire before the first level wraps around and the level above cascades into it
+            uint64_t last_idle = m_current_tick | (kFirstSlots - 1);
+            m_current_tick = last_idle < target ? last_idle : target;
+        }
+
+        uint32_t TimerWheel::popExpired()
+        {
+            uint32_t index = m_lists[m_current_tick & (kFirstSlots - 1)];
+            if (index == kNone)
+            {
+                return kNone;
+            }
+
+            unlink(index);
+            m_timers[index].scheduled = false;
+            --m_size;
+            return index;
+        }
+
+        void TimerWheel::schedule(uint32_t timer, clock_t::time_point deadline)
+        {
+            if (m_timers[timer].scheduled)
+            {
+                unlink(timer);
+            }
+            else
+            {
+                m_timers[timer].scheduled = true;
+                ++m_size;
+            }
+
+            // Rounded up so the timer never fires early
+            uint64_t expiry = toTick(deadline);
+            if (m_start + expiry * m_tick < deadline)
+            {
+                ++expiry;
+            }
+            if (expiry <= m_current_tick)
+            {
+                expiry = m_current_tick + 1;
+            }
+
+            m_timers[timer].expiry = expiry;
+            place(timer);
+        }
+
+        void TimerWheel::cancel(uint32_t timer)
+        {
+            if (!m_timers[timer].scheduled)
+            {
+                return;
+            }
+
+            unlink(timer);
+            m_timers[timer].scheduled = false;
+            --m_size;
+        }
+
+        bool TimerWheel::scheduled(uint32_t timer) const
+        {
+            return m_timers[timer].scheduled;
+        }
+
+        size_t TimerWheel::size() const
+        {
+            return m_size;
+        }
+
+        size_t TimerWheel::capacity() const
+        {
+            return m_timers.size();
+        }
+
+        TimerWheel::clock_t::time_point TimerWheel::nextTick() const
+        {
+            return m_start + (m_current_tick + 1) * m_tick;
+        }
+
+        TimerWheel::clock_t::time_point TimerWheel::time() const
+        {
+            return m_start + m_current_tick * m_tick;
+        }
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,65 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<size_t> allocations(0);
+
+    void* countedAllocate(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        void* pointer = std::malloc(size == 0 ? 1 : size);
+        if (pointer == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+}  // namespace
+
+void* operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            size_t allocationCount()
+            {
+                return allocations.load(std::memory_order_relaxed);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
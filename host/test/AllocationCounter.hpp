@@ -0,0 +1,22 @@
+#ifndef EMBMESSENGER_TEST_ALLOCATIONCOUNTER_HPP
+#define EMBMESSENGER_TEST_ALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            /**
+             * @brief Gets the number of calls to the global operator new made by the test executable.
+             *
+             * @returns Number of heap allocations so far
+             */
+            size_t allocationCount();
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_TEST_ALLOCATIONCOUNTER_HPP
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "EmbMessenger/BusAddress.hpp"
+#include "EmbMessenger/BusEmulator.hpp"
+#include "EmbMessenger/BusRouter.hpp"
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/IAddressable.hpp"
+#include "EmbMessenger/LinkEmulator.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            namespace
+            {
+                std::vector<uint8_t> readAll(shared::IBuffer& buffer)
+                {
+                    std::vector<uint8_t> bytes;
+                    while (!buffer.empty())
+                    {
+                        bytes.push_back(buffer.readByte());
+                    }
+                    return bytes;
+                }
+
+                void writeAll(shared::IBuffer& buffer, const std::vector<uint8_t>& bytes)
+                {
+                    for (uint8_t byte : bytes)
+                    {
+                        buffer.writeByte(byte);
+                    }
+                }
+
+                // The CRC bytes don't matter to the router and the bus
+                const std::vector<uint8_t> kForFirst = { 0x01, 0x07, shared::DataType::kEndOfMessage, 0x11 };
+                const std::vector<uint8_t> kForSecond = { shared::DataType::kUint8, 0x90, 0x07,
+                                                          shared::DataType::kEndOfMessage, 0x22 };
+                const std::vector<uint8_t> kForNobody = { 0x03, 0x07, shared::DataType::kEndOfMessage, 0x33 };
+            }  // namespace
+
+            TEST(bus_router, routes_by_address)
+            {
+                LinkEmulator link(LinkOptions{}, std::make_shared<VirtualClock>());
+                BusRouter router(link.host());
+
+                std::shared_ptr<shared::IBuffer> first = router.endpoint(0x01);
+                std::shared_ptr<shared::IBuffer> second = router.endpoint(0x90);
+                ASSERT_EQ(dynamic_cast<IAddressable&>(*second).address(), 0x90);
+                ASSERT_THROW(router.endpoint(0x01), std::invalid_argument);
+                ASSERT_THROW(router.endpoint(shared::kBroadcastAddress), std::invalid_argument);
+
+                // Messages go out whole, one endpoint's doesn't split the other's
+                first->writeByte(kForFirst[0]);
+                writeAll(*second, kForSecond);
+                writeAll(*first, std::vector<uint8_t>(kForFirst.begin() + 1, kForFirst.end()));
+                link.device()->update();
+                std::vector<uint8_t> sent = kForSecond;
+                sent.insert(sent.end(), kForFirst.begin(), kForFirst.end());
+                ASSERT_EQ(readAll(*link.device()), sent);
+
+                // Updating any endpoint passes the responses on to theirs
+                writeAll(*link.device(), kForSecond);
+                writeAll(*link.device(), kForNobody);
+                writeAll(*link.device(), kForFirst);
+                first->update();
+                ASSERT_EQ(first->messages(), 1);
+                ASSERT_EQ(second->messages(), 1);
+                ASSERT_EQ(readAll(*first), kForFirst);
+                ASSERT_EQ(readAll(*second), kForSecond);
+                ASSERT_EQ(first->messages(), 0);
+                ASSERT_EQ(router.unrouted(), 1u);
+
+                // The address is free again once its endpoint is gone
+                second.reset();
+                writeAll(*link.device(), kForSecond);
+                first->update();
+                ASSERT_EQ(router.unrouted(), 2u);
+                ASSERT_NO_THROW(router.endpoint(0x90));
+            }
+
+            TEST(bus_emulator, devices_share_the_bus)
+            {
+                std::shared_ptr<VirtualClock> clock = std::make_shared<VirtualClock>();
+                LinkOptions options;
+                options.bytes_per_second = 1000;
+                BusEmulator bus(options, clock);
+
+                std::shared_ptr<shared::IBuffer> first = bus.addDevice();
+                std::shared_ptr<shared::IBuffer> second = bus.addDevice();
+
+                // Every device hears the host
+                writeAll(*bus.host(), kForFirst);
+                clock->set(std::chrono::milliseconds(4));
+                first->update();
+                ASSERT_EQ(first->messages(), 1);
+                ASSERT_EQ(second->messages(), 1);
+                ASSERT_EQ(readAll(*first), kForFirst);
+                ASSERT_EQ(readAll(*second), kForFirst);
+
+                // The devices' messages take turns on the bus
+                first->writeByte(kForFirst[0]);
+                writeAll(*second, kForSecond);
+                writeAll(*first, std::vector<uint8_t>(kForFirst.begin() + 1, kForFirst.end()));
+                clock->set(std::chrono::milliseconds(9));
+                bus.host()->update();
+                ASSERT_EQ(readAll(*bus.host()), kForSecond);
+
+                clock->set(std::chrono::milliseconds(13));
+                bus.host()->update();
+                ASSERT_EQ(readAll(*bus.host()), kForFirst);
+                ASSERT_EQ(bus.devicesToHost().bytes, 9u);
+                ASSERT_EQ(bus.hostToDevices().bytes, 4u);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
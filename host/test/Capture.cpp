@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+
+#include "EmbMessenger/CaptureBuffer.hpp"
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "EmbMessenger/ReplayBuffer.hpp"
+#include "FakeBuffer.hpp"
+
+#include "Ping.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            namespace
+            {
+                // Captures the messenger starting up and sending a ping
+                std::string capturePing()
+                {
+                    std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+                    std::shared_ptr<std::stringstream> stream = std::make_shared<std::stringstream>();
+                    std::shared_ptr<CaptureBuffer> capture = std::make_shared<CaptureBuffer>(buffer, stream);
+
+                    buffer->addDeviceMessage({ 0x00 });
+                    EmbMessenger messenger(capture, std::chrono::seconds(1));
+                    messenger.registerCommand<Ping>(0);
+
+                    auto ping = messenger.send(std::make_shared<Ping>());
+                    buffer->addDeviceMessage({ 0x01 });
+                    messenger.update();
+                    EXPECT_EQ(ping->getCommandState(), CommandState::Received);
+
+                    capture->flush();
+                    EXPECT_EQ(capture->dropped(), 0u);
+                    return stream->str();
+                }
+            }  // namespace
+
+            TEST(capture, file_format)
+            {
+                std::stringstream stream;
+                writeCaptureHeader(stream);
+                ASSERT_EQ(stream.str().substr(0, 6), "EMBCAP");
+
+                const uint8_t message[] = { 0x01, 0x00, shared::DataType::kEndOfMessage, 0x42 };
+                writeCaptureRecord(stream, std::chrono::nanoseconds(0x123456789), CaptureDirection::DeviceToHost,
+                                   message, sizeof(message));
+                writeCaptureRecord(stream, std::chrono::nanoseconds(5), CaptureDirection::HostToDevice, message, 2);
+                ASSERT_EQ(stream.str().size(), 8u + 11 + 4 + 11 + 2);
+
+                std::vector<CaptureRecord> records = readCapture(stream);
+                ASSERT_EQ(records.size(), 2u);
+                ASSERT_EQ(records[0].time, std::chrono::nanoseconds(0x123456789));
+                ASSERT_EQ(records[0].direction, CaptureDirection::DeviceToHost);
+                ASSERT_EQ(records[0].data, std::vector<uint8_t>(message, message + sizeof(message)));
+                ASSERT_EQ(records[1].direction, CaptureDirection::HostToDevice);
+                ASSERT_EQ(records[1].data.size(), 2u);
+
+                std::stringstream garbage("PCAP");
+                ASSERT_THROW(readCapture(garbage), std::runtime_error);
+            }
+
+            TEST(capture, addressed)
+            {
+                std::stringstream plain;
+                writeCaptureHeader(plain);
+                bool addressed = true;
+                readCapture(plain, addressed);
+                ASSERT_FALSE(addressed);
+
+                // Set by a CaptureBuffer on the bus of a BusRouter
+                std::shared_ptr<std::stringstream> stream = std::make_shared<std::stringstream>();
+                {
+                    CaptureBuffer capture(std::make_shared<FakeBuffer>(), stream, 16, true);
+                }
+                ASSERT_TRUE(readCaptureHeader(*stream));
+            }
+
+            TEST(capture, header_version)
+            {
+                std::stringstream current;
+                writeCaptureHeader(current, true);
+                ASSERT_EQ(current.str()[6], 2);
+
+                // Version 1 had no flags
+                std::stringstream version1(std::string("EMBCAP\x01\x00", 8));
+                ASSERT_FALSE(readCaptureHeader(version1));
+                std::stringstream version1_flags(std::string("EMBCAP\x01\x01", 8));
+                ASSERT_THROW(readCaptureHeader(version1_flags), std::runtime_error);
+
+                std::stringstream unknown_version(std::string("EMBCAP\x03\x00", 8));
+                ASSERT_THROW(readCaptureHeader(unknown_version), std::runtime_error);
+                std::stringstream unknown_flags(std::string("EMBCAP\x02\x03", 8));
+                ASSERT_THROW(readCaptureHeader(unknown_flags), std::runtime_error);
+            }
+
+            TEST(capture, frame_splitter)
+            {
+                // A data byte that looks like the end of a message isn't one
+                const uint8_t message[] = { 0x01, shared::DataType::kUint16, shared::DataType::kEndOfMessage, 0x00,
+                                            shared::DataType::kFloat, 0x00, 0x00, shared::DataType::kEndOfMessage,
+                                            0x00, shared::DataType::kEndOfMessage, 0x17 };
+
+                FrameSplitter splitter;
+                for (size_t i = 0; i < sizeof(message) - 1; ++i)
+                {
+                    ASSERT_FALSE(splitter.push(message[i]));
+                }
+                ASSERT_TRUE(splitter.push(message[sizeof(message) - 1]));
+            }
+
+            TEST(capture, capture_buffer)
+            {
+                std::stringstream stream(capturePing());
+                std::vector<CaptureRecord> records = readCapture(stream);
+
+                ASSERT_EQ(records.size(), 4u);
+                ASSERT_EQ(records[0].direction, CaptureDirection::HostToDevice);
+                ASSERT_EQ(records[0].data.size(), 6u);
+                ASSERT_EQ(records[1].direction, CaptureDirection::DeviceToHost);
+                ASSERT_EQ(records[1].data.size(), 3u);
+                ASSERT_EQ(records[2].direction, CaptureDirection::HostToDevice);
+                ASSERT_EQ(records[2].data[0], 0x01);
+                ASSERT_EQ(records[3].direction, CaptureDirection::DeviceToHost);
+                ASSERT_EQ(records[3].data[0], 0x01);
+                ASSERT_LE(records[2].time, records[3].time);
+            }
+
+            TEST(capture, capture_buffer_order)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+                std::shared_ptr<std::stringstream> stream = std::make_shared<std::stringstream>();
+                std::shared_ptr<CaptureBuffer> capture = std::make_shared<CaptureBuffer>(buffer, stream);
+
+                // More messages from the device than the writer takes off the queue at once, then one to the device
+                for (uint8_t i = 0; i < 100; ++i)
+                {
+                    buffer->addDeviceMessage({ i });
+                }
+                while (!capture->empty())
+                {
+                    capture->readByte();
+                }
+                capture->writeByte(0x01);
+                capture->writeByte(shared::DataType::kEndOfMessage);
+                capture->writeByte(0x00);
+                capture->flush();
+
+                std::vector<CaptureRecord> records = readCapture(*stream);
+                ASSERT_EQ(records.size(), 101u);
+                for (size_t i = 1; i < records.size(); ++i)
+                {
+                    ASSERT_LE(records[i - 1].time, records[i].time);
+                }
+                ASSERT_EQ(records[99].data[0], 99);
+                ASSERT_EQ(records[100].direction, CaptureDirection::HostToDevice);
+            }
+
+            TEST(capture, replay_maximum_speed)
+            {
+                std::stringstream stream(capturePing());
+                std::shared_ptr<ReplayBuffer> replay = std::make_shared<ReplayBuffer>(stream, ReplaySpeed::Maximum);
+
+                EmbMessenger messenger(replay, std::chrono::seconds(1));
+                messenger.registerCommand<Ping>(0);
+                ASSERT_FALSE(replay->finished());
+
+                auto ping = messenger.send(std::make_shared<Ping>());
+                messenger.update();
+                ASSERT_EQ(ping->getCommandState(), CommandState::Received);
+                ASSERT_TRUE(replay->finished());
+                ASSERT_EQ(replay->mismatches(), 0u);
+
+                // Beyond the end of the capture
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_EQ(replay->mismatches(), 1u);
+            }
+
+            TEST(capture, replay_original_speed)
+            {
+                // Delay the response to the ping
+                std::stringstream captured(capturePing());
+                std::vector<CaptureRecord> records = readCapture(captured);
+                records[3].time = records[2].time + std::chrono::milliseconds(30);
+
+                std::stringstream stream;
+                writeCaptureHeader(stream);
+                for (const CaptureRecord& record : records)
+                {
+                    writeCaptureRecord(stream, record.time, record.direction, record.data.data(), record.data.size());
+                }
+
+                std::shared_ptr<ReplayBuffer> replay = std::make_shared<ReplayBuffer>(stream, ReplaySpeed::Original);
+                EmbMessenger messenger(replay, std::chrono::seconds(1));
+                messenger.registerCommand<Ping>(0);
+
+                auto ping = messenger.send(std::make_shared<Ping>());
+                messenger.update();
+                ASSERT_EQ(ping->getCommandState(), CommandState::Sent);
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(40));
+                messenger.update();
+                ASSERT_EQ(ping->getCommandState(), CommandState::Received);
+                ASSERT_TRUE(replay->finished());
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "EmbMessenger/CommandFuture.hpp"
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "FakeBuffer.hpp"
+
+#include "Add.hpp"
+#include "UserError.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(command_future, get)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+
+                CommandFuture<Add> future = messenger.sendAsync(std::make_shared<Add>(7, 2));
+                ASSERT_TRUE(future.valid());
+                ASSERT_FALSE(future.ready());
+                ASSERT_THROW(future.get(), CommandNotReceived);
+
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x07, 0x02 }));
+                buffer->addDeviceMessage({ 0x01, 0x09 });
+
+                messenger.update();
+
+                ASSERT_TRUE(future.ready());
+                ASSERT_EQ(future.get()->Result, 9);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(command_future, get_throws_device_error)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<UserError>(0);
+
+                CommandFuture<UserError> future = messenger.sendAsync(std::make_shared<UserError>());
+
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kError, 0x42 });
+
+                ASSERT_THROW(messenger.update(), UserErrorException);
+
+                ASSERT_TRUE(future.ready());
+                ASSERT_THROW(future.get(), UserErrorException);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(command_future, resend_clears_error)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<UserError>(0);
+
+                auto userErrorCommand = std::make_shared<UserError>();
+                messenger.sendAsync(userErrorCommand);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kError, 0x42 });
+                ASSERT_THROW(messenger.update(), UserErrorException);
+                ASSERT_NE(userErrorCommand->getException(), nullptr);
+
+                CommandFuture<UserError> future = messenger.sendAsync(userErrorCommand);
+                ASSERT_EQ(userErrorCommand->getException(), nullptr);
+                ASSERT_FALSE(future.ready());
+
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                buffer->addDeviceMessage({ 0x02 });
+                messenger.update();
+
+                ASSERT_EQ(future.get(), userErrorCommand);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "EmbMessenger/CommandPool.hpp"
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "AllocationCounter.hpp"
+#include "FakeBuffer.hpp"
+
+#include "Add.hpp"
+#include "Ping.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(command_pool, recycles_blocks)
+            {
+                CommandPool pool;
+
+                void* first = pool.allocate(40);
+                pool.deallocate(first, 40);
+                void* second = pool.allocate(48);
+
+                ASSERT_EQ(first, second);
+                ASSERT_EQ(pool.systemAllocations(), 1u);
+
+                pool.deallocate(second, 48);
+            }
+
+            TEST(command_pool, make_command)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+
+                auto addCommand = messenger.makeCommand<Add>(7, 2);
+                ASSERT_EQ(addCommand->getTypeIndex(), std::type_index(typeid(Add)));
+                messenger.send(addCommand);
+
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x07, 0x02 }));
+                buffer->addDeviceMessage({ 0x01, 0x09 });
+
+                messenger.update();
+
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(addCommand->Result, 9);
+            }
+
+            TEST(command_pool, steady_state_does_not_allocate)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+
+                size_t allocations = 0;
+                for (uint8_t message_id = 1; message_id < 100; ++message_id)
+                {
+                    size_t before = allocationCount();
+                    auto pingCommand = messenger.makeCommand<Ping>();
+                    messenger.send(pingCommand);
+                    size_t sent = allocationCount();
+
+                    ASSERT_TRUE(buffer->checkHostBuffer({ message_id, 0x00 }));
+                    buffer->addDeviceMessage({ message_id });
+
+                    size_t received = allocationCount();
+                    messenger.update();
+                    pingCommand.reset();
+                    size_t after = allocationCount();
+
+                    // The first round trips warm up the pool and the buffers
+                    if (message_id > 10)
+                    {
+                        allocations += (sent - before) + (after - received);
+                    }
+                }
+
+                ASSERT_EQ(allocations, 0u);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "EmbMessenger/CommandTable.hpp"
+#include "EmbMessenger/Exceptions.hpp"
+
+#include "Ping.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(command_table, insert_find_erase)
+            {
+                CommandTable table(4);
+                auto ping = std::make_shared<Ping>();
+
+                uint16_t message_id = table.insert(ping);
+                ASSERT_EQ(message_id, 0);
+                ASSERT_EQ(table.size(), 1u);
+                ASSERT_EQ(table.find(message_id), ping);
+                ASSERT_EQ(table.find(message_id + 4), nullptr);
+
+                ASSERT_TRUE(table.erase(message_id));
+                ASSERT_FALSE(table.erase(message_id));
+                ASSERT_EQ(table.find(message_id), nullptr);
+                ASSERT_EQ(table.size(), 0u);
+            }
+
+            TEST(command_table, capacity_rounds_up)
+            {
+                CommandTable table(5);
+                ASSERT_EQ(table.capacity(), 8u);
+            }
+
+            TEST(command_table, skips_message_ids_in_use)
+            {
+                CommandTable table(4);
+                auto periodic = std::make_shared<Ping>();
+
+                uint16_t periodic_id = table.insert(periodic);
+                for (int i = 0; i < 3; ++i)
+                {
+                    table.erase(table.insert(std::make_shared<Ping>()));
+                }
+
+                // Wraps around the ring, the slot of the periodic command is skipped
+                ASSERT_EQ(table.insert(std::make_shared<Ping>()), 5);
+                ASSERT_EQ(table.find(periodic_id), periodic);
+            }
+
+            TEST(command_table, skips_message_ids_when_counter_wraps)
+            {
+                CommandTable table(4);
+                auto periodic = std::make_shared<Ping>();
+                table.insert(periodic);
+
+                uint16_t message_id = 0;
+                for (uint32_t i = 0; i < 0x10000; ++i)
+                {
+                    message_id = table.insert(std::make_shared<Ping>());
+                    ASSERT_NE(message_id % 4, 0);
+                    table.erase(message_id);
+                }
+
+                ASSERT_EQ(table.find(0), periodic);
+            }
+
+            TEST(command_table, assign_replaces_command)
+            {
+                CommandTable table(4);
+                auto ping = std::make_shared<Ping>();
+                auto periodic = std::make_shared<Ping>();
+
+                uint16_t message_id = table.insert(ping);
+                table.assign(message_id, periodic);
+
+                ASSERT_EQ(table.size(), 1u);
+                ASSERT_EQ(table.find(message_id), periodic);
+            }
+
+            TEST(command_table, out_of_command_slots)
+            {
+                CommandTable table(2);
+                table.insert(std::make_shared<Ping>());
+                table.insert(std::make_shared<Ping>());
+
+                ASSERT_THROW(table.insert(std::make_shared<Ping>()), OutOfCommandSlots);
+            }
+
+            TEST(command_table, clear_keeps_counter)
+            {
+                CommandTable table(4);
+                table.insert(std::make_shared<Ping>());
+                table.clear();
+
+                ASSERT_EQ(table.size(), 0u);
+                ASSERT_EQ(table.insert(std::make_shared<Ping>()), 1);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
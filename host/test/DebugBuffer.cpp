@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "EmbMessenger/Crc.hpp"
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/DebugBuffer.hpp"
+#include "FakeBuffer.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            namespace
+            {
+                struct DebugFixture
+                {
+                    std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+                    std::vector<std::string> lines;
+                    DebugBuffer debug;
+
+                    explicit DebugFixture(DebugOptions options = DebugOptions()) :
+                        debug(buffer, [this](std::string line) { lines.push_back(line); }, options)
+                    {
+                    }
+
+                    void readAll()
+                    {
+                        while (!debug.empty())
+                        {
+                            debug.readByte();
+                        }
+                    }
+                };
+            }  // namespace
+
+            TEST(debug_buffer, decode)
+            {
+                DebugFixture fixture;
+
+                // Write message 1 with command 2, the host's messages are decoded on the way out
+                uint8_t crc = 0;
+                std::vector<uint8_t> message = { 0x01, 0x02, shared::DataType::kNull, shared::DataType::kEndOfMessage };
+                for (uint8_t byte : message)
+                {
+                    fixture.debug.writeByte(byte);
+                    crc = shared::crc::Calculate8(crc, byte);
+                }
+                fixture.debug.writeByte(crc);
+
+                fixture.buffer->addDeviceMessage({ 0x01, shared::DataType::kUint8, 200, shared::DataType::kBoolTrue,
+                                                   shared::DataType::kInt8, 'A' });
+                fixture.readAll();
+
+                // Nothing is decoded on the I/O path
+                ASSERT_TRUE(fixture.lines.empty());
+                fixture.debug.update();
+
+                std::vector<std::string> expected = { "Write Message Id: 1",
+                                                      "Write Command Id: 2",
+                                                      "Write   0: Null",
+                                                      "Write Message 1 CRC Valid",
+                                                      "Read  Message Id: 1",
+                                                      "Read    0: 200 0xC8",
+                                                      "Read    1: True",
+                                                      "Read    2: 65 'A'",
+                                                      "Read  Message 1 CRC Valid" };
+                ASSERT_EQ(fixture.lines, expected);
+                ASSERT_EQ(fixture.debug.dropped(), 0u);
+            }
+
+            TEST(debug_buffer, addressed)
+            {
+                DebugOptions options;
+                options.addressed = true;
+                DebugFixture fixture(options);
+
+                // Message 1 with command 2 to the device at address 5
+                uint8_t crc = 0;
+                std::vector<uint8_t> message = { 0x05, 0x01, 0x02, shared::DataType::kEndOfMessage };
+                for (uint8_t byte : message)
+                {
+                    fixture.debug.writeByte(byte);
+                    crc = shared::crc::Calculate8(crc, byte);
+                }
+                fixture.debug.writeByte(crc);
+                fixture.debug.update();
+
+                std::vector<std::string> expected = { "Write Address: 5", "Write Message Id: 1", "Write Command Id: 2",
+                                                      "Write Message 1 CRC Valid" };
+                ASSERT_EQ(fixture.lines, expected);
+            }
+
+            TEST(debug_buffer, severity)
+            {
+                DebugOptions options;
+                options.severity = DebugSeverity::Error;
+                DebugFixture fixture(options);
+
+                fixture.buffer->addDeviceMessage({ 0x01, 0x05 });
+                fixture.buffer->writeValidCrc(false);
+                fixture.buffer->addDeviceMessage({ 0x02, 0x05 });
+                fixture.readAll();
+                fixture.debug.flush();
+
+                std::vector<std::string> expected = { "Read  Message 2 CRC Invalid" };
+                ASSERT_EQ(fixture.lines, expected);
+            }
+
+            TEST(debug_buffer, order)
+            {
+                DebugOptions options;
+                options.severity = DebugSeverity::Info;
+                DebugFixture fixture(options);
+
+                // More messages from the device than the decoder takes off the queue at once, then one to the device
+                for (uint8_t id = 1; id <= 100; ++id)
+                {
+                    fixture.buffer->addDeviceMessage({ id });
+                }
+                fixture.readAll();
+
+                uint8_t crc = 0;
+                std::vector<uint8_t> message = { 0x65, 0x02, shared::DataType::kEndOfMessage };
+                for (uint8_t byte : message)
+                {
+                    fixture.debug.writeByte(byte);
+                    crc = shared::crc::Calculate8(crc, byte);
+                }
+                fixture.debug.writeByte(crc);
+                fixture.debug.flush();
+
+                ASSERT_EQ(fixture.lines.size(), 203u);
+                ASSERT_EQ(fixture.lines[199], "Read  Message 100 CRC Valid");
+                ASSERT_EQ(fixture.lines[200], "Write Message Id: 101");
+            }
+
+            TEST(debug_buffer, sampling)
+            {
+                DebugOptions options;
+                options.sample_every = 2;
+                options.severity = DebugSeverity::Info;
+                DebugFixture fixture(options);
+
+                for (uint8_t id = 1; id <= 4; ++id)
+                {
+                    fixture.buffer->addDeviceMessage({ id, 0x05 });
+                }
+                fixture.readAll();
+                fixture.debug.flush();
+
+                std::vector<std::string> expected = { "Read  Message Id: 1", "Read  Message 1 CRC Valid",
+                                                      "Read  Message Id: 3", "Read  Message 3 CRC Valid" };
+                ASSERT_EQ(fixture.lines, expected);
+
+                options.sample_every = 0;
+                ASSERT_THROW(DebugFixture invalid(options), std::invalid_argument);
+            }
+
+            TEST(debug_buffer, full_queue_drops)
+            {
+                DebugOptions options;
+                options.capacity = 1;
+                options.severity = DebugSeverity::Info;
+                DebugFixture fixture(options);
+
+                for (uint8_t id = 1; id <= 3; ++id)
+                {
+                    fixture.buffer->addDeviceMessage({ id });
+                }
+                fixture.readAll();
+                ASSERT_EQ(fixture.debug.dropped(), 2u);
+
+                fixture.debug.update();
+                std::vector<std::string> expected = { "Read  Message Id: 1", "Read  Message 1 CRC Valid" };
+                ASSERT_EQ(fixture.lines, expected);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -1,6 +1,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <memory>
+#include <thread>
 
 #include "EmbMessenger/DataType.hpp"
 #include "EmbMessenger/EmbMessenger.hpp"
@@ -14,6 +15,77 @@
 
 using namespace testing;
 
+namespace
+{
+    // Holds on to the tasks until the test runs them
+    class DeferredExecutor : public emb::host::IExecutor
+    {
+    public:
+        std::vector<std::pair<uint16_t, std::function<void()>>> tasks;
+
+        void execute(uint16_t key, std::function<void()> task) override
+        {
+            tasks.emplace_back(key, std::move(task));
+        }
+    };
+
+    // Records the hooks that were called, in order
+    class RecordingTracer : public emb::host::ITracer
+    {
+    public:
+        std::vector<std::string> events;
+        std::chrono::nanoseconds last{ 0 };
+        bool ordered = true;
+
+        void record(std::chrono::nanoseconds time, std::string event)
+        {
+            ordered = ordered && time >= last;
+            last = time;
+            events.emplace_back(std::move(event));
+        }
+
+        void frameEncoded(std::chrono::nanoseconds time, uint16_t message_id, uint16_t command_id,
+                          const uint8_t* data, size_t size) override
+        {
+            record(time, "encoded " + std::to_string(message_id) + " " + std::to_string(command_id) + " " +
+                             std::to_string(size));
+        }
+
+        void frameFlushed(std::chrono::nanoseconds time, const uint8_t* data, size_t size) override
+        {
+            record(time, "flushed " + std::to_string(size));
+        }
+
+        void frameReceived(std::chrono::nanoseconds time, uint16_t message_id) override
+        {
+            record(time, "received " + std::to_string(message_id));
+        }
+
+        void decodeComplete(std::chrono::nanoseconds time, uint16_t message_id,
+                            const emb::host::Command& command) override
+        {
+            record(time, "decoded " + std::to_string(message_id));
+        }
+
+        void callbackStart(std::chrono::nanoseconds time, uint16_t message_id,
+                           const emb::host::Command& command) override
+        {
+            record(time, "callback start " + std::to_string(message_id));
+        }
+
+        void callbackEnd(std::chrono::nanoseconds time, uint16_t message_id,
+                         const emb::host::Command& command) override
+        {
+            record(time, "callback end " + std::to_string(message_id));
+        }
+
+        void error(std::chrono::nanoseconds time, std::exception_ptr error) override
+        {
+            record(time, "error");
+        }
+    };
+}  // namespace
+
 namespace emb
 {
     namespace host
@@ -146,6 +218,92 @@ namespace emb
                 ASSERT_EQ(addCommand->Result, 14);
             }
 
+            TEST(host_command, update_all)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<ToggleLed>(2);
+                messenger.registerCommand<Add>(3);
+
+                bool ledState = false;
+                messenger.registerPeriodicCommand<ToggleLed>(
+                    1000, [&](std::shared_ptr<ToggleLed>&& toggleLed) { ledState = toggleLed->ledState; });
+                ASSERT_TRUE(buffer->checkHostBuffer(
+                    { 0x01, shared::DataType::kUint16, 0xFF, 0xFE, 0x02, shared::DataType::kUint16, 0x03, 0xE8 }));
+
+                auto addCommand = messenger.send(std::make_shared<Add>(7, 2));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x03, 0x07, 0x02 }));
+
+                ASSERT_EQ(messenger.updateAll(), 0u);
+
+                // The register reply and the first sample arrive in the same batch
+                buffer->addDeviceMessage({ 0x01 });
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kBoolTrue });
+                buffer->addDeviceMessage({ 0x02, 0x09 });
+                ASSERT_EQ(messenger.updateAll(), 3u);
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(ledState, true);
+                ASSERT_EQ(addCommand->Result, 9);
+                ASSERT_TRUE(messenger.commandsReceived());
+
+                // An error ends the batch, the rest of the messages are left for the next one
+                buffer->addDeviceMessage({ 0x05 });
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kBoolFalse });
+                ASSERT_THROW(messenger.updateAll(), MessageIdInvalid);
+                ASSERT_EQ(messenger.updateAll(), 1u);
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(ledState, false);
+            }
+
+            TEST(host_command, command_capacity)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1), 1000);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+
+                // Rounded up to 1024, well past the default of 256
+                for (int i = 0; i < 1024; ++i)
+                {
+                    messenger.send(std::make_shared<Ping>());
+                }
+                ASSERT_THROW(messenger.send(std::make_shared<Ping>()), OutOfCommandSlots);
+            }
+
+            TEST(host_command, callback_throws)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1), 1);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+
+                std::shared_ptr<Ping> ping = messenger.makeCommand<Ping>();
+                ping->setCallback<Ping>([](std::shared_ptr<Ping>) { throw std::runtime_error("Callback failed"); });
+                messenger.send(ping);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+
+                buffer->addDeviceMessage({ 0x01 });
+                ASSERT_THROW(messenger.update(), std::runtime_error);
+                ASSERT_TRUE(messenger.commandsReceived());
+
+                // The only slot was freed even though the callback threw
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                buffer->addDeviceMessage({ 0x02 });
+                messenger.update();
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
             TEST(messenger_builtin_command, reset)
             {
                 std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
@@ -183,12 +341,15 @@ namespace emb
                 messenger.registerCommand<Add>(3);
 
                 bool ledState = false;
-                messenger.registerPeriodicCommand<ToggleLed>(
+                auto toggleLed = messenger.registerPeriodicCommand<ToggleLed>(
                     1000, [&](std::shared_ptr<ToggleLed>&& toggleLed) { ledState = toggleLed->ledState; });
 
                 ASSERT_TRUE(buffer->checkHostBuffer(
                     { 0x01, shared::DataType::kUint16, 0xFF, 0xFE, 0x02, shared::DataType::kUint16, 0x03, 0xE8 }));
 
+                // Known before the device responds
+                ASSERT_EQ(toggleLed->getMessageId(), 1);
+
                 buffer->addDeviceMessage({ 0x01 });
                 buffer->addDeviceMessage({ 0x01, shared::DataType::kBoolTrue });
                 messenger.update();
@@ -237,6 +398,125 @@ namespace emb
                 ASSERT_TRUE(buffer->buffersEmpty());
             }
 
+            TEST(messenger_builtin_command, negotiate_flow_control)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+
+                messenger.negotiateFlowControl();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, shared::DataType::kUint16, 0xFF, 0xFC }));
+                buffer->addDeviceMessage({ 0x01, 0x0C });
+                messenger.update();
+                ASSERT_TRUE(buffer->buffersEmpty());
+
+                // Each message is 6 bytes, so the third one has to wait for the device to respond to the first one
+                messenger.send(std::make_shared<Add>(1, 1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x03, 0x01, 0x01 }));
+                messenger.send(std::make_shared<Add>(2, 2));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x03, 0x03, 0x02, 0x02 }));
+                auto third = messenger.send(std::make_shared<Add>(3, 3));
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(messenger.bytesInFlight(), 12u);
+                ASSERT_EQ(messenger.messagesInFlight(), 2u);
+
+                buffer->addDeviceMessage({ 0x02, 0x02 });
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x04, 0x03, 0x03, 0x03 }));
+                ASSERT_EQ(messenger.bytesInFlight(), 12u);
+
+                buffer->addDeviceMessage({ 0x03, 0x04 });
+                buffer->addDeviceMessage({ 0x04, 0x06 });
+                ASSERT_EQ(messenger.updateAll(), 2u);
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(messenger.bytesInFlight(), 0u);
+                ASSERT_EQ(messenger.messagesInFlight(), 0u);
+                ASSERT_EQ(third->Result, 6);
+            }
+
+            TEST(messenger_builtin_command, flow_control_message_window)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                messenger.setFlowControlWindow(0, 1);
+
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->buffersEmpty());
+
+                // Turning flow control off writes the waiting messages
+                messenger.setFlowControlWindow(0, 0);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+
+                buffer->addDeviceMessage({ 0x01 });
+                buffer->addDeviceMessage({ 0x02 });
+                ASSERT_EQ(messenger.updateAll(), 2u);
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(messenger.messagesInFlight(), 0u);
+            }
+
+            TEST(messenger_builtin_command, flow_control_small_window)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+                messenger.enableRetransmission(std::chrono::milliseconds(10), 1);
+                messenger.enableKeepalive(std::chrono::milliseconds(10));
+
+                // The device only has room for one 6 byte message
+                messenger.setFlowControlWindow(8, 0);
+                messenger.send(std::make_shared<Add>(1, 1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x01, 0x01 }));
+                auto second = messenger.send(std::make_shared<Add>(2, 2));
+                ASSERT_TRUE(buffer->buffersEmpty());
+
+                // Only the message that was written is retransmitted, and no keepalive is sent while it is in flight
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x01, 0x01 }));
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(messenger.retransmissions(), 1u);
+                ASSERT_EQ(messenger.getLinkStats().keepalives_sent, 0u);
+                ASSERT_EQ(messenger.bytesInFlight(), 6u);
+
+                buffer->addDeviceMessage({ 0x01, 0x02 });
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x03, 0x02, 0x02 }));
+                ASSERT_EQ(messenger.bytesInFlight(), 6u);
+
+                buffer->addDeviceMessage({ 0x02, 0x04 });
+                messenger.update();
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(second->Result, 4);
+                ASSERT_EQ(messenger.messagesInFlight(), 0u);
+                ASSERT_EQ(messenger.retransmissions(), 1u);
+
+                // Once the link is idle the keepalive is sent again
+                std::this_thread::sleep_for(std::chrono::milliseconds(15));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x03, shared::DataType::kUint16, 0xFF, 0xFC }));
+                buffer->addDeviceMessage({ 0x03, 0x40 });
+                messenger.update();
+                ASSERT_EQ(messenger.getLinkStats().keepalives_sent, 1u);
+                ASSERT_EQ(messenger.messagesInFlight(), 0u);
+
+                messenger.enableKeepalive(std::chrono::milliseconds(0));
+            }
+
             TEST(messenger_exceptions_host, initialization_timeout)
             {
                 std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
@@ -330,6 +610,62 @@ namespace emb
                 ASSERT_TRUE(buffer->buffersEmpty());
             }
 
+            TEST(messenger_exceptions_host, crc_invalid_keeps_values)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+
+                auto add = std::make_shared<Add>(1, 2);
+                add->Result = 0;
+                messenger.send(add);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x01, 0x02 }));
+
+                // The corrupted result never reaches the command
+                buffer->writeValidCrc(false);
+                buffer->addDeviceMessage({ 0x01, 0x07 });
+                ASSERT_THROW(messenger.update(), CrcInvalid);
+                ASSERT_EQ(add->Result, 0);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_exceptions_host, frame_too_large)
+            {
+                class Flood : public Command
+                {
+                public:
+                    void send(EmbMessenger* messenger) override
+                    {
+                        for (uint32_t i = 0; i < Frame::kMaxFrameSize / 4; ++i)
+                        {
+                            messenger->write(0xFFFFFFFF);
+                        }
+                    }
+                };
+
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Flood>(0);
+                messenger.registerCommand<Ping>(1);
+
+                auto flood = std::make_shared<Flood>();
+                ASSERT_THROW(messenger.send(flood), FrameTooLarge);
+                ASSERT_EQ(flood->getCommandState(), CommandState::NotSent);
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_TRUE(messenger.commandsReceived());
+
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x01 }));
+            }
+
             TEST(messenger_exceptions_host, message_id_invalid)
             {
                 std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
@@ -655,6 +991,513 @@ namespace emb
                 messenger.update();
                 ASSERT_TRUE(buffer->buffersEmpty());
             }
+
+            TEST(messenger_completion_queue, poll_completions)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+                messenger.registerCommand<UserError>(0);
+
+                Completion completions[4];
+                ASSERT_EQ(messenger.pollCompletions(completions), 0u);
+                messenger.enableCompletionQueue(2);
+                ASSERT_THROW(messenger.enableCompletionQueue(2), std::logic_error);
+
+                auto addCommand = messenger.send(std::make_shared<Add>(7, 2));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x07, 0x02 }));
+                auto userErrorCommand = messenger.send(std::make_shared<UserError>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                messenger.send(std::make_shared<Add>(1, 1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x03, 0x03, 0x01, 0x01 }));
+
+                buffer->addDeviceMessage({ 0x01, 0x09 });
+                buffer->addDeviceMessage({ 0x02, shared::DataType::kError, 0x42 });
+                buffer->addDeviceMessage({ 0x03, 0x02 });
+                messenger.update();
+                ASSERT_THROW(messenger.update(), UserErrorException);
+                messenger.update();
+                ASSERT_TRUE(buffer->buffersEmpty());
+
+                ASSERT_EQ(messenger.pollCompletions(completions), 2u);
+                ASSERT_EQ(messenger.droppedCompletions(), 1u);
+
+                ASSERT_EQ(completions[0].command, addCommand);
+                ASSERT_EQ(completions[0].exception, nullptr);
+                ASSERT_EQ(completions[1].command, userErrorCommand);
+                ASSERT_THROW(std::rethrow_exception(completions[1].exception), UserErrorException);
+
+                ASSERT_EQ(messenger.pollCompletions(completions), 0u);
+            }
+
+            TEST(messenger_completion_queue, periodic_samples)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<ToggleLed>(2);
+                messenger.enableCompletionQueue();
+
+                auto toggleLed = messenger.registerPeriodicCommand<ToggleLed>(1000, [](std::shared_ptr<ToggleLed>&&) {});
+                ASSERT_TRUE(buffer->checkHostBuffer(
+                    { 0x01, shared::DataType::kUint16, 0xFF, 0xFE, 0x02, shared::DataType::kUint16, 0x03, 0xE8 }));
+
+                buffer->addDeviceMessage({ 0x01 });
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kBoolTrue });
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kBoolFalse });
+                messenger.update();
+                messenger.update();
+                messenger.update();
+                ASSERT_TRUE(buffer->buffersEmpty());
+
+                // The register command is internal to the messenger, only the samples are queued
+                Completion completions[4];
+                ASSERT_EQ(messenger.pollCompletions(completions), 2u);
+                ASSERT_EQ(completions[0].command, toggleLed);
+                ASSERT_EQ(completions[1].command, toggleLed);
+                ASSERT_TRUE(completions[0].command->isPeriodic());
+            }
+
+            TEST(messenger_executor, inline_executor)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+                messenger.setExecutor(std::make_shared<InlineExecutor>());
+
+                int result = 0;
+                auto addCommand = std::make_shared<Add>(7, 2);
+                addCommand->setCallback<Add>([&](std::shared_ptr<Add> add) { result = add->Result; });
+                messenger.send(addCommand);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x07, 0x02 }));
+
+                buffer->addDeviceMessage({ 0x01, 0x09 });
+                messenger.update();
+                ASSERT_EQ(result, 9);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_executor, deferred_callbacks)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<ToggleLed>(2);
+                messenger.registerCommand<Add>(3);
+
+                auto executor = std::make_shared<DeferredExecutor>();
+                messenger.setExecutor(executor);
+
+                // The register command's callback runs on the update thread, the samples' callbacks are deferred
+                int samples = 0;
+                messenger.registerPeriodicCommand<ToggleLed>(1000, [&](std::shared_ptr<ToggleLed>&&) { ++samples; });
+                ASSERT_TRUE(buffer->checkHostBuffer(
+                    { 0x01, shared::DataType::kUint16, 0xFF, 0xFE, 0x02, shared::DataType::kUint16, 0x03, 0xE8 }));
+
+                int result = 0;
+                auto addCommand = std::make_shared<Add>(7, 2);
+                addCommand->setCallback<Add>([&](std::shared_ptr<Add> add) { result = add->Result; });
+                messenger.send(addCommand);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x03, 0x07, 0x02 }));
+
+                buffer->addDeviceMessage({ 0x01 });
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kBoolTrue });
+                buffer->addDeviceMessage({ 0x02, 0x09 });
+                messenger.update();
+                messenger.update();
+                messenger.update();
+                ASSERT_TRUE(buffer->buffersEmpty());
+
+                ASSERT_EQ(addCommand->getCommandState(), CommandState::Received);
+                ASSERT_EQ(result, 0);
+                ASSERT_EQ(samples, 0);
+
+                ASSERT_EQ(executor->tasks.size(), 2u);
+                ASSERT_EQ(executor->tasks[0].first, 0x01);
+                ASSERT_EQ(executor->tasks[1].first, 0x02);
+                for (auto& task : executor->tasks)
+                {
+                    task.second();
+                }
+
+                ASSERT_EQ(result, 9);
+                ASSERT_EQ(samples, 1);
+            }
+
+            TEST(messenger_retransmission, response_timeout)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                messenger.enableRetransmission(std::chrono::milliseconds(10), 1);
+
+                auto ping = messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                ASSERT_EQ(messenger.retransmissions(), 1u);
+
+                buffer->addDeviceMessage({ 0x01 });
+                messenger.update();
+                ASSERT_EQ(ping->getCommandState(), CommandState::Received);
+
+                // The response to the first copy arrives late and is dropped
+                buffer->addDeviceMessage({ 0x01 });
+                ASSERT_NO_THROW(messenger.update());
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_retransmission, retries_exhausted)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                messenger.enableRetransmission(std::chrono::milliseconds(10), 1);
+
+                auto ping = messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+
+                // Each retransmission doubles the timeout
+                std::this_thread::sleep_for(std::chrono::milliseconds(40));
+                ASSERT_THROW(messenger.update(), RetriesExhausted);
+                ASSERT_EQ(ping->getCommandState(), CommandState::Received);
+                ASSERT_NE(ping->getException(), nullptr);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_retransmission, device_crc_invalid)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+                messenger.enableRetransmission(std::chrono::seconds(10), 1);
+
+                auto add = messenger.send(std::make_shared<Add>(1, 2));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x01, 0x02 }));
+
+                // The device got a corrupted copy, it's sent again on the next tick without waiting for the timeout
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kError, shared::DataError::kCrcInvalid });
+                ASSERT_NO_THROW(messenger.update());
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x01, 0x02 }));
+
+                buffer->addDeviceMessage({ 0x01, 0x03 });
+                messenger.update();
+                ASSERT_EQ(add->Result, 3);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_retransmission, corrupted_device_crc_invalid)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Add>(3);
+                messenger.enableRetransmission(std::chrono::seconds(10), 1);
+
+                auto add = std::make_shared<Add>(1, 2);
+                add->Result = 0;
+                messenger.send(add);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x03, 0x01, 0x02 }));
+
+                // The error came in a corrupted response, nothing is sent again until the timeout
+                buffer->writeValidCrc(false);
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kError, shared::DataError::kCrcInvalid });
+                buffer->addDeviceMessage({ 0x01, 0x07 });
+                ASSERT_NO_THROW(messenger.update());
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                messenger.update();
+                ASSERT_TRUE(buffer->buffersEmpty());
+                ASSERT_EQ(add->Result, 0);
+                ASSERT_EQ(messenger.snapshot().crc_failures, 2u);
+
+                buffer->writeValidCrc(true);
+                buffer->addDeviceMessage({ 0x01, 0x03 });
+                messenger.update();
+                ASSERT_EQ(add->Result, 3);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_retransmission, duplicate_message)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                messenger.registerCommand<Add>(3);
+                messenger.setIdempotent<Ping>();
+                messenger.enableRetransmission(std::chrono::seconds(10), 1);
+
+                // Idempotent commands are sent again with a new message ID
+                auto ping = messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                buffer->addDeviceMessage({ 0x01, shared::DataType::kError, shared::DataError::kDuplicateMessage });
+                ASSERT_NO_THROW(messenger.update());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+
+                buffer->addDeviceMessage({ 0x02 });
+                messenger.update();
+                ASSERT_EQ(ping->getCommandState(), CommandState::Received);
+                ASSERT_EQ(ping->getException(), nullptr);
+
+                // Other commands fail
+                auto add = messenger.send(std::make_shared<Add>(1, 2));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x03, 0x03, 0x01, 0x02 }));
+                buffer->addDeviceMessage({ 0x03, shared::DataType::kError, shared::DataError::kDuplicateMessage });
+                ASSERT_THROW(messenger.update(), DuplicateMessage);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_timeout, default_timeout)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                messenger.setDefaultTimeout(std::chrono::milliseconds(10));
+
+                auto ping = messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                ASSERT_NO_THROW(messenger.update());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                ASSERT_THROW(messenger.update(), CommandTimeout);
+                ASSERT_EQ(ping->getCommandState(), CommandState::Received);
+                ASSERT_NE(ping->getException(), nullptr);
+                ASSERT_TRUE(messenger.commandsReceived());
+
+                // The slot was reclaimed, the late response has no command to receive it
+                buffer->addDeviceMessage({ 0x01 });
+                ASSERT_THROW(messenger.update(), MessageIdInvalid);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_timeout, command_timeout)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                messenger.setDefaultTimeout(std::chrono::milliseconds(10));
+
+                auto patient = std::make_shared<Ping>();
+                patient->setTimeout(std::chrono::seconds(10));
+                messenger.send(patient);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+
+                // Responding in time cancels the deadline
+                auto ping = messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                buffer->addDeviceMessage({ 0x02 });
+                messenger.update();
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                ASSERT_NO_THROW(messenger.update());
+                ASSERT_EQ(ping->getException(), nullptr);
+                ASSERT_EQ(patient->getCommandState(), CommandState::Sent);
+
+                buffer->addDeviceMessage({ 0x01 });
+                messenger.update();
+                ASSERT_EQ(patient->getCommandState(), CommandState::Received);
+                ASSERT_EQ(patient->getException(), nullptr);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_link_health, round_trip_time)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                messenger.enableRetransmission(std::chrono::milliseconds(10), 1);
+
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                buffer->addDeviceMessage({ 0x01 });
+                messenger.update();
+
+                LinkStats stats = messenger.getLinkStats();
+                ASSERT_EQ(stats.rtt_samples, 1u);
+                ASSERT_GE(stats.smoothed_rtt, std::chrono::milliseconds(5));
+                ASSERT_EQ(stats.smoothed_rtt, stats.last_rtt);
+                ASSERT_GT(stats.retransmission_timeout, stats.smoothed_rtt);
+
+                // Retransmitted messages aren't measured
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                buffer->addDeviceMessage({ 0x02 });
+                messenger.update();
+
+                stats = messenger.getLinkStats();
+                ASSERT_EQ(stats.rtt_samples, 1u);
+                ASSERT_EQ(stats.retransmissions, 1u);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
+
+            TEST(messenger_link_health, keepalive)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.enableKeepalive(std::chrono::milliseconds(10));
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(15));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, shared::DataType::kUint16, 0xFF, 0xFC }));
+                buffer->addDeviceMessage({ 0x01, 0x40 });
+                messenger.update();
+
+                LinkStats stats = messenger.getLinkStats();
+                ASSERT_EQ(stats.keepalives_sent, 1u);
+                ASSERT_EQ(stats.rtt_samples, 1u);
+
+                // An unanswered keepalive is counted, not thrown
+                std::this_thread::sleep_for(std::chrono::milliseconds(15));
+                messenger.update();
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, shared::DataType::kUint16, 0xFF, 0xFC }));
+                std::this_thread::sleep_for(std::chrono::milliseconds(15));
+                ASSERT_NO_THROW(messenger.update());
+
+                stats = messenger.getLinkStats();
+                ASSERT_EQ(stats.keepalives_missed, 1u);
+                ASSERT_EQ(stats.timeouts, 0u);
+                ASSERT_GE(stats.since_last_response, std::chrono::milliseconds(30));
+
+                messenger.enableKeepalive(std::chrono::milliseconds(0));
+            }
+
+            TEST(messenger_tracing, hooks)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                std::shared_ptr<RecordingTracer> tracer = std::make_shared<RecordingTracer>();
+                messenger.setTracer(tracer);
+
+                auto ping = std::make_shared<Ping>();
+                ping->setCallback<Ping>([](auto&&) {});
+                messenger.send(ping);
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                buffer->addDeviceMessage({ 0x01 });
+                messenger.update();
+
+                buffer->addDeviceMessage({ 0x09 });
+                ASSERT_THROW(messenger.update(), MessageIdInvalid);
+
+                ASSERT_THAT(tracer->events,
+                            ElementsAre("encoded 1 0 4", "flushed 4", "received 1", "decoded 1", "callback start 1",
+                                        "callback end 1", "received 9", "error"));
+                ASSERT_TRUE(tracer->ordered);
+
+                // Nothing is traced once the tracer is removed
+                messenger.setTracer(nullptr);
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                ASSERT_EQ(tracer->events.size(), 8u);
+            }
+
+            TEST(messenger_metrics, snapshot)
+            {
+                std::shared_ptr<FakeBuffer> buffer = std::make_shared<FakeBuffer>();
+
+                buffer->addDeviceMessage({ 0x00 });
+                EmbMessenger messenger(buffer, std::chrono::seconds(1));
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x00, shared::DataType::kUint16, 0xFF, 0xFF }));
+
+                messenger.registerCommand<Ping>(0);
+                MetricsSnapshot before = messenger.snapshot();
+
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x01, 0x00 }));
+                buffer->addDeviceMessage({ 0x01 });
+                messenger.update();
+
+                MetricsSnapshot after = messenger.snapshot();
+                ASSERT_EQ(after.tx_frames - before.tx_frames, 1u);
+                ASSERT_EQ(after.tx_bytes - before.tx_bytes, 4u);
+                ASSERT_EQ(after.rx_frames - before.rx_frames, 1u);
+                ASSERT_EQ(after.rx_bytes - before.rx_bytes, 3u);
+                ASSERT_EQ(after.command_rtt[0].count, 1u);
+                ASSERT_EQ(after.pending_commands, 0u);
+
+                messenger.send(std::make_shared<Ping>());
+                ASSERT_TRUE(buffer->checkHostBuffer({ 0x02, 0x00 }));
+                ASSERT_EQ(messenger.snapshot().pending_commands, 1u);
+
+                buffer->writeValidCrc(false);
+                buffer->addDeviceMessage({ 0x02 });
+                ASSERT_THROW(messenger.update(), CrcInvalid);
+                buffer->writeValidCrc(true);
+                buffer->addDeviceMessage({ 0x09 });
+                ASSERT_THROW(messenger.update(), MessageIdInvalid);
+
+                after = messenger.snapshot();
+                ASSERT_EQ(after.crc_failures, 1u);
+                ASSERT_EQ(after.errors["CrcInvalid"], 1u);
+                ASSERT_EQ(after.errors["MessageIdInvalid"], 1u);
+                ASSERT_EQ(after.pending_commands, 0u);
+                ASSERT_EQ(after.rx_frames - before.rx_frames, 3u);
+                ASSERT_TRUE(buffer->buffersEmpty());
+            }
         }  // namespace test
     }  // namespace host
 }  // namespace emb
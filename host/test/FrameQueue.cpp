@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "EmbMessenger/Frame.hpp"
+#include "EmbMessenger/FrameQueue.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(frame, overflow)
+            {
+                Frame frame;
+                for (size_t i = 0; i < Frame::kMaxFrameSize; ++i)
+                {
+                    frame.writeByte(static_cast<uint8_t>(i));
+                }
+                ASSERT_FALSE(frame.overflowed());
+                ASSERT_EQ(frame.size(), Frame::kMaxFrameSize);
+
+                frame.writeByte(0x00);
+                ASSERT_TRUE(frame.overflowed());
+                ASSERT_EQ(frame.size(), Frame::kMaxFrameSize);
+
+                frame.clear();
+                ASSERT_FALSE(frame.overflowed());
+                ASSERT_TRUE(frame.empty());
+            }
+
+            TEST(frame_queue, push_pop)
+            {
+                FrameQueue queue(2);
+                ASSERT_TRUE(queue.empty());
+
+                Frame frame;
+                for (uint8_t i = 0; i < 3; ++i)
+                {
+                    frame.clear();
+                    frame.writeByte(i);
+                    frame.writeByte(0xC1);
+                    ASSERT_EQ(queue.push(frame), i < 2);
+                }
+                ASSERT_FALSE(queue.empty());
+
+                for (uint8_t i = 0; i < 2; ++i)
+                {
+                    ASSERT_TRUE(queue.pop(frame));
+                    ASSERT_EQ(frame.size(), 2u);
+                    ASSERT_EQ(frame.readByte(), i);
+                    ASSERT_EQ(frame.readByte(), 0xC1);
+                }
+                ASSERT_FALSE(queue.pop(frame));
+                ASSERT_TRUE(queue.empty());
+            }
+
+            TEST(frame_queue, wraps_around)
+            {
+                FrameQueue queue(4);
+                Frame frame;
+
+                for (uint8_t i = 0; i < 20; ++i)
+                {
+                    frame.clear();
+                    frame.writeByte(i);
+                    ASSERT_TRUE(queue.push(frame));
+                    ASSERT_TRUE(queue.pop(frame));
+                    ASSERT_EQ(frame.readByte(), i);
+                }
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/LinkEmulator.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            namespace
+            {
+                std::vector<uint8_t> readAll(shared::IBuffer& buffer)
+                {
+                    std::vector<uint8_t> bytes;
+                    while (!buffer.empty())
+                    {
+                        bytes.push_back(buffer.readByte());
+                    }
+                    return bytes;
+                }
+            }  // namespace
+
+            TEST(link_emulator, rate_and_latency)
+            {
+                std::shared_ptr<VirtualClock> clock = std::make_shared<VirtualClock>();
+                LinkOptions options;
+                options.bytes_per_second = 1000;
+                options.latency = std::chrono::milliseconds(5);
+                LinkEmulator link(options, clock);
+
+                for (uint8_t byte = 0; byte < 4; ++byte)
+                {
+                    link.host()->writeByte(byte);
+                }
+
+                // The first byte takes 1ms to go out and 5ms to get there, the rest follow 1ms apart
+                clock->set(std::chrono::microseconds(5999));
+                link.device()->update();
+                ASSERT_TRUE(link.device()->empty());
+
+                clock->set(std::chrono::milliseconds(6));
+                link.device()->update();
+                ASSERT_EQ(link.device()->size(), 1u);
+
+                clock->set(std::chrono::milliseconds(8));
+                link.device()->update();
+                ASSERT_EQ(readAll(*link.device()), std::vector<uint8_t>({ 0, 1, 2 }));
+
+                clock->set(std::chrono::milliseconds(9));
+                link.device()->update();
+                ASSERT_EQ(readAll(*link.device()), std::vector<uint8_t>({ 3 }));
+
+                // Nothing went the other way
+                link.host()->update();
+                ASSERT_TRUE(link.host()->empty());
+                ASSERT_EQ(link.hostToDevice().bytes, 4u);
+                ASSERT_EQ(link.deviceToHost().bytes, 0u);
+            }
+
+            TEST(link_emulator, errors)
+            {
+                std::shared_ptr<VirtualClock> clock = std::make_shared<VirtualClock>();
+                LinkOptions lossy;
+                lossy.drop_rate = 1;
+                LinkOptions noisy;
+                noisy.bit_error_rate = 1;
+                LinkEmulator link(lossy, noisy, clock);
+
+                link.host()->writeByte(0x12);
+                link.device()->writeByte(0x12);
+                link.device()->update();
+                link.host()->update();
+
+                ASSERT_TRUE(link.device()->empty());
+                ASSERT_EQ(link.hostToDevice().dropped, 1u);
+                ASSERT_EQ(link.host()->readByte(), 0xED);
+                ASSERT_EQ(link.deviceToHost().corrupted, 1u);
+
+                LinkOptions invalid;
+                invalid.drop_rate = 2;
+                ASSERT_THROW(LinkEmulator{ invalid }, std::invalid_argument);
+            }
+
+            TEST(link_emulator, jitter_keeps_order)
+            {
+                std::shared_ptr<VirtualClock> clock = std::make_shared<VirtualClock>();
+                LinkOptions options;
+                options.jitter = std::chrono::milliseconds(10);
+                LinkEmulator link(options, clock);
+
+                std::vector<uint8_t> sent;
+                for (uint8_t byte = 0; byte < 100; ++byte)
+                {
+                    link.host()->writeByte(byte);
+                    sent.push_back(byte);
+                }
+
+                std::vector<uint8_t> received;
+                for (int ms = 0; ms <= 10; ++ms)
+                {
+                    clock->set(std::chrono::milliseconds(ms));
+                    link.device()->update();
+                    std::vector<uint8_t> bytes = readAll(*link.device());
+                    received.insert(received.end(), bytes.begin(), bytes.end());
+                }
+                ASSERT_EQ(received, sent);
+            }
+
+            TEST(link_emulator, messages)
+            {
+                LinkEmulator link(LinkOptions{}, std::make_shared<VirtualClock>());
+
+                const uint8_t message[] = { 0x01, shared::DataType::kUint16, 0x00, 0xC3,
+                                            shared::DataType::kEndOfMessage, 0x42 };
+                for (int i = 0; i < 2; ++i)
+                {
+                    for (uint8_t byte : message)
+                    {
+                        link.host()->writeByte(byte);
+                    }
+                }
+
+                ASSERT_EQ(link.device()->messages(), 0);
+                link.device()->update();
+                ASSERT_EQ(link.device()->messages(), 2);
+
+                // The count drops once the CRC of a message is read
+                for (size_t i = 0; i < sizeof(message) - 1; ++i)
+                {
+                    link.device()->readByte();
+                }
+                ASSERT_EQ(link.device()->messages(), 2);
+                link.device()->readByte();
+                ASSERT_EQ(link.device()->messages(), 1);
+
+                link.device()->zero();
+                ASSERT_TRUE(link.device()->empty());
+                ASSERT_EQ(link.device()->messages(), 0);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
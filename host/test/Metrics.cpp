@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include "EmbMessenger/Exceptions.hpp"
+#include "EmbMessenger/Metrics.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            using std::chrono::microseconds;
+
+            TEST(metrics, histogram_buckets)
+            {
+                // Exact below 8 us, then 8 buckets per power of two
+                ASSERT_EQ(HistogramSnapshot::bucket(0), 0u);
+                ASSERT_EQ(HistogramSnapshot::bucket(7), 7u);
+                ASSERT_EQ(HistogramSnapshot::bucket(8), 8u);
+                ASSERT_EQ(HistogramSnapshot::bucket(15), 15u);
+                ASSERT_EQ(HistogramSnapshot::bucket(16), 16u);
+                ASSERT_EQ(HistogramSnapshot::bucket(17), 16u);
+                ASSERT_EQ(HistogramSnapshot::bucket(18), 17u);
+                ASSERT_EQ(HistogramSnapshot::bucket(UINT64_MAX), HistogramSnapshot::kBuckets - 1);
+
+                for (uint64_t latency : { 1u, 9u, 100u, 1000u, 12345u, 1000000u })
+                {
+                    size_t bucket = HistogramSnapshot::bucket(latency);
+                    ASSERT_GE(HistogramSnapshot::bucketUpperBound(bucket), latency);
+                    ASSERT_LT(HistogramSnapshot::bucketUpperBound(bucket - 1), latency);
+
+                    // Within 12.5% of the latency
+                    ASSERT_LE(HistogramSnapshot::bucketUpperBound(bucket) - latency, latency / 8);
+                }
+            }
+
+            TEST(metrics, histogram_percentiles)
+            {
+                LatencyHistogram histogram;
+                ASSERT_EQ(histogram.snapshot().count, 0u);
+                ASSERT_EQ(histogram.snapshot().percentile(50), microseconds(0));
+
+                for (int i = 1; i <= 100; ++i)
+                {
+                    histogram.record(microseconds(i * 100));
+                }
+
+                HistogramSnapshot snapshot = histogram.snapshot();
+                ASSERT_EQ(snapshot.count, 100u);
+                ASSERT_EQ(snapshot.min, microseconds(100));
+                ASSERT_EQ(snapshot.max, microseconds(10000));
+                ASSERT_EQ(snapshot.mean(), microseconds(5050));
+
+                ASSERT_GE(snapshot.percentile(50), microseconds(5000));
+                ASSERT_LE(snapshot.percentile(50), microseconds(5000 + 5000 / 8));
+                ASSERT_GE(snapshot.percentile(99), microseconds(9900));
+                ASSERT_EQ(snapshot.percentile(100), microseconds(10000));
+                ASSERT_EQ(snapshot.percentile(0), microseconds(100));
+            }
+
+            TEST(metrics, counters)
+            {
+                Metrics metrics;
+                metrics.addCommand(3);
+                metrics.addCommand(0xFFFC);
+
+                metrics.countTransmitted(10);
+                metrics.countTransmitted(6);
+                metrics.countReceivedFrame();
+                metrics.countReceivedBytes(5);
+                metrics.countCrcFailure();
+                metrics.countError(std::make_exception_ptr(CrcInvalid(ExceptionSource::Host, "Bad CRC")));
+                metrics.countError(std::make_exception_ptr(CrcInvalid(ExceptionSource::Device, "Bad CRC")));
+                metrics.countError(std::make_exception_ptr(CommandTimeout("Late")));
+                metrics.countError(std::make_exception_ptr(std::runtime_error("Other")));
+                metrics.recordRtt(3, microseconds(250));
+                metrics.recordRtt(4, microseconds(250));
+                metrics.recordRtt(0xFFFC, microseconds(40));
+                metrics.recordRtt(0xFFFC, microseconds(60));
+                metrics.recordRtt(0xFFFD, microseconds(250));
+
+                MetricsSnapshot snapshot = metrics.snapshot();
+                ASSERT_EQ(snapshot.tx_bytes, 16u);
+                ASSERT_EQ(snapshot.tx_frames, 2u);
+                ASSERT_EQ(snapshot.rx_bytes, 5u);
+                ASSERT_EQ(snapshot.rx_frames, 1u);
+                ASSERT_EQ(snapshot.crc_failures, 1u);
+                ASSERT_EQ(snapshot.device_crc_failures, 0u);
+
+                ASSERT_EQ(snapshot.errors.size(), 3u);
+                ASSERT_EQ(snapshot.errors["CrcInvalid"], 2u);
+                ASSERT_EQ(snapshot.errors["CommandTimeout"], 1u);
+                ASSERT_EQ(snapshot.errors["std::exception"], 1u);
+
+                // Command IDs that weren't added aren't measured
+                ASSERT_EQ(snapshot.command_rtt.size(), 2u);
+                ASSERT_EQ(snapshot.command_rtt[3].count, 1u);
+                ASSERT_EQ(snapshot.command_rtt[0xFFFC].count, 2u);
+                ASSERT_EQ(snapshot.command_rtt[0xFFFC].mean(), microseconds(50));
+
+                ASSERT_GT(snapshot.rate(&MetricsSnapshot::tx_bytes, MetricsSnapshot()), 0);
+                ASSERT_EQ(snapshot.rate(&MetricsSnapshot::tx_bytes, snapshot), 0);
+            }
+
+            TEST(metrics, error_names)
+            {
+                Metrics metrics;
+
+                // Named by the type of the exception, whatever the message says
+                metrics.countError(std::make_exception_ptr(ParameterReadError(ExceptionSource::Device, 2)));
+                metrics.countError(std::make_exception_ptr(ParameterInvalid(1)));
+                metrics.countError(std::make_exception_ptr(BaseException(ExceptionSource::Device, "Looks: like one")));
+                metrics.countError(std::make_exception_ptr(CommandTimeout("CrcInvalid: not really")));
+                metrics.countError(std::make_exception_ptr(42));
+
+                MetricsSnapshot snapshot = metrics.snapshot();
+                ASSERT_EQ(snapshot.errors.size(), 5u);
+                ASSERT_EQ(snapshot.errors["ParameterReadError"], 1u);
+                ASSERT_EQ(snapshot.errors["ParameterInvalid"], 1u);
+                ASSERT_EQ(snapshot.errors["BaseException"], 1u);
+                ASSERT_EQ(snapshot.errors["CommandTimeout"], 1u);
+                ASSERT_EQ(snapshot.errors["unknown"], 1u);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
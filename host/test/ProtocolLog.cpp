@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "EmbMessenger/Crc.hpp"
+#include "EmbMessenger/DataType.hpp"
+#include "EmbMessenger/ProtocolLog.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            namespace
+            {
+                CaptureRecord makeRecord(CaptureDirection direction, std::vector<uint8_t> message)
+                {
+                    uint8_t crc = 0;
+                    message.push_back(shared::DataType::kEndOfMessage);
+                    for (uint8_t byte : message)
+                    {
+                        crc = shared::crc::Calculate8(crc, byte);
+                    }
+                    message.push_back(crc);
+
+                    CaptureRecord record;
+                    record.time = std::chrono::microseconds(5);
+                    record.direction = direction;
+                    record.data = message;
+                    return record;
+                }
+            }  // namespace
+
+            TEST(protocol_log, decode)
+            {
+                std::vector<CaptureRecord> records = {
+                    makeRecord(CaptureDirection::HostToDevice, { 0x03, 0x01, shared::DataType::kInt16, 0xFF, 0xFE }),
+                    makeRecord(CaptureDirection::DeviceToHost,
+                               { 0x03, shared::DataType::kError, 0x07, 0x02, shared::DataType::kFloat, 0x3F, 0xC0,
+                                 0x00, 0x00 })
+                };
+
+                std::vector<ProtocolEvent> events = decodeLog(records);
+                ASSERT_EQ(events.size(), 8u);
+
+                ASSERT_EQ(events[0].type, ProtocolEventType::Message);
+                ASSERT_EQ(events[0].message_id, 3);
+                ASSERT_EQ(events[0].time, std::chrono::microseconds(5));
+                ASSERT_EQ(events[1].type, ProtocolEventType::Command);
+                ASSERT_EQ(events[1].unsigned_value, 1u);
+                ASSERT_EQ(events[2].type, ProtocolEventType::Value);
+                ASSERT_EQ(events[2].data_type, shared::DataType::kInt16);
+                ASSERT_EQ(events[2].signed_value, -2);
+                ASSERT_EQ(events[3].type, ProtocolEventType::EndOfMessage);
+                ASSERT_TRUE(events[3].crc_valid);
+
+                ASSERT_EQ(events[4].direction, CaptureDirection::DeviceToHost);
+                ASSERT_EQ(events[5].type, ProtocolEventType::Error);
+                ASSERT_EQ(events[5].unsigned_value, 7u);
+                ASSERT_EQ(events[5].signed_value, 2);
+                ASSERT_EQ(events[6].type, ProtocolEventType::Value);
+                ASSERT_EQ(events[6].index, 1);
+                ASSERT_EQ(events[6].float_value, 1.5f);
+                ASSERT_EQ(events[7].type, ProtocolEventType::EndOfMessage);
+                ASSERT_TRUE(events[7].crc_valid);
+
+                ASSERT_EQ(formatEvent(events[1]), "Write Command Id: 1");
+                ASSERT_EQ(formatEvent(events[2]), "Write   0: -2");
+                ASSERT_EQ(formatEvent(events[3]), "Write Message 3 CRC Valid");
+                ASSERT_EQ(formatEvent(events[5]), "Read    0: Error 7 0x7 2");
+                ASSERT_EQ(formatEvent(events[6]), "Read    1: 1.5");
+                ASSERT_STREQ(dataTypeName(events[6].data_type), "Float");
+            }
+
+            TEST(protocol_log, addressed)
+            {
+                std::vector<CaptureRecord> records = {
+                    makeRecord(CaptureDirection::HostToDevice, { 0x05, 0x03, 0x01, shared::DataType::kNull }),
+                    makeRecord(CaptureDirection::DeviceToHost, { 0x05, 0x03, 0x02 }),
+                    makeRecord(CaptureDirection::HostToDevice, { shared::DataType::kUint8, 0xFF, 0x00, 0x01 })
+                };
+
+                std::vector<ProtocolEvent> events = decodeLog(records, true);
+                ASSERT_EQ(events.size(), 13u);
+
+                ASSERT_EQ(events[0].type, ProtocolEventType::Address);
+                ASSERT_EQ(events[0].unsigned_value, 5u);
+                ASSERT_EQ(events[0].message_id, 3);
+                ASSERT_EQ(events[1].type, ProtocolEventType::Message);
+                ASSERT_EQ(events[1].message_id, 3);
+                ASSERT_EQ(events[2].type, ProtocolEventType::Command);
+                ASSERT_EQ(events[2].unsigned_value, 1u);
+                ASSERT_EQ(events[3].index, 0);
+                ASSERT_EQ(events[4].type, ProtocolEventType::EndOfMessage);
+                ASSERT_TRUE(events[4].crc_valid);
+
+                ASSERT_EQ(events[5].type, ProtocolEventType::Address);
+                ASSERT_EQ(events[6].message_id, 3);
+                ASSERT_EQ(events[7].type, ProtocolEventType::Value);
+                ASSERT_EQ(events[7].unsigned_value, 2u);
+
+                ASSERT_EQ(formatEvent(events[0]), "Write Address: 5");
+                ASSERT_EQ(formatEvent(events[5]), "Read  Address: 5");
+                ASSERT_EQ(formatEvent(events[9]), "Write Address: 255 Broadcast");
+                ASSERT_EQ(events[12].type, ProtocolEventType::EndOfMessage);
+
+                // Without the address the message id and command id are off by one
+                events = decodeLog(records);
+                ASSERT_EQ(events[0].type, ProtocolEventType::Message);
+                ASSERT_EQ(events[0].message_id, 5);
+
+                // An address that can't be read
+                events.clear();
+                const uint8_t headless[] = { shared::DataType::kUint8 };
+                decodeMessage(CaptureDirection::DeviceToHost, std::chrono::nanoseconds(0), headless, sizeof(headless),
+                              events, true);
+                ASSERT_EQ(events.size(), 1u);
+                ASSERT_EQ(events[0].type, ProtocolEventType::Malformed);
+            }
+
+            TEST(protocol_log, malformed)
+            {
+                std::vector<ProtocolEvent> events;
+
+                // A print statement in the middle of a message
+                const uint8_t unknown[] = { 0x01, 0xC4, 0x02 };
+                decodeMessage(CaptureDirection::DeviceToHost, std::chrono::nanoseconds(0), unknown, sizeof(unknown),
+                              events);
+                ASSERT_EQ(events.size(), 3u);
+                ASSERT_EQ(events[1].type, ProtocolEventType::Unknown);
+                ASSERT_EQ(formatEvent(events[1]), "Read    0: Unknown Type 0xC4");
+                ASSERT_EQ(events[2].type, ProtocolEventType::Value);
+                ASSERT_EQ(events[2].unsigned_value, 2u);
+
+                // Cut off in the middle of a value
+                events.clear();
+                const uint8_t truncated[] = { 0x01, shared::DataType::kUint32, 0x00 };
+                decodeMessage(CaptureDirection::DeviceToHost, std::chrono::nanoseconds(0), truncated,
+                              sizeof(truncated), events);
+                ASSERT_EQ(events.size(), 2u);
+                ASSERT_EQ(events[1].type, ProtocolEventType::Truncated);
+
+                // A host message without a command id
+                events.clear();
+                const uint8_t headless[] = { 0x01 };
+                decodeMessage(CaptureDirection::HostToDevice, std::chrono::nanoseconds(0), headless, sizeof(headless),
+                              events);
+                ASSERT_EQ(events.size(), 1u);
+                ASSERT_EQ(events[0].type, ProtocolEventType::Malformed);
+                ASSERT_EQ(formatEvent(events[0]), "Write Malformed Message");
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "EmbMessenger/RttEstimator.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            using std::chrono::microseconds;
+            using std::chrono::milliseconds;
+
+            TEST(rtt_estimator, first_sample)
+            {
+                RttEstimator rtt;
+                ASSERT_EQ(rtt.samples(), 0u);
+                ASSERT_EQ(rtt.timeout(milliseconds(50)), milliseconds(50));
+
+                rtt.addSample(microseconds(800));
+                ASSERT_EQ(rtt.samples(), 1u);
+                ASSERT_EQ(rtt.smoothedRtt(), microseconds(800));
+                ASSERT_EQ(rtt.rttVariance(), microseconds(400));
+                ASSERT_EQ(rtt.timeout(milliseconds(50)), microseconds(2400));
+            }
+
+            TEST(rtt_estimator, smoothing)
+            {
+                RttEstimator rtt;
+                rtt.addSample(microseconds(1000));
+                rtt.addSample(microseconds(1800));
+
+                // The smoothed RTT moves 1/8 and the variance 1/4 of the way
+                ASSERT_EQ(rtt.smoothedRtt(), microseconds(1100));
+                ASSERT_EQ(rtt.rttVariance(), microseconds(575));
+                ASSERT_EQ(rtt.minRtt(), microseconds(1000));
+                ASSERT_EQ(rtt.lastRtt(), microseconds(1800));
+
+                for (int i = 0; i < 100; ++i)
+                {
+                    rtt.addSample(microseconds(1000));
+                }
+                ASSERT_NEAR(rtt.smoothedRtt().count(), 1000, 1);
+                ASSERT_LE(rtt.rttVariance(), microseconds(1));
+
+                rtt.reset();
+                ASSERT_EQ(rtt.samples(), 0u);
+            }
+
+            TEST(rtt_estimator, timeout_bounds)
+            {
+                RttEstimator rtt(milliseconds(2), milliseconds(100));
+                rtt.addSample(microseconds(10));
+                ASSERT_EQ(rtt.timeout(milliseconds(50)), milliseconds(2));
+
+                rtt.addSample(milliseconds(1000));
+                ASSERT_EQ(rtt.timeout(milliseconds(50)), milliseconds(100));
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "EmbMessenger/SpscQueue.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(spsc_queue, push_pop)
+            {
+                SpscQueue<int> queue(3);
+                ASSERT_EQ(queue.capacity(), 4u);
+
+                for (int i = 0; i < 4; ++i)
+                {
+                    ASSERT_TRUE(queue.push(i));
+                }
+                ASSERT_FALSE(queue.push(4));
+                ASSERT_EQ(queue.size(), 4u);
+
+                int items[3];
+                ASSERT_EQ(queue.pop(items, 3), 3u);
+                ASSERT_EQ(items[0], 0);
+                ASSERT_EQ(items[1], 1);
+                ASSERT_EQ(items[2], 2);
+
+                ASSERT_TRUE(queue.push(5));
+                ASSERT_EQ(queue.pop(items, 3), 2u);
+                ASSERT_EQ(items[0], 3);
+                ASSERT_EQ(items[1], 5);
+                ASSERT_EQ(queue.pop(items, 3), 0u);
+            }
+
+            TEST(spsc_queue, pop_releases_items)
+            {
+                SpscQueue<std::shared_ptr<int>> queue(2);
+                std::shared_ptr<int> item = std::make_shared<int>(1);
+
+                ASSERT_TRUE(queue.push(item));
+                ASSERT_EQ(item.use_count(), 2);
+
+                std::shared_ptr<int> popped[2];
+                ASSERT_EQ(queue.pop(popped, 2), 1u);
+                ASSERT_EQ(popped[0], item);
+                popped[0] = nullptr;
+                ASSERT_EQ(item.use_count(), 1);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "EmbMessenger/TimerWheel.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            using std::chrono::milliseconds;
+            using std::chrono::minutes;
+            using std::chrono::seconds;
+
+            TEST(timer_wheel, expires_after_deadline)
+            {
+                TimerWheel::clock_t::time_point start = TimerWheel::clock_t::now();
+                TimerWheel wheel(4, milliseconds(1), start);
+                std::vector<uint32_t> expired;
+                auto record = [&](uint32_t timer) { expired.push_back(timer); };
+
+                wheel.schedule(1, start + milliseconds(5));
+                wheel.schedule(2, start + milliseconds(5));
+                wheel.schedule(3, start + milliseconds(7));
+                ASSERT_EQ(wheel.size(), 3u);
+
+                ASSERT_EQ(wheel.advance(start + milliseconds(4), record), 0u);
+                ASSERT_EQ(wheel.advance(start + milliseconds(5), record), 2u);
+                ASSERT_EQ(expired.size(), 2u);
+                ASSERT_FALSE(wheel.scheduled(1));
+                ASSERT_TRUE(wheel.scheduled(3));
+
+                // A deadline in the middle of a tick is rounded up
+                wheel.schedule(0, start + milliseconds(6) + std::chrono::microseconds(500));
+                ASSERT_EQ(wheel.advance(start + milliseconds(6), record), 0u);
+                ASSERT_EQ(wheel.advance(start + milliseconds(7) + std::chrono::microseconds(500), [&](uint32_t timer) {
+                    ASSERT_EQ(wheel.time(), start + milliseconds(7));
+                    record(timer);
+                }), 2u);
+                ASSERT_EQ(wheel.size(), 0u);
+            }
+
+            TEST(timer_wheel, cancel_and_reschedule)
+            {
+                TimerWheel::clock_t::time_point start = TimerWheel::clock_t::now();
+                TimerWheel wheel(2, milliseconds(1), start);
+                std::vector<uint32_t> expired;
+                auto record = [&](uint32_t timer) { expired.push_back(timer); };
+
+                wheel.schedule(0, start + milliseconds(3));
+                wheel.schedule(1, start + milliseconds(3));
+                wheel.cancel(0);
+                wheel.cancel(0);
+                wheel.schedule(1, start + milliseconds(10));
+                ASSERT_EQ(wheel.size(), 1u);
+
+                ASSERT_EQ(wheel.advance(start + milliseconds(9), record), 0u);
+                ASSERT_EQ(wheel.advance(start + milliseconds(10), record), 1u);
+                ASSERT_EQ(expired, std::vector<uint32_t>({ 1 }));
+
+                // Deadlines in the past expire on the next tick
+                wheel.schedule(0, start);
+                ASSERT_EQ(wheel.advance(start + milliseconds(11), record), 1u);
+            }
+
+            TEST(timer_wheel, reschedule_while_expiring)
+            {
+                TimerWheel::clock_t::time_point start = TimerWheel::clock_t::now();
+                TimerWheel wheel(1, milliseconds(1), start);
+
+                size_t count = 0;
+                TimerWheel::clock_t::time_point now = start;
+                auto periodic = [&](uint32_t timer) {
+                    ++count;
+                    wheel.schedule(timer, now + milliseconds(100));
+                };
+
+                wheel.schedule(0, start + milliseconds(100));
+                for (now = start; now <= start + seconds(1); now += milliseconds(1))
+                {
+                    wheel.advance(now, periodic);
+                }
+                ASSERT_EQ(count, 10u);
+                ASSERT_TRUE(wheel.scheduled(0));
+            }
+
+            TEST(timer_wheel, cascade_levels)
+            {
+                TimerWheel::clock_t::time_point start = TimerWheel::clock_t::now();
+                TimerWheel wheel(4, milliseconds(1), start);
+                std::vector<uint32_t> expired;
+                auto record = [&](uint32_t timer) { expired.push_back(timer); };
+
+                // One timer on each level of the wheel
+                TimerWheel::clock_t::duration deadlines[] = { milliseconds(200), seconds(10), minutes(5), minutes(30) };
+                for (uint32_t timer = 0; timer < 4; ++timer)
+                {
+                    wheel.schedule(timer, start + deadlines[timer]);
+                }
+
+                for (uint32_t timer = 0; timer < 4; ++timer)
+                {
+                    ASSERT_EQ(wheel.advance(start + deadlines[timer] - milliseconds(1), record), 0u);
+                    ASSERT_EQ(wheel.advance(start + deadlines[timer], record), 1u);
+                    ASSERT_EQ(expired.back(), timer);
+                }
+            }
+
+            TEST(timer_wheel, beyond_reach)
+            {
+                TimerWheel::clock_t::time_point start = TimerWheel::clock_t::now();
+                TimerWheel wheel(1, milliseconds(1), start);
+                size_t count = 0;
+
+                // Further out than the 2^26 ticks the wheel covers
+                wheel.schedule(0, start + std::chrono::hours(20));
+                wheel.advance(start + std::chrono::hours(19), [&](uint32_t) { ++count; });
+                ASSERT_EQ(count, 0u);
+                wheel.advance(start + std::chrono::hours(20), [&](uint32_t) { ++count; });
+                ASSERT_EQ(count, 1u);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
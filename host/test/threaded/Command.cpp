@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Connection.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(threaded_command, wait_for)
+            {
+                Connection connection;
+
+                auto sleep = connection.messenger.send(std::make_shared<Sleep>(200));
+                ASSERT_FALSE(sleep->waitFor(std::chrono::milliseconds(10)));
+                ASSERT_EQ(sleep->getCommandState(), CommandState::Sent);
+
+                ASSERT_TRUE(sleep->waitUntil(std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+                ASSERT_EQ(sleep->getCommandState(), CommandState::Received);
+                ASSERT_EQ(sleep->getException(), nullptr);
+
+                // Returns right away once the command was received
+                ASSERT_TRUE(sleep->waitFor(std::chrono::nanoseconds::zero()));
+                ASSERT_EQ(connection.errors, 0u);
+            }
+
+            TEST(threaded_command, wait_wakes_on_failure)
+            {
+                Connection connection;
+                connection.messenger.setDefaultTimeout(std::chrono::milliseconds(20));
+
+                auto sleep = connection.messenger.send(std::make_shared<Sleep>(500));
+                ASSERT_TRUE(sleep->waitFor(std::chrono::milliseconds(400)));
+                ASSERT_NE(sleep->getException(), nullptr);
+                ASSERT_THROW(std::rethrow_exception(sleep->getException()), CommandTimeout);
+
+                // The timeout is passed to the exception handler after the waiters are woken
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                while (connection.errors == 0 && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+                ASSERT_EQ(connection.errors, 1u);
+            }
+
+            TEST(threaded_command, many_waiters)
+            {
+                Connection connection;
+
+                // The waiting threads share the wait buckets, each one must still be woken by its own command
+                std::vector<std::thread> threads;
+                std::atomic<size_t> wrong{ 0 };
+                for (int t = 0; t < 8; ++t)
+                {
+                    threads.emplace_back([&, t] {
+                        for (int i = 0; i < 200; ++i)
+                        {
+                            auto add = connection.messenger.send(std::make_shared<Add>(i, t));
+                            if (!add->waitFor(std::chrono::seconds(5)) || add->Result != i + t)
+                            {
+                                ++wrong;
+                            }
+                        }
+                    });
+                }
+
+                for (std::thread& thread : threads)
+                {
+                    thread.join();
+                }
+
+                ASSERT_EQ(wrong, 0u);
+                ASSERT_EQ(connection.errors, 0u);
+                ASSERT_TRUE(connection.messenger.commandsReceived());
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
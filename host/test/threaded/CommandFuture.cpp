@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "EmbMessenger/CommandFuture.hpp"
+#include "Connection.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+#ifdef EMB_HAS_COROUTINES
+            namespace
+            {
+                // Runs until its first co_await on the calling thread, the rest runs wherever it is resumed
+                struct Task
+                {
+                    struct promise_type
+                    {
+                        Task get_return_object()
+                        {
+                            return Task();
+                        }
+
+                        std::suspend_never initial_suspend() noexcept
+                        {
+                            return std::suspend_never();
+                        }
+
+                        std::suspend_never final_suspend() noexcept
+                        {
+                            return std::suspend_never();
+                        }
+
+                        void return_void()
+                        {
+                        }
+
+                        void unhandled_exception()
+                        {
+                            std::terminate();
+                        }
+                    };
+                };
+
+                struct Resumed
+                {
+                    std::thread::id thread;
+                    int result = 0;
+                    bool failed = false;
+                };
+
+                Task add(EmbMessenger& messenger, int a, int b, std::promise<Resumed>& resumed)
+                {
+                    Resumed result;
+                    try
+                    {
+                        result.result = (co_await messenger.sendAsync(std::make_shared<Add>(a, b)))->Result;
+                    }
+                    catch (const CommandTimeout&)
+                    {
+                        result.failed = true;
+                    }
+                    result.thread = std::this_thread::get_id();
+                    resumed.set_value(result);
+                }
+
+                Task sleep(EmbMessenger& messenger, uint16_t milliseconds, std::promise<Resumed>& resumed)
+                {
+                    Resumed result;
+                    try
+                    {
+                        co_await messenger.sendAsync(std::make_shared<Sleep>(milliseconds));
+                    }
+                    catch (const CommandTimeout&)
+                    {
+                        result.failed = true;
+                    }
+                    result.thread = std::this_thread::get_id();
+                    resumed.set_value(result);
+                }
+
+                // Sends the next command from wherever the first one resumed it
+                Task sleepThenAdd(EmbMessenger& messenger, uint16_t milliseconds, int a, int b,
+                                  std::promise<Resumed>& resumed)
+                {
+                    Resumed result;
+                    try
+                    {
+                        co_await messenger.sendAsync(std::make_shared<Sleep>(milliseconds));
+                    }
+                    catch (const CommandTimeout&)
+                    {
+                        result.failed = true;
+                    }
+
+                    std::shared_ptr<Add> add = std::make_shared<Add>(a, b);
+                    add->setTimeout(std::chrono::seconds(2));
+                    result.result = (co_await messenger.sendAsync(add))->Result;
+                    result.thread = std::this_thread::get_id();
+                    resumed.set_value(result);
+                }
+            }  // namespace
+#endif
+
+            TEST(threaded_command_future, get_blocks)
+            {
+                Connection connection;
+
+                CommandFuture<Sleep> sleep = connection.messenger.sendAsync(std::make_shared<Sleep>(50));
+                ASSERT_FALSE(sleep.waitFor(std::chrono::milliseconds(1)));
+
+                // Sent on this thread, waited on by another
+                CommandFuture<Add> add = connection.messenger.sendAsync(std::make_shared<Add>(7, 2));
+                std::future<int> result = std::async(std::launch::async, [add] { return add.get()->Result; });
+
+                ASSERT_EQ(result.get(), 9);
+                ASSERT_TRUE(sleep.ready());
+                ASSERT_TRUE(add.ready());
+                ASSERT_EQ(connection.errors, 0u);
+            }
+
+#ifdef EMB_HAS_COROUTINES
+            TEST(threaded_command_future, co_await_resumes_on_update_thread)
+            {
+                Connection connection;
+
+                std::promise<Resumed> resumed;
+                std::future<Resumed> result = resumed.get_future();
+                add(connection.messenger, 7, 2, resumed);
+
+                ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+                Resumed value = result.get();
+                ASSERT_FALSE(value.failed);
+                ASSERT_EQ(value.result, 9);
+                ASSERT_NE(value.thread, std::this_thread::get_id());
+            }
+
+            TEST(threaded_command_future, co_await_many)
+            {
+                Connection connection;
+
+                // Suspended from several threads at once, each one resumed once
+                std::vector<std::promise<Resumed>> resumed(64);
+                std::vector<std::thread> threads;
+                for (int t = 0; t < 4; ++t)
+                {
+                    threads.emplace_back([&, t] {
+                        for (int i = t; i < 64; i += 4)
+                        {
+                            add(connection.messenger, i, 1, resumed[i]);
+                        }
+                    });
+                }
+
+                for (std::thread& thread : threads)
+                {
+                    thread.join();
+                }
+
+                for (int i = 0; i < 64; ++i)
+                {
+                    std::future<Resumed> result = resumed[i].get_future();
+                    ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+                    ASSERT_EQ(result.get().result, i + 1);
+                }
+                ASSERT_EQ(connection.errors, 0u);
+            }
+
+            TEST(threaded_command_future, co_await_throws_timeout)
+            {
+                Connection connection;
+                connection.messenger.setDefaultTimeout(std::chrono::milliseconds(20));
+
+                std::promise<Resumed> resumed;
+                std::future<Resumed> result = resumed.get_future();
+                sleep(connection.messenger, 200, resumed);
+
+                ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+                Resumed value = result.get();
+                ASSERT_TRUE(value.failed);
+                ASSERT_NE(value.thread, std::this_thread::get_id());
+            }
+
+            TEST(threaded_command_future, co_await_then_send)
+            {
+                Connection connection;
+
+                std::promise<Resumed> resumed;
+                std::future<Resumed> result = resumed.get_future();
+                sleepThenAdd(connection.messenger, 1, 7, 2, resumed);
+
+                ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+                Resumed value = result.get();
+                ASSERT_FALSE(value.failed);
+                ASSERT_EQ(value.result, 9);
+                ASSERT_EQ(connection.errors, 0u);
+            }
+
+            TEST(threaded_command_future, co_await_timeout_then_send)
+            {
+                Connection connection;
+                connection.messenger.setDefaultTimeout(std::chrono::milliseconds(20));
+
+                std::promise<Resumed> resumed;
+                std::future<Resumed> result = resumed.get_future();
+                sleepThenAdd(connection.messenger, 100, 7, 2, resumed);
+
+                ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+                Resumed value = result.get();
+                ASSERT_TRUE(value.failed);
+                ASSERT_EQ(value.result, 9);
+            }
+#endif
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,57 @@
+#ifndef EMBMESSENGER_TEST_CONNECTION_HPP
+#define EMBMESSENGER_TEST_CONNECTION_HPP
+
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "EmbMessenger/LinkEmulator.hpp"
+
+#include "Add.hpp"
+#include "DeviceThread.hpp"
+#include "Ping.hpp"
+#include "SetLed.hpp"
+#include "Sleep.hpp"
+#include "ToggleLed.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            /**
+             * A Multi Threaded EmbMessenger connected to a DeviceThread. The errors passed to the exception handler
+             * are counted and don't stop the update thread.
+             */
+            struct Connection
+            {
+                LinkEmulator link;
+                DeviceThread device;
+                std::atomic<size_t> errors{ 0 };
+                EmbMessenger messenger;
+
+                explicit Connection(ThreadOptions options = ThreadOptions()) :
+                    link(LinkOptions()),
+                    device(link.device()),
+                    messenger(link.host(),
+                              [this](std::exception_ptr) {
+                                  ++errors;
+                                  return false;
+                              },
+                              std::chrono::seconds(2), options)
+                {
+                    messenger.registerCommand<Ping>(kPing);
+                    messenger.registerCommand<SetLed>(kSetLed);
+                    messenger.registerCommand<ToggleLed>(kToggleLed);
+                    messenger.registerCommand<Add>(kAdd);
+                    messenger.registerCommand<Sleep>(kSleep);
+                }
+            };
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_TEST_CONNECTION_HPP
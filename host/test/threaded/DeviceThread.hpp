@@ -0,0 +1,48 @@
+#ifndef EMBMESSENGER_TEST_DEVICETHREAD_HPP
+#define EMBMESSENGER_TEST_DEVICETHREAD_HPP
+
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            constexpr uint16_t kPing = 0;
+            constexpr uint16_t kSetLed = 1;
+            constexpr uint16_t kToggleLed = 2;
+            constexpr uint16_t kAdd = 3;
+            constexpr uint16_t kSleep = 4;
+
+            /**
+             * A device updated on its own thread until it is destroyed. Its commands are Ping, SetLed, ToggleLed that
+             * responds with the LED's state, Add that responds with the sum of two `int16_t` and Sleep that holds up
+             * the device for a `uint16_t` number of milliseconds.
+             */
+            class DeviceThread
+            {
+                class Device;
+
+                std::shared_ptr<shared::IBuffer> m_buffer;
+                std::unique_ptr<Device> m_device;
+                std::atomic_bool m_running;
+                std::thread m_thread;
+
+            public:
+                explicit DeviceThread(std::shared_ptr<shared::IBuffer> buffer);
+                ~DeviceThread();
+
+                DeviceThread(const DeviceThread&) = delete;
+                DeviceThread& operator=(const DeviceThread&) = delete;
+            };
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_TEST_DEVICETHREAD_HPP
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#include "Connection.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            namespace
+            {
+                // Several threads send at once, each sender's messages must reach the device in the order it sent them
+                void sendConcurrently(TransmitMode mode)
+                {
+                    ThreadOptions options;
+                    options.transmit_mode = mode;
+                    Connection connection(options);
+
+                    constexpr int kSenders = 4;
+                    constexpr int kCommands = 250;
+                    constexpr size_t kBurst = 50;
+
+                    std::mutex mutex;
+                    std::vector<std::vector<int>> received(kSenders);
+                    std::vector<std::thread> senders;
+                    std::atomic<size_t> wrong{ 0 };
+                    for (int t = 0; t < kSenders; ++t)
+                    {
+                        senders.emplace_back([&, t] {
+                            // In bursts that fit in the command table together
+                            std::vector<std::shared_ptr<Add>> sent;
+                            for (int i = 0; i < kCommands; ++i)
+                            {
+                                std::shared_ptr<Add> add = connection.messenger.makeCommand<Add>(i, t);
+                                add->setCallback<Add>([&, t, i](std::shared_ptr<Add> add) {
+                                    std::lock_guard<std::mutex> lock(mutex);
+                                    received[t].push_back(i);
+                                    wrong += add->Result != i + t;
+                                });
+                                sent.push_back(connection.messenger.send(add));
+
+                                if (sent.size() == kBurst)
+                                {
+                                    for (std::shared_ptr<Add>& add : sent)
+                                    {
+                                        wrong += !add->waitFor(std::chrono::seconds(5));
+                                    }
+                                    sent.clear();
+                                }
+                            }
+                        });
+                    }
+
+                    for (std::thread& sender : senders)
+                    {
+                        sender.join();
+                    }
+
+                    // The callbacks run after the waiters are woken
+                    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                    while (std::chrono::steady_clock::now() < deadline)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        size_t total = 0;
+                        for (std::vector<int>& sender : received)
+                        {
+                            total += sender.size();
+                        }
+
+                        if (total == kSenders * kCommands)
+                        {
+                            break;
+                        }
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ASSERT_EQ(wrong, 0u);
+                    ASSERT_EQ(connection.errors, 0u);
+                    for (std::vector<int>& sender : received)
+                    {
+                        ASSERT_EQ(sender.size(), static_cast<size_t>(kCommands));
+                        for (int i = 0; i < kCommands; ++i)
+                        {
+                            ASSERT_EQ(sender[i], i);
+                        }
+                    }
+                }
+            }  // namespace
+
+            TEST(threaded_messenger, transmit_dedicated)
+            {
+                sendConcurrently(TransmitMode::Dedicated);
+            }
+
+            TEST(threaded_messenger, transmit_inline)
+            {
+                sendConcurrently(TransmitMode::Inline);
+            }
+
+            TEST(threaded_messenger, send_from_callback)
+            {
+                for (TransmitMode mode : { TransmitMode::Dedicated, TransmitMode::Inline })
+                {
+                    ThreadOptions options;
+                    options.transmit_mode = mode;
+                    Connection connection(options);
+
+                    // Sent from the update thread, which mustn't wait on itself
+                    std::shared_ptr<Add> second;
+                    std::shared_ptr<Add> first = connection.messenger.makeCommand<Add>(1, 2);
+                    first->setCallback<Add>([&](std::shared_ptr<Add> added) {
+                        std::atomic_store(&second, connection.messenger.send(std::make_shared<Add>(added->Result, 4)));
+                    });
+                    connection.messenger.send(first);
+
+                    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                    while (std::atomic_load(&second) == nullptr && std::chrono::steady_clock::now() < deadline)
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    std::shared_ptr<Add> sent = std::atomic_load(&second);
+                    ASSERT_NE(sent, nullptr);
+                    ASSERT_TRUE(sent->waitFor(std::chrono::seconds(5)));
+                    ASSERT_EQ(sent->Result, 7);
+                    ASSERT_EQ(connection.errors, 0u);
+                }
+            }
+
+#ifdef __linux__
+            TEST(threaded_messenger, thread_names)
+            {
+                ThreadOptions options;
+                options.receive_name = "test-rx";
+                Connection connection(options);
+
+                std::mutex mutex;
+                std::string name;
+                std::shared_ptr<Ping> ping = connection.messenger.makeCommand<Ping>();
+                ping->setCallback<Ping>([&](std::shared_ptr<Ping>) {
+                    char buffer[16] = {};
+                    pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+                    std::lock_guard<std::mutex> lock(mutex);
+                    name = buffer;
+                });
+                connection.messenger.send(ping);
+                ASSERT_TRUE(ping->waitFor(std::chrono::seconds(5)));
+
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                while (std::chrono::steady_clock::now() < deadline)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!name.empty())
+                    {
+                        break;
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ASSERT_EQ(name, "test-rx");
+            }
+#endif
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,187 @@
+#ifdef __linux__
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EmbMessenger/EmbMessengerPool.hpp"
+#include "Connection.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            namespace
+            {
+                ThreadOptions external()
+                {
+                    ThreadOptions options;
+                    options.receive_mode = ReceiveMode::External;
+                    options.transmit_mode = TransmitMode::Inline;
+                    return options;
+                }
+
+                // The pool shares the messenger with the connection that owns it
+                std::shared_ptr<EmbMessenger> messengerOf(const std::shared_ptr<Connection>& connection)
+                {
+                    return std::shared_ptr<EmbMessenger>(connection, &connection->messenger);
+                }
+            }  // namespace
+
+            TEST(threaded_pool, external_poll)
+            {
+                Connection connection(external());
+
+                auto add = connection.messenger.send(std::make_shared<Add>(2, 3));
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (add->getCommandState() != CommandState::Received && std::chrono::steady_clock::now() < deadline)
+                {
+                    connection.messenger.poll();
+                }
+                ASSERT_EQ(add->getCommandState(), CommandState::Received);
+                ASSERT_EQ(add->Result, 5);
+                ASSERT_EQ(connection.errors, 0u);
+
+                // Polling an EmbMessenger would race its own update thread
+                Connection threaded;
+                ASSERT_THROW(threaded.messenger.poll(), std::logic_error);
+            }
+
+            TEST(threaded_pool, callback_order)
+            {
+                constexpr size_t kConnections = 4;
+                constexpr int kCommands = 200;
+                constexpr size_t kBurst = 50;
+
+                // Each messenger's callbacks run one at a time on the pool's threads, in the order of its messages
+                std::mutex mutex;
+                std::vector<std::vector<int>> received(kConnections);
+                std::atomic<size_t> wrong{ 0 };
+
+                PoolOptions options;
+                options.threads = 3;
+                EmbMessengerPool pool(options);
+
+                std::vector<std::shared_ptr<Connection>> connections;
+                for (size_t c = 0; c < kConnections; ++c)
+                {
+                    connections.push_back(std::make_shared<Connection>(external()));
+                    pool.add(messengerOf(connections.back()));
+                }
+                ASSERT_EQ(pool.size(), kConnections);
+
+                std::vector<std::thread> senders;
+                for (size_t c = 0; c < kConnections; ++c)
+                {
+                    senders.emplace_back([&, c] {
+                        std::vector<std::shared_ptr<Add>> sent;
+                        for (int i = 0; i < kCommands; ++i)
+                        {
+                            std::shared_ptr<Add> add = connections[c]->messenger.makeCommand<Add>(i, 1);
+                            add->setCallback<Add>([&, c, i](std::shared_ptr<Add> add) {
+                                char name[16] = {};
+                                pthread_getname_np(pthread_self(), name, sizeof(name));
+                                std::lock_guard<std::mutex> lock(mutex);
+                                received[c].push_back(i);
+                                wrong += add->Result != i + 1 || std::string(name) != "emb-pool";
+                            });
+                            sent.push_back(connections[c]->messenger.send(add));
+
+                            if (sent.size() == kBurst)
+                            {
+                                for (std::shared_ptr<Add>& add : sent)
+                                {
+                                    wrong += !add->waitFor(std::chrono::seconds(5));
+                                }
+                                sent.clear();
+                            }
+                        }
+                    });
+                }
+
+                for (std::thread& sender : senders)
+                {
+                    sender.join();
+                }
+
+                // The callbacks run after the waiters are woken
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                while (std::chrono::steady_clock::now() < deadline)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    size_t total = 0;
+                    for (std::vector<int>& connection : received)
+                    {
+                        total += connection.size();
+                    }
+
+                    if (total == kConnections * kCommands)
+                    {
+                        break;
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ASSERT_EQ(wrong, 0u);
+                for (size_t c = 0; c < kConnections; ++c)
+                {
+                    ASSERT_EQ(connections[c]->errors, 0u);
+                    ASSERT_EQ(received[c].size(), static_cast<size_t>(kCommands));
+                    for (int i = 0; i < kCommands; ++i)
+                    {
+                        ASSERT_EQ(received[c][i], i);
+                    }
+                }
+
+                for (std::shared_ptr<Connection>& connection : connections)
+                {
+                    ASSERT_TRUE(pool.remove(messengerOf(connection)));
+                    ASSERT_FALSE(pool.remove(messengerOf(connection)));
+                }
+                ASSERT_EQ(pool.size(), 0u);
+            }
+
+            TEST(threaded_pool, remove_under_traffic)
+            {
+                EmbMessengerPool pool;
+                std::shared_ptr<Connection> connection = std::make_shared<Connection>(external());
+                std::shared_ptr<EmbMessenger> messenger = messengerOf(connection);
+                pool.add(messenger);
+
+                // Sampled on every loop of the device and slower to handle than to send, so every poll has more
+                // messages waiting and the messenger never goes idle
+                std::atomic<size_t> samples{ 0 };
+                messenger->registerPeriodicCommand<ToggleLed>(0, [&](std::shared_ptr<ToggleLed>) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    ++samples;
+                });
+
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (samples < 100 && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+                ASSERT_GE(samples, 100u);
+
+                ASSERT_TRUE(pool.remove(messenger));
+                ASSERT_EQ(pool.size(), 0u);
+
+                // Nothing polls it anymore, it is the caller's again
+                size_t removed = samples;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                ASSERT_EQ(samples, removed);
+                ASSERT_GT(messenger->poll(), 0u);
+                ASSERT_GT(samples, removed);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
+
+#endif  // __linux__
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "EmbMessenger/Frame.hpp"
+#include "EmbMessenger/FrameQueue.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(threaded_frame_queue, many_producers)
+            {
+                constexpr uint8_t kProducers = 4;
+                constexpr uint16_t kFrames = 20000;
+
+                // Small, so the producers wrap around and find it full
+                FrameQueue queue(16);
+
+                std::vector<std::thread> producers;
+                for (uint8_t p = 0; p < kProducers; ++p)
+                {
+                    producers.emplace_back([&queue, p] {
+                        Frame frame;
+                        for (uint16_t i = 0; i < kFrames; ++i)
+                        {
+                            frame.clear();
+                            frame.writeByte(p);
+                            frame.writeByte(static_cast<uint8_t>(i >> 8));
+                            frame.writeByte(static_cast<uint8_t>(i));
+
+                            // Each frame is a different size, a torn copy would show
+                            for (uint16_t j = 0; j < i % 32; ++j)
+                            {
+                                frame.writeByte(p);
+                            }
+
+                            while (!queue.push(frame))
+                            {
+                                std::this_thread::yield();
+                            }
+                        }
+                    });
+                }
+
+                // Each producer's frames come out whole and in the order it pushed them
+                std::vector<uint32_t> next(kProducers, 0);
+                size_t wrong = 0;
+                Frame frame;
+                for (uint32_t popped = 0; popped < kProducers * kFrames;)
+                {
+                    if (!queue.pop(frame))
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    ++popped;
+
+                    const uint8_t* data = frame.data();
+                    uint8_t p = data[0];
+                    uint16_t i = static_cast<uint16_t>(data[1] << 8 | data[2]);
+                    if (p >= kProducers || i != next[p] || frame.size() != 3u + i % 32)
+                    {
+                        ++wrong;
+                        continue;
+                    }
+
+                    for (size_t j = 3; j < frame.size(); ++j)
+                    {
+                        wrong += data[j] != p;
+                    }
+                    ++next[p];
+                }
+
+                for (std::thread& producer : producers)
+                {
+                    producer.join();
+                }
+
+                ASSERT_EQ(wrong, 0u);
+                ASSERT_TRUE(queue.empty());
+                ASSERT_EQ(queue.size(), 0u);
+                for (uint8_t p = 0; p < kProducers; ++p)
+                {
+                    ASSERT_EQ(next[p], kFrames);
+                }
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "EmbMessenger/Metrics.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(threaded_metrics, add_command_while_recording)
+            {
+                Metrics metrics;
+                metrics.addCommand(0);
+
+                // Like registering commands while the update thread records the round trip times
+                std::atomic_bool adding{ true };
+                std::thread recorder([&] {
+                    uint16_t command_id = 0;
+                    while (adding)
+                    {
+                        metrics.recordRtt(command_id, std::chrono::microseconds(100));
+                        command_id = static_cast<uint16_t>((command_id + 1) % 1000);
+                    }
+                    metrics.recordRtt(999, std::chrono::microseconds(100));
+                });
+
+                for (uint16_t command_id = 1; command_id < 1000; ++command_id)
+                {
+                    metrics.addCommand(command_id);
+                    metrics.snapshot();
+                }
+                adding = false;
+                recorder.join();
+
+                MetricsSnapshot snapshot = metrics.snapshot();
+                ASSERT_GE(snapshot.command_rtt[0].count, 1u);
+                ASSERT_GE(snapshot.command_rtt[999].count, 1u);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,33 @@
+#ifndef EMBMESSENGER_TEST_SLEEP_HPP
+#define EMBMESSENGER_TEST_SLEEP_HPP
+
+#include "EmbMessenger/Command.hpp"
+#include "EmbMessenger/EmbMessenger.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            class Sleep : public Command
+            {
+            protected:
+                uint16_t milliseconds;
+
+            public:
+                Sleep(uint16_t ms)
+                {
+                    milliseconds = ms;
+                }
+
+                void send(EmbMessenger* messenger)
+                {
+                    messenger->write(milliseconds);
+                }
+            };
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
+
+#endif  // EMBMESSENGER_TEST_SLEEP_HPP
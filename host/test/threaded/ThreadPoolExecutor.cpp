@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EmbMessenger/ThreadPoolExecutor.hpp"
+#include "Connection.hpp"
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            TEST(threaded_executor, per_key_order)
+            {
+                constexpr uint16_t kKeys = 16;
+                constexpr uint32_t kTasks = 4000;
+
+                std::vector<uint32_t> next(kKeys, 0);
+                std::vector<std::atomic_bool> running(kKeys);
+                std::atomic<size_t> wrong{ 0 };
+                std::atomic<uint32_t> done{ 0 };
+                {
+                    ThreadPoolExecutor executor(4);
+                    for (uint32_t i = 0; i < kTasks; ++i)
+                    {
+                        uint16_t key = static_cast<uint16_t>(i % kKeys);
+                        uint32_t sequence = i / kKeys;
+                        executor.execute(key, [&, key, sequence] {
+                            // A key's tasks never overlap, so its counter needs no lock
+                            if (running[key].exchange(true))
+                            {
+                                ++wrong;
+                            }
+
+                            wrong += next[key] != sequence;
+                            next[key] = sequence + 1;
+                            if (sequence % 64 == 0)
+                            {
+                                std::this_thread::yield();
+                            }
+
+                            running[key] = false;
+                            ++done;
+                        });
+                    }
+
+                    // The tasks still queued run before the workers are joined
+                }
+
+                ASSERT_EQ(done, kTasks);
+                ASSERT_EQ(wrong, 0u);
+                for (uint32_t count : next)
+                {
+                    ASSERT_EQ(count, kTasks / kKeys);
+                }
+            }
+
+            TEST(threaded_executor, messenger_callbacks)
+            {
+                Connection connection;
+                connection.messenger.setExecutor(std::make_shared<ThreadPoolExecutor>(2));
+
+                std::mutex mutex;
+                std::vector<std::thread::id> threads;
+                std::vector<std::shared_ptr<Add>> sent;
+                for (int i = 0; i < 100; ++i)
+                {
+                    std::shared_ptr<Add> add = connection.messenger.makeCommand<Add>(i, 1);
+                    add->setCallback<Add>([&, i](std::shared_ptr<Add> add) {
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            threads.push_back(std::this_thread::get_id());
+                        }
+
+                        // Passed to the exception handler, the other callbacks still run
+                        if (i == 50 || add->Result != i + 1)
+                        {
+                            throw std::runtime_error("Callback failed");
+                        }
+                    });
+                    sent.push_back(connection.messenger.send(add));
+                }
+
+                for (std::shared_ptr<Add>& add : sent)
+                {
+                    ASSERT_TRUE(add->waitFor(std::chrono::seconds(5)));
+                }
+
+                // The callbacks are handed to the executor after the waiters are woken
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (std::chrono::steady_clock::now() < deadline)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (threads.size() == 100 && connection.errors == 1)
+                    {
+                        break;
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ASSERT_EQ(threads.size(), 100u);
+                ASSERT_EQ(connection.errors, 1u);
+                for (std::thread::id thread : threads)
+                {
+                    ASSERT_NE(thread, std::this_thread::get_id());
+                }
+            }
+
+            TEST(threaded_executor, send_again_from_callback)
+            {
+                Connection connection;
+                connection.messenger.setExecutor(std::make_shared<ThreadPoolExecutor>(2));
+
+                // The callback sends its command again, then waits on another command. The second response to the
+                // first command mustn't hold up the response the callback is waiting on.
+                std::atomic<int> calls{ 0 };
+                std::atomic_bool waited{ false };
+                std::shared_ptr<Add> add = connection.messenger.makeCommand<Add>(4, 5);
+                add->setCallback<Add>([&](std::shared_ptr<Add> add) {
+                    if (calls++ == 0)
+                    {
+                        connection.messenger.send(add);
+                        std::shared_ptr<Add> other = connection.messenger.send(std::make_shared<Add>(1, 2));
+                        waited = other->waitFor(std::chrono::seconds(2)) && other->Result == 3;
+                    }
+                });
+                connection.messenger.send(add);
+
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (calls < 2 && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+
+                ASSERT_EQ(calls, 2);
+                ASSERT_TRUE(waited);
+                ASSERT_EQ(add->Result, 9);
+                ASSERT_EQ(connection.errors, 0u);
+            }
+
+            TEST(threaded_executor, periodic_callbacks_dont_overlap)
+            {
+                Connection connection;
+                connection.messenger.setExecutor(std::make_shared<ThreadPoolExecutor>(4));
+
+                // Samples arrive faster than the callback runs, the late ones are dropped rather than overlapping
+                std::atomic_bool running{ false };
+                std::atomic<size_t> overlaps{ 0 };
+                std::atomic<size_t> samples{ 0 };
+                connection.messenger.registerPeriodicCommand<ToggleLed>(1, [&](std::shared_ptr<ToggleLed>) {
+                    if (running.exchange(true))
+                    {
+                        ++overlaps;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+                    running = false;
+                    ++samples;
+                });
+
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (samples < 20 && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+                connection.messenger.unregisterPeriodicCommand<ToggleLed>();
+
+                ASSERT_GE(samples, 20u);
+                ASSERT_EQ(overlaps, 0u);
+                ASSERT_EQ(connection.errors, 0u);
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,70 @@
+#include "DeviceThread.hpp"
+
+#include "EmbMessenger/SimulatedDevice.hpp"
+
+#include <chrono>
+
+namespace emb
+{
+    namespace host
+    {
+        namespace test
+        {
+            class DeviceThread::Device : public sim::SimulatedDevice<2>
+            {
+                bool m_led = false;
+
+            public:
+                Device(shared::IBuffer* buffer, TimeFunction time) :
+                    SimulatedDevice(buffer, time, {
+                        [](Messenger& messenger) { messenger.checkCrc(); },
+                        [this](Messenger& messenger) { messenger.read(m_led); },
+                        [this](Messenger& messenger) {
+                            messenger.checkCrc();
+                            m_led = !m_led;
+                            messenger.write(m_led);
+                        },
+                        [](Messenger& messenger) {
+                            int16_t a = 0;
+                            int16_t b = 0;
+                            messenger.read(a, b);
+                            messenger.write(static_cast<int16_t>(a + b));
+                        },
+                        [](Messenger& messenger) {
+                            uint16_t milliseconds = 0;
+                            messenger.read(milliseconds);
+                            std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+                        }
+                    })
+                {
+                }
+            };
+
+            DeviceThread::DeviceThread(std::shared_ptr<shared::IBuffer> buffer) :
+                m_buffer(std::move(buffer)),
+                m_running(true)
+            {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                m_device.reset(new Device(m_buffer.get(), [start] {
+                    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                     std::chrono::steady_clock::now() - start)
+                                                     .count());
+                }));
+
+                m_thread = std::thread([this] {
+                    while (m_running)
+                    {
+                        m_device->update();
+                        std::this_thread::yield();
+                    }
+                });
+            }
+
+            DeviceThread::~DeviceThread()
+            {
+                m_running = false;
+                m_thread.join();
+            }
+        }  // namespace test
+    }  // namespace host
+}  // namespace emb
@@ -0,0 +1,24 @@
+#ifndef EMBMESSENGER_BUSADDRESS_HPP
+#define EMBMESSENGER_BUSADDRESS_HPP
+
+/**
+ * @file BusAddress.hpp
+ */
+
+#include <stdint.h>
+
+namespace emb
+{
+    namespace shared
+    {
+        /**
+         * @brief Address of the messages for every device on a bus, they don't respond to them.
+         *
+         * On a bus every message starts with the address of the device it is for, and every response with the address
+         * of the device that sent it. The address is a `uint8_t` value and is part of the CRC.
+         */
+        constexpr uint8_t kBroadcastAddress = 0xFF;
+    }  // namespace shared
+}  // namespace emb
+
+#endif  // EMBMESSENGER_BUSADDRESS_HPP
@@ -19,6 +19,7 @@ namespace emb
             // Cannot use 0x00 because of longjmp
             kExtraParameters = 0x01,
             kOutOfPeriodicCommandSlots = 0x02,
+            kDuplicateMessage = 0x03,
 
             kParameterReadError = 0x10,
             kMessageIdReadError = 0x11,
@@ -66,7 +66,7 @@ namespace emb
                     rv = 0;
                     break;
                 case emb::shared::kFloat:
-                    rv = 2;
+                    rv = 4;
                     break;
                 case emb::shared::kUint8:
                     rv = 1;
@@ -57,6 +57,18 @@ namespace emb
              */
             virtual uint8_t messages() const = 0;
 
+            /**
+             * @brief Gets the number of bytes the buffer can hold before it overflows.
+             *
+             * Used for flow control, the host won't have more bytes waiting on the device than this.
+             *
+             * @returns Capacity of the buffer, `0` if it is unbounded or unknown
+             */
+            virtual size_t capacity() const
+            {
+                return 0;
+            }
+
             /**
              * @brief Updates the internal buffer.
              */
@@ -292,6 +292,14 @@ namespace emb
              */
             bool readCrc();
 
+            /**
+             * @brief Reads the rest of the message without parsing it and checks its CRC.
+             * This will remove the rest of the message from the buffer.
+             *
+             * @returns True if the whole message was read and its CRC is valid.
+             */
+            bool skipMessage();
+
             /**
              * @brief Resets the internal CRC.
              * Useful when bytes are removed from buffer outside of this Reader.
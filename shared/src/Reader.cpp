@@ -490,6 +490,22 @@ namespace emb
             return false;
         }
 
+        bool Reader::skipMessage()
+        {
+            // The CRC byte is last, over the whole message including it the CRC comes to 0
+            uint8_t messages = m_buffer->messages();
+            uint8_t byte;
+            while (messages > 0 && m_buffer->messages() == messages)
+            {
+                if (!readByte(byte))
+                {
+                    return false;
+                }
+            }
+
+            return messages > 0 && m_crc == 0x00;
+        }
+
         void Reader::resetCrc()
         {
             m_crc = 0;
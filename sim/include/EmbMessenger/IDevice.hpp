@@ -0,0 +1,45 @@
+#ifndef EMBMESSENGER_IDEVICE_HPP
+#define EMBMESSENGER_IDEVICE_HPP
+
+#include "EmbMessenger/IBuffer.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace emb
+{
+    namespace sim
+    {
+        /**
+         * @brief Interface for a device running in the Simulator.
+         *
+         * The host and the device both have an `EmbMessenger/EmbMessenger.hpp`, so devices are defined in their own
+         * translation units, see SimulatedDevice, and only reach the Simulator through this interface.
+         */
+        class IDevice
+        {
+        public:
+            /**
+             * @brief Function giving the device's time in milliseconds, like `millis()`.
+             */
+            using TimeFunction = std::function<uint32_t()>;
+
+            virtual ~IDevice() = default;
+
+            /**
+             * @brief Runs one iteration of the device's loop.
+             */
+            virtual void update() = 0;
+        };
+
+        /**
+         * @brief Function that creates a device.
+         *
+         * The buffer is the device's end of its link and outlives the device, the time function follows the simulation.
+         */
+        using DeviceFactory = std::function<std::unique_ptr<IDevice>(shared::IBuffer*, IDevice::TimeFunction)>;
+    }  // namespace sim
+}  // namespace emb
+
+#endif  // EMBMESSENGER_IDEVICE_HPP
@@ -0,0 +1,93 @@
+#ifndef EMBMESSENGER_SIMULATEDDEVICE_HPP
+#define EMBMESSENGER_SIMULATEDDEVICE_HPP
+
+#ifndef EMB_TESTING
+#error "SimulatedDevice needs the device's EmbMessenger built with EMB_TESTING, link EmbMessengerSimulatorDevice"
+#endif
+
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "EmbMessenger/IDevice.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace emb
+{
+    namespace sim
+    {
+        /**
+         * @brief A device's EmbMessenger and its command table, running in the Simulator.
+         *
+         * Only include this in the translation units that define devices, it includes the device's EmbMessenger.
+         *
+         * @tparam MaxPeriodicCommands The maximum number of periodic commands, see `device::EmbMessenger`
+         * @tparam RecentMessages The number of message IDs to remember, see `device::EmbMessenger`
+         */
+        template <uint8_t MaxPeriodicCommands = 0, uint8_t RecentMessages = 0>
+        class SimulatedDevice : public IDevice
+        {
+        public:
+            using Messenger = device::EmbMessenger<MaxPeriodicCommands, RecentMessages>;
+
+            /**
+             * @brief A command, it gets the device's messenger to read its parameters and write its response.
+             */
+            using Command = std::function<void(Messenger&)>;
+
+        private:
+            std::vector<typename Messenger::CommandFunction> m_commands;
+            Messenger m_messenger;
+
+            std::vector<typename Messenger::CommandFunction> wrap(std::vector<Command> commands)
+            {
+                std::vector<typename Messenger::CommandFunction> wrapped(commands.size());
+                for (size_t i = 0; i < commands.size(); ++i)
+                {
+                    // Empty commands stay null, so the messenger reports them as invalid
+                    if (commands[i])
+                    {
+                        wrapped[i] = [this, command = std::move(commands[i])] { command(m_messenger); };
+                    }
+                }
+                return wrapped;
+            }
+
+        public:
+            /**
+             * @brief Construct a new Simulated Device.
+             *
+             * @param buffer The device's end of its link
+             * @param time The device's time, from the DeviceFactory
+             * @param commands The command table, indexed by command ID
+             */
+            SimulatedDevice(shared::IBuffer* buffer, TimeFunction time, std::vector<Command> commands) :
+                m_commands(wrap(std::move(commands))),
+                m_messenger(buffer, m_commands.data(), static_cast<uint16_t>(m_commands.size()), std::move(time))
+            {
+            }
+
+            SimulatedDevice(const SimulatedDevice&) = delete;
+            SimulatedDevice& operator=(const SimulatedDevice&) = delete;
+
+            virtual void update() override
+            {
+                m_messenger.update();
+            }
+
+            /**
+             * @brief Gets the device's messenger.
+             *
+             * @return The messenger
+             */
+            Messenger& messenger()
+            {
+                return m_messenger;
+            }
+        };
+    }  // namespace sim
+}  // namespace emb
+
+#endif  // EMBMESSENGER_SIMULATEDDEVICE_HPP
@@ -0,0 +1,230 @@
+#ifndef EMBMESSENGER_SIMULATOR_HPP
+#define EMBMESSENGER_SIMULATOR_HPP
+
+#include "EmbMessenger/BusEmulator.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+#include "EmbMessenger/IClock.hpp"
+#include "EmbMessenger/IDevice.hpp"
+#include "EmbMessenger/LinkEmulator.hpp"
+#include "EmbMessenger/TimerWheel.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace emb
+{
+    namespace sim
+    {
+        /**
+         * @brief How a device in the Simulator is connected and how often it runs.
+         */
+        struct DeviceOptions
+        {
+            host::LinkOptions host_to_device;  /// The link from the host to the device
+            host::LinkOptions device_to_host;  /// The link from the device to the host
+
+            /// Time between the device's updates, like the period of its main loop
+            std::chrono::nanoseconds update_period{ std::chrono::microseconds(100) };
+        };
+
+        /**
+         * @brief Runs many devices on a shared virtual clock.
+         *
+         * Every device has its own emulated link, or shares an emulated bus with other devices, and runs its update
+         * every update period. Tasks are functions run
+         * the same way, for example the updates of Single Threaded hosts. The updates are discrete events, running
+         * the simulation jumps from one to the next, so it runs as fast as the devices can be computed and the same
+         * way every time.
+         *
+         * The Simulator isn't thread safe, run it from one thread. Hosts can use the buffers from other threads.
+         */
+        class Simulator
+        {
+            struct Process
+            {
+                std::function<void()> run;
+                std::chrono::nanoseconds period;
+                uint64_t updates;
+            };
+
+            struct Device
+            {
+                std::unique_ptr<host::LinkEmulator> link;  // Null for devices on a bus
+                std::shared_ptr<shared::IBuffer> drop;     // The device's end of its bus
+                std::unique_ptr<IDevice> device;
+                std::shared_ptr<shared::IBuffer> host;
+                uint32_t process;
+            };
+
+            struct Bus
+            {
+                std::unique_ptr<host::BusEmulator> emulator;
+                std::shared_ptr<shared::IBuffer> host;
+            };
+
+            class HostEnd;
+
+            std::shared_ptr<host::VirtualClock> m_clock;
+            host::TimerWheel m_events;
+            std::chrono::nanoseconds m_resolution;
+            std::vector<Process> m_processes;
+            std::vector<Device> m_devices;
+            std::vector<Bus> m_buses;
+            bool m_running;
+            bool m_advance_on_idle;
+
+            uint32_t addProcess(std::function<void()> run, std::chrono::nanoseconds period);
+            size_t addDevice(Device device, shared::IBuffer* buffer, const DeviceFactory& factory,
+                             std::chrono::nanoseconds update_period);
+
+        public:
+            /**
+             * @brief Construct a new Simulator.
+             *
+             * @param capacity Maximum number of devices and tasks
+             * @param resolution Events are rounded up to a multiple of this
+             * @param clock The virtual clock, links and devices use its time
+             */
+            explicit Simulator(size_t capacity, std::chrono::nanoseconds resolution = std::chrono::microseconds(10),
+                               std::shared_ptr<host::VirtualClock> clock = std::make_shared<host::VirtualClock>());
+
+            Simulator(const Simulator&) = delete;
+            Simulator& operator=(const Simulator&) = delete;
+
+            /**
+             * @brief Adds a device, its first update is one update period from now.
+             *
+             * @param factory Creates the device
+             * @param options The device's link and update period
+             * @return Index of the device
+             */
+            size_t addDevice(const DeviceFactory& factory, const DeviceOptions& options = DeviceOptions());
+
+            /**
+             * @brief Adds a bus shared by many devices, like RS-485.
+             *
+             * @param host_to_devices How the bytes written by the host travel
+             * @param devices_to_host How the bytes written by the devices travel
+             * @return Index of the bus
+             */
+            size_t addBus(const host::LinkOptions& host_to_devices = host::LinkOptions(),
+                          const host::LinkOptions& devices_to_host = host::LinkOptions());
+
+            /**
+             * @brief Adds a device on a bus, its first update is one update period from now.
+             *
+             * The factory gives the device its address, see `device::EmbMessenger::setAddress`.
+             *
+             * @param bus Index of the bus
+             * @param factory Creates the device
+             * @param update_period Time between the device's updates
+             * @return Index of the device
+             */
+            size_t addBusDevice(size_t bus, const DeviceFactory& factory,
+                                std::chrono::nanoseconds update_period = std::chrono::microseconds(100));
+
+            /**
+             * @brief Adds a function to run periodically, its first run is one period from now.
+             *
+             * @param task The function
+             * @param period Time between runs
+             */
+            void addTask(std::function<void()> task, std::chrono::nanoseconds period);
+
+            /**
+             * @brief Gets the host's end of a device's link or bus.
+             *
+             * @param device Index of the device
+             * @return Buffer for the host's EmbMessenger, or for a BusRouter if the device is on a bus
+             */
+            std::shared_ptr<shared::IBuffer> host(size_t device) const;
+
+            /**
+             * @brief Gets a device's link, for its counters.
+             *
+             * @param device Index of the device
+             * @return The device's link
+             * @throws std::logic_error If the device is on a bus
+             */
+            const host::LinkEmulator& link(size_t device) const;
+
+            /**
+             * @brief Gets the host's end of a bus.
+             *
+             * @param bus Index of the bus
+             * @return Buffer for a BusRouter
+             */
+            std::shared_ptr<shared::IBuffer> busHost(size_t bus) const;
+
+            /**
+             * @brief Gets a bus, for its counters.
+             *
+             * @param bus Index of the bus
+             * @return The bus
+             */
+            const host::BusEmulator& bus(size_t bus) const;
+
+            /**
+             * @brief Gets the number of times a device has run its update.
+             *
+             * @param device Index of the device
+             * @return Number of updates
+             */
+            uint64_t updates(size_t device) const;
+
+            /**
+             * @brief Gets the number of devices.
+             *
+             * @return Number of devices added
+             */
+            size_t devices() const;
+
+            /**
+             * @brief Gets the virtual clock.
+             *
+             * @return The clock
+             */
+            std::shared_ptr<host::VirtualClock> clock() const;
+
+            /**
+             * @brief Gets the current virtual time.
+             *
+             * @return Time since the clock's epoch
+             */
+            std::chrono::nanoseconds now() const;
+
+            /**
+             * @brief Runs every event up to @p time, then moves the clock to @p time.
+             *
+             * @param time Virtual time to run to
+             * @return Number of device updates and task runs
+             */
+            size_t runUntil(std::chrono::nanoseconds time);
+
+            /**
+             * @brief Runs the simulation for @p duration of virtual time.
+             *
+             * @param duration Virtual time to run for
+             * @return Number of device updates and task runs
+             */
+            size_t runFor(std::chrono::nanoseconds duration);
+
+            /**
+             * @brief Lets the hosts drive the simulation.
+             *
+             * When enabled, updating a host's buffer while it doesn't have a whole message runs the simulation forward
+             * by the resolution. Single Threaded hosts wait for their responses by calling update, this way they can
+             * be used without tasks, including their constructor. Don't enable it with Multi Threaded hosts.
+             *
+             * @param enable True to advance on idle host updates
+             */
+            void setAdvanceOnIdle(bool enable);
+        };
+    }  // namespace sim
+}  // namespace emb
+
+#endif  // EMBMESSENGER_SIMULATOR_HPP
@@ -0,0 +1,256 @@
+#include "EmbMessenger/Simulator.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace emb
+{
+    namespace sim
+    {
+        namespace
+        {
+            host::TimerWheel::clock_t::time_point toTimePoint(std::chrono::nanoseconds time)
+            {
+                return host::TimerWheel::clock_t::time_point(
+                    std::chrono::duration_cast<host::TimerWheel::clock_t::duration>(time));
+            }
+
+            std::chrono::nanoseconds fromTimePoint(host::TimerWheel::clock_t::time_point time)
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+            }
+        }  // namespace
+
+        // The host's end of a link, it can run the simulation while the host waits
+        class Simulator::HostEnd : public shared::IBuffer
+        {
+            Simulator& m_simulator;
+            std::shared_ptr<shared::IBuffer> m_end;
+
+        public:
+            HostEnd(Simulator& simulator, std::shared_ptr<shared::IBuffer> end) :
+                m_simulator(simulator),
+                m_end(std::move(end))
+            {
+            }
+
+            virtual void writeByte(const uint8_t byte) override
+            {
+                m_end->writeByte(byte);
+            }
+
+            virtual uint8_t peek() const override
+            {
+                return m_end->peek();
+            }
+
+            virtual uint8_t readByte() override
+            {
+                return m_end->readByte();
+            }
+
+            virtual bool empty() const override
+            {
+                return m_end->empty();
+            }
+
+            virtual size_t size() const override
+            {
+                return m_end->size();
+            }
+
+            virtual uint8_t messages() const override
+            {
+                return m_end->messages();
+            }
+
+            virtual void update() override
+            {
+                m_end->update();
+
+                // Tasks may update hosts themselves, the simulation doesn't run inside itself
+                if (m_simulator.m_advance_on_idle && !m_simulator.m_running && m_end->messages() == 0)
+                {
+                    m_simulator.runFor(m_simulator.m_resolution);
+                    m_end->update();
+                }
+            }
+
+            virtual void zero() override
+            {
+                m_end->zero();
+            }
+        };
+
+        Simulator::Simulator(size_t capacity, std::chrono::nanoseconds resolution,
+                             std::shared_ptr<host::VirtualClock> clock) :
+            m_clock(std::move(clock)),
+            m_events(capacity, std::chrono::duration_cast<host::TimerWheel::clock_t::duration>(resolution),
+                     toTimePoint(m_clock->now())),
+            m_resolution(resolution),
+            m_running(false),
+            m_advance_on_idle(false)
+        {
+            m_processes.reserve(capacity);
+        }
+
+        uint32_t Simulator::addProcess(std::function<void()> run, std::chrono::nanoseconds period)
+        {
+            if (m_processes.size() == m_events.capacity())
+            {
+                throw std::length_error("Simulator is full");
+            }
+
+            if (period <= std::chrono::nanoseconds::zero())
+            {
+                throw std::invalid_argument("Simulator update period must be positive");
+            }
+
+            uint32_t process = static_cast<uint32_t>(m_processes.size());
+            m_processes.push_back({ std::move(run), period, 0 });
+            m_events.schedule(process, toTimePoint(now() + period));
+            return process;
+        }
+
+        size_t Simulator::addDevice(Device device, shared::IBuffer* buffer, const DeviceFactory& factory,
+                                    std::chrono::nanoseconds update_period)
+        {
+            std::shared_ptr<host::VirtualClock> clock = m_clock;
+            device.device = factory(buffer, [clock] {
+                return static_cast<uint32_t>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(clock->now()).count());
+            });
+
+            IDevice* instance = device.device.get();
+            device.process = addProcess([instance] { instance->update(); }, update_period);
+
+            m_devices.push_back(std::move(device));
+            return m_devices.size() - 1;
+        }
+
+        size_t Simulator::addDevice(const DeviceFactory& factory, const DeviceOptions& options)
+        {
+            Device device;
+            device.link.reset(new host::LinkEmulator(options.host_to_device, options.device_to_host, m_clock));
+            device.host = std::make_shared<HostEnd>(*this, device.link->host());
+
+            shared::IBuffer* buffer = device.link->device().get();
+            return addDevice(std::move(device), buffer, factory, options.update_period);
+        }
+
+        size_t Simulator::addBus(const host::LinkOptions& host_to_devices, const host::LinkOptions& devices_to_host)
+        {
+            Bus bus;
+            bus.emulator.reset(new host::BusEmulator(host_to_devices, devices_to_host, m_clock));
+            bus.host = std::make_shared<HostEnd>(*this, bus.emulator->host());
+
+            m_buses.push_back(std::move(bus));
+            return m_buses.size() - 1;
+        }
+
+        size_t Simulator::addBusDevice(size_t bus, const DeviceFactory& factory, std::chrono::nanoseconds update_period)
+        {
+            Device device;
+            device.host = m_buses.at(bus).host;
+            device.drop = m_buses.at(bus).emulator->addDevice();
+
+            shared::IBuffer* buffer = device.drop.get();
+            return addDevice(std::move(device), buffer, factory, update_period);
+        }
+
+        void Simulator::addTask(std::function<void()> task, std::chrono::nanoseconds period)
+        {
+            addProcess(std::move(task), period);
+        }
+
+        std::shared_ptr<shared::IBuffer> Simulator::host(size_t device) const
+        {
+            return m_devices.at(device).host;
+        }
+
+        const host::LinkEmulator& Simulator::link(size_t device) const
+        {
+            const Device& instance = m_devices.at(device);
+            if (!instance.link)
+            {
+                throw std::logic_error("The device is on a bus, it has no link of its own");
+            }
+            return *instance.link;
+        }
+
+        std::shared_ptr<shared::IBuffer> Simulator::busHost(size_t bus) const
+        {
+            return m_buses.at(bus).host;
+        }
+
+        const host::BusEmulator& Simulator::bus(size_t bus) const
+        {
+            return *m_buses.at(bus).emulator;
+        }
+
+        uint64_t Simulator::updates(size_t device) const
+        {
+            return m_processes[m_devices.at(device).process].updates;
+        }
+
+        size_t Simulator::devices() const
+        {
+            return m_devices.size();
+        }
+
+        std::shared_ptr<host::VirtualClock> Simulator::clock() const
+        {
+            return m_clock;
+        }
+
+        std::chrono::nanoseconds Simulator::now() const
+        {
+            return m_clock->now();
+        }
+
+        size_t Simulator::runUntil(std::chrono::nanoseconds time)
+        {
+            if (m_running)
+            {
+                throw std::logic_error("Simulator can't run from inside a device or task");
+            }
+
+            m_running = true;
+            size_t count = 0;
+            try
+            {
+                count = m_events.advance(toTimePoint(time), [this](uint32_t index) {
+                    m_clock->set(fromTimePoint(m_events.time()));
+
+                    // Rescheduled first, so a throwing device keeps running
+                    Process& process = m_processes[index];
+                    m_events.schedule(index, m_events.time() + process.period);
+                    ++process.updates;
+                    process.run();
+                });
+            }
+            catch (...)
+            {
+                m_running = false;
+                throw;
+            }
+            m_running = false;
+
+            if (time > m_clock->now())
+            {
+                m_clock->set(time);
+            }
+            return count;
+        }
+
+        size_t Simulator::runFor(std::chrono::nanoseconds duration)
+        {
+            return runUntil(now() + duration);
+        }
+
+        void Simulator::setAdvanceOnIdle(bool enable)
+        {
+            m_advance_on_idle = enable;
+        }
+    }  // namespace sim
+}  // namespace emb
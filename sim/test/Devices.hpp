@@ -0,0 +1,35 @@
+#ifndef EMBMESSENGER_SIM_TEST_DEVICES_HPP
+#define EMBMESSENGER_SIM_TEST_DEVICES_HPP
+
+#include "EmbMessenger/IDevice.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace emb
+{
+    namespace sim
+    {
+        namespace test
+        {
+            constexpr uint16_t kPing = 0;
+            constexpr uint16_t kAdd = 1;
+            constexpr uint16_t kMillis = 2;
+            constexpr uint16_t kStore = 3;
+            constexpr uint16_t kLoad = 4;
+
+            /**
+             * Device with the commands Ping, Add that responds with the sum of two `int16_t`, Millis that responds
+             * with its time, Store that keeps an `int16_t` and Load that responds with it.
+             */
+            std::unique_ptr<IDevice> makeCalculator(shared::IBuffer* buffer, IDevice::TimeFunction time);
+
+            /**
+             * Calculator on a bus with the @p address.
+             */
+            DeviceFactory makeBusCalculator(uint8_t address);
+        }  // namespace test
+    }  // namespace sim
+}  // namespace emb
+
+#endif  // EMBMESSENGER_SIM_TEST_DEVICES_HPP
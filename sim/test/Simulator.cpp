@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "EmbMessenger/BusRouter.hpp"
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "EmbMessenger/Simulator.hpp"
+
+#include "Devices.hpp"
+
+namespace emb
+{
+    namespace sim
+    {
+        namespace test
+        {
+            using std::chrono::microseconds;
+            using std::chrono::milliseconds;
+
+            namespace
+            {
+                class Add : public host::Command
+                {
+                    int16_t m_a;
+                    int16_t m_b;
+
+                public:
+                    int16_t sum = 0;
+
+                    Add(int16_t a, int16_t b) : m_a(a), m_b(b)
+                    {
+                    }
+
+                    void send(host::EmbMessenger* messenger) override
+                    {
+                        messenger->write(m_a, m_b);
+                    }
+
+                    void receive(host::EmbMessenger* messenger) override
+                    {
+                        messenger->read(sum);
+                    }
+                };
+
+                class Store : public host::Command
+                {
+                    int16_t m_value;
+
+                public:
+                    explicit Store(int16_t value) : m_value(value)
+                    {
+                    }
+
+                    void send(host::EmbMessenger* messenger) override
+                    {
+                        messenger->write(m_value);
+                    }
+                };
+
+                class Load : public host::Command
+                {
+                public:
+                    int16_t value = 0;
+
+                    void receive(host::EmbMessenger* messenger) override
+                    {
+                        messenger->read(value);
+                    }
+                };
+
+                class Millis : public host::Command
+                {
+                public:
+                    uint32_t time = 0;
+
+                    void receive(host::EmbMessenger* messenger) override
+                    {
+                        messenger->read(time);
+                    }
+                };
+            }  // namespace
+
+            TEST(simulator, schedules_updates)
+            {
+                Simulator simulator(3);
+                DeviceOptions fast;
+                fast.update_period = microseconds(100);
+                DeviceOptions slow;
+                slow.update_period = microseconds(250);
+
+                ASSERT_EQ(simulator.addDevice(makeCalculator, fast), 0u);
+                ASSERT_EQ(simulator.addDevice(makeCalculator, slow), 1u);
+
+                std::vector<std::chrono::nanoseconds> runs;
+                simulator.addTask([&] { runs.push_back(simulator.now()); }, milliseconds(1));
+                ASSERT_THROW(simulator.addTask([] {}, milliseconds(1)), std::length_error);
+
+                ASSERT_EQ(simulator.runFor(milliseconds(2)), 20u + 8u + 2u);
+                ASSERT_EQ(simulator.now(), milliseconds(2));
+                ASSERT_EQ(simulator.updates(0), 20u);
+                ASSERT_EQ(simulator.updates(1), 8u);
+                ASSERT_EQ(runs, std::vector<std::chrono::nanoseconds>({ milliseconds(1), milliseconds(2) }));
+
+                // Nothing is due in between
+                ASSERT_EQ(simulator.runUntil(milliseconds(2) + microseconds(50)), 0u);
+                ASSERT_EQ(simulator.now(), milliseconds(2) + microseconds(50));
+            }
+
+            TEST(simulator, host_round_trip)
+            {
+                Simulator simulator(1);
+                DeviceOptions options;
+                options.host_to_device.bytes_per_second = 11520;
+                options.host_to_device.latency = milliseconds(1);
+                options.device_to_host = options.host_to_device;
+                simulator.addDevice(makeCalculator, options);
+                simulator.setAdvanceOnIdle(true);
+
+                host::EmbMessenger messenger(simulator.host(0));
+                messenger.registerCommand<Add>(kAdd);
+
+                std::chrono::nanoseconds sent = simulator.now();
+                std::shared_ptr<Add> add = messenger.send(std::make_shared<Add>(int16_t(40), int16_t(2)));
+                while (add->getCommandState() != host::CommandState::Received)
+                {
+                    messenger.update();
+                }
+
+                ASSERT_EQ(add->sum, 42);
+                ASSERT_GT(simulator.now() - sent, milliseconds(2));
+                ASSERT_LT(simulator.now() - sent, milliseconds(5));
+                ASSERT_EQ(simulator.link(0).hostToDevice().dropped, 0u);
+            }
+
+            TEST(simulator, periodic_commands)
+            {
+                Simulator simulator(2);
+                simulator.addDevice(makeCalculator);
+                simulator.setAdvanceOnIdle(true);
+
+                host::EmbMessenger messenger(simulator.host(0));
+                messenger.registerCommand<Millis>(kMillis);
+
+                std::vector<uint32_t> times;
+                messenger.registerPeriodicCommand<Millis>(10, [&](std::shared_ptr<Millis> millis) {
+                    times.push_back(millis->time);
+                });
+
+                // The host runs as a task from here on
+                simulator.setAdvanceOnIdle(false);
+                simulator.addTask([&] { messenger.updateAll(); }, microseconds(100));
+                simulator.runFor(std::chrono::seconds(1));
+
+                ASSERT_GE(times.size(), 99u);
+                for (size_t i = 1; i < times.size(); ++i)
+                {
+                    ASSERT_EQ(times[i] - times[i - 1], 10u);
+                }
+            }
+
+            TEST(simulator, shared_bus)
+            {
+                Simulator simulator(3);
+                host::LinkOptions options;
+                options.bytes_per_second = 11520;
+                simulator.addBus(options, options);
+
+                const uint8_t addresses[] = { 0x01, 0x02, 0x90 };
+                for (uint8_t address : addresses)
+                {
+                    simulator.addBusDevice(0, makeBusCalculator(address));
+                }
+                simulator.setAdvanceOnIdle(true);
+
+                host::BusRouter router(simulator.busHost(0));
+                std::vector<std::unique_ptr<host::EmbMessenger>> messengers;
+                for (uint8_t address : addresses)
+                {
+                    messengers.emplace_back(new host::EmbMessenger(router.endpoint(address)));
+                    messengers.back()->registerCommand<Add>(kAdd);
+                    messengers.back()->registerCommand<Store>(kStore);
+                    messengers.back()->registerCommand<Load>(kLoad);
+                }
+
+                auto updateUntil = [&](const std::vector<std::shared_ptr<host::Command>>& commands) {
+                    for (const std::shared_ptr<host::Command>& command : commands)
+                    {
+                        while (command->getCommandState() != host::CommandState::Received)
+                        {
+                            for (std::unique_ptr<host::EmbMessenger>& messenger : messengers)
+                            {
+                                messenger->update();
+                            }
+                        }
+                    }
+                };
+
+                // Every device only answers its own messages
+                std::vector<std::shared_ptr<Add>> adds;
+                for (size_t i = 0; i < messengers.size(); ++i)
+                {
+                    adds.push_back(messengers[i]->send(std::make_shared<Add>(int16_t(i), int16_t(10))));
+                }
+                updateUntil({ adds.begin(), adds.end() });
+                for (size_t i = 0; i < adds.size(); ++i)
+                {
+                    ASSERT_EQ(adds[i]->sum, int16_t(i + 10));
+                }
+
+                // A broadcast reaches every device without any responses
+                messengers[0]->broadcast(std::make_shared<Store>(int16_t(42)));
+                std::vector<std::shared_ptr<Load>> loads;
+                for (std::unique_ptr<host::EmbMessenger>& messenger : messengers)
+                {
+                    loads.push_back(messenger->send(std::make_shared<Load>()));
+                }
+                updateUntil({ loads.begin(), loads.end() });
+                for (std::shared_ptr<Load>& load : loads)
+                {
+                    ASSERT_EQ(load->value, 42);
+                }
+
+                ASSERT_EQ(router.unrouted(), 0u);
+                ASSERT_THROW(simulator.link(0), std::logic_error);
+                ASSERT_EQ(simulator.host(1), simulator.busHost(0));
+            }
+        }  // namespace test
+    }  // namespace sim
+}  // namespace emb
@@ -0,0 +1,52 @@
+#include "Devices.hpp"
+
+#include "EmbMessenger/SimulatedDevice.hpp"
+
+namespace emb
+{
+    namespace sim
+    {
+        namespace test
+        {
+            namespace
+            {
+                using Calculator = SimulatedDevice<2>;
+
+                std::unique_ptr<Calculator> makeDevice(shared::IBuffer* buffer, IDevice::TimeFunction time)
+                {
+                    std::shared_ptr<int16_t> memory = std::make_shared<int16_t>(0);
+
+                    return std::unique_ptr<Calculator>(new Calculator(buffer, time, {
+                        [](Calculator::Messenger& messenger) { messenger.checkCrc(); },
+                        [](Calculator::Messenger& messenger) {
+                            int16_t a = 0;
+                            int16_t b = 0;
+                            messenger.read(a, b);
+                            messenger.write(static_cast<int16_t>(a + b));
+                        },
+                        [time](Calculator::Messenger& messenger) { messenger.write(time()); },
+                        [memory](Calculator::Messenger& messenger) { messenger.read(*memory); },
+                        [memory](Calculator::Messenger& messenger) {
+                            messenger.checkCrc();
+                            messenger.write(*memory);
+                        }
+                    }));
+                }
+            }  // namespace
+
+            std::unique_ptr<IDevice> makeCalculator(shared::IBuffer* buffer, IDevice::TimeFunction time)
+            {
+                return makeDevice(buffer, time);
+            }
+
+            DeviceFactory makeBusCalculator(uint8_t address)
+            {
+                return [address](shared::IBuffer* buffer, IDevice::TimeFunction time) {
+                    std::unique_ptr<Calculator> device = makeDevice(buffer, time);
+                    device->messenger().setAddress(address);
+                    return std::unique_ptr<IDevice>(std::move(device));
+                };
+            }
+        }  // namespace test
+    }  // namespace sim
+}  // namespace emb
@@ -0,0 +1,191 @@
+// Decodes a capture written by CaptureBuffer into text or CSV.
+//
+// Usage: emb-decode [--csv] [--addressed] <capture file | ->
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/ProtocolLog.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using emb::host::CaptureDirection;
+    using emb::host::ProtocolEvent;
+    using emb::host::ProtocolEventType;
+
+    const char* eventName(ProtocolEventType type)
+    {
+        switch (type)
+        {
+            case ProtocolEventType::Address:
+                return "Address";
+            case ProtocolEventType::Message:
+                return "Message";
+            case ProtocolEventType::Command:
+                return "Command";
+            case ProtocolEventType::Value:
+                return "Value";
+            case ProtocolEventType::Error:
+                return "Error";
+            case ProtocolEventType::EndOfMessage:
+                return "EndOfMessage";
+            case ProtocolEventType::Unknown:
+                return "Unknown";
+            case ProtocolEventType::Truncated:
+                return "Truncated";
+            default:
+                return "Malformed";
+        }
+    }
+
+    // The value column of an event, the data column is only used by errors
+    std::string csvValue(const ProtocolEvent& event)
+    {
+        switch (event.type)
+        {
+            case ProtocolEventType::Address:
+            case ProtocolEventType::Command:
+            case ProtocolEventType::Error:
+                return std::to_string(event.unsigned_value);
+            case ProtocolEventType::EndOfMessage:
+                return event.crc_valid ? "Valid" : "Invalid";
+            case ProtocolEventType::Unknown:
+                return std::to_string(static_cast<unsigned>(event.data_type));
+            case ProtocolEventType::Value:
+                break;
+            default:
+                return "";
+        }
+
+        switch (event.data_type)
+        {
+            case emb::shared::kNull:
+                return "";
+            case emb::shared::kBoolFalse:
+            case emb::shared::kBoolTrue:
+                return event.unsigned_value ? "True" : "False";
+            case emb::shared::kFloat:
+                return std::to_string(event.float_value);
+            case emb::shared::kPosFixInt:
+            case emb::shared::kUint8:
+            case emb::shared::kUint16:
+            case emb::shared::kUint32:
+            case emb::shared::kUint64:
+                return std::to_string(event.unsigned_value);
+            default:
+                return std::to_string(event.signed_value);
+        }
+    }
+
+    void printCsv(const std::vector<ProtocolEvent>& events)
+    {
+        std::cout << "time_ns,direction,message_id,event,index,type,value,data\n";
+        for (const ProtocolEvent& event : events)
+        {
+            bool parameter = event.type == ProtocolEventType::Value || event.type == ProtocolEventType::Error ||
+                             event.type == ProtocolEventType::Unknown || event.type == ProtocolEventType::Truncated;
+
+            std::cout << event.time.count() << ","
+                      << (event.direction == CaptureDirection::HostToDevice ? "host" : "device") << ","
+                      << event.message_id << "," << eventName(event.type) << ","
+                      << (parameter ? std::to_string(event.index) : "") << ","
+                      << (event.type == ProtocolEventType::Value ? emb::host::dataTypeName(event.data_type) : "")
+                      << "," << csvValue(event) << ","
+                      << (event.type == ProtocolEventType::Error ? std::to_string(event.signed_value) : "") << "\n";
+        }
+    }
+
+    void printText(const std::vector<ProtocolEvent>& events)
+    {
+        char time[32];
+        for (const ProtocolEvent& event : events)
+        {
+            std::snprintf(time, sizeof(time), "[%14.6f] ", event.time.count() / 1e9);
+            std::cout << time << emb::host::formatEvent(event) << "\n";
+        }
+    }
+
+    void printUsage(const char* name)
+    {
+        std::cerr << "Usage: " << name << " [--csv] [--addressed] <capture file | ->\n"
+                  << "Decodes a capture written by CaptureBuffer, from stdin if the file is -\n"
+                  << "  --addressed  The messages start with a bus address, even if the capture doesn't say so\n";
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bool csv = false;
+    bool addressed = false;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+        else if (std::strcmp(argv[i], "--addressed") == 0)
+        {
+            addressed = true;
+        }
+        else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0 || path != nullptr)
+        {
+            printUsage(argv[0]);
+            return 2;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    if (path == nullptr)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        // Captures of a bus say so in their header
+        std::vector<emb::host::CaptureRecord> records;
+        bool header_addressed = false;
+        if (std::strcmp(path, "-") == 0)
+        {
+            records = emb::host::readCapture(std::cin, header_addressed);
+        }
+        else
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open())
+            {
+                throw std::runtime_error(std::string("Unable to open capture file ") + path);
+            }
+            records = emb::host::readCapture(file, header_addressed);
+        }
+
+        std::vector<ProtocolEvent> events = emb::host::decodeLog(records, addressed || header_addressed);
+        if (csv)
+        {
+            printCsv(events);
+        }
+        else
+        {
+            printText(events);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef EMBMESSENGER_LOADGEN_EXAMPLEDEVICE_HPP
+#define EMBMESSENGER_LOADGEN_EXAMPLEDEVICE_HPP
+
+#include "EmbMessenger/IDevice.hpp"
+
+#include <memory>
+
+namespace emb
+{
+    namespace loadgen
+    {
+        /**
+         * @brief Creates a simulated copy of the example device, `examples/device/device.ino`.
+         *
+         * Its commands are Ping, SetLed, ToggleLed, Add and DelayMs. DelayMs doesn't block, the simulated device has
+         * no time to lose.
+         */
+        std::unique_ptr<sim::IDevice> makeExampleDevice(shared::IBuffer* buffer, sim::IDevice::TimeFunction time);
+    }  // namespace loadgen
+}  // namespace emb
+
+#endif  // EMBMESSENGER_LOADGEN_EXAMPLEDEVICE_HPP
@@ -0,0 +1,202 @@
+#include "SerialPort.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace emb
+{
+    namespace loadgen
+    {
+        namespace
+        {
+            speed_t toSpeed(uint32_t baud)
+            {
+                switch (baud)
+                {
+                    case 9600:
+                        return B9600;
+                    case 19200:
+                        return B19200;
+                    case 38400:
+                        return B38400;
+                    case 57600:
+                        return B57600;
+                    case 115200:
+                        return B115200;
+                    case 230400:
+                        return B230400;
+#ifdef B460800
+                    case 460800:
+                        return B460800;
+#endif
+#ifdef B921600
+                    case 921600:
+                        return B921600;
+#endif
+                    default:
+                        throw std::runtime_error("Unsupported baud rate " + std::to_string(baud));
+                }
+            }
+
+            std::runtime_error systemError(const std::string& what)
+            {
+                return std::runtime_error(what + ": " + std::strerror(errno));
+            }
+        }  // namespace
+
+        SerialPort::SerialPort(const std::string& path, uint32_t baud) : m_messages(0)
+        {
+            m_fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+            if (m_fd < 0)
+            {
+                throw systemError("Unable to open " + path);
+            }
+
+            termios options;
+            if (tcgetattr(m_fd, &options) != 0)
+            {
+                int error = errno;
+                ::close(m_fd);
+                errno = error;
+                throw systemError("Unable to configure " + path);
+            }
+
+            cfmakeraw(&options);
+            options.c_cflag |= CLOCAL | CREAD;
+            try
+            {
+                if (baud != 0)
+                {
+                    cfsetispeed(&options, toSpeed(baud));
+                    cfsetospeed(&options, toSpeed(baud));
+                }
+            }
+            catch (...)
+            {
+                ::close(m_fd);
+                throw;
+            }
+
+            if (tcsetattr(m_fd, TCSANOW, &options) != 0)
+            {
+                int error = errno;
+                ::close(m_fd);
+                errno = error;
+                throw systemError("Unable to configure " + path);
+            }
+            tcflush(m_fd, TCIOFLUSH);
+        }
+
+        SerialPort::~SerialPort()
+        {
+            ::close(m_fd);
+        }
+
+        void SerialPort::flush()
+        {
+            size_t written = 0;
+            while (written < m_write_buffer.size())
+            {
+                ssize_t count = ::write(m_fd, m_write_buffer.data() + written, m_write_buffer.size() - written);
+                if (count > 0)
+                {
+                    written += static_cast<size_t>(count);
+                }
+                else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    pollfd writable = { m_fd, POLLOUT, 0 };
+                    ::poll(&writable, 1, 100);
+                }
+                else if (count < 0 && errno != EINTR)
+                {
+                    throw systemError("Unable to write to the serial port");
+                }
+            }
+            m_write_buffer.clear();
+        }
+
+        void SerialPort::writeByte(const uint8_t byte)
+        {
+            m_write_buffer.push_back(byte);
+            if (m_write_splitter.push(byte))
+            {
+                flush();
+            }
+        }
+
+        uint8_t SerialPort::peek() const
+        {
+            return m_received.front();
+        }
+
+        uint8_t SerialPort::readByte()
+        {
+            uint8_t byte = m_received.front();
+            m_received.pop_front();
+
+            if (m_read_splitter.push(byte) && m_messages > 0)
+            {
+                --m_messages;
+            }
+            return byte;
+        }
+
+        bool SerialPort::empty() const
+        {
+            return m_received.empty();
+        }
+
+        size_t SerialPort::size() const
+        {
+            return m_received.size();
+        }
+
+        uint8_t SerialPort::messages() const
+        {
+            return static_cast<uint8_t>(std::min<size_t>(m_messages, std::numeric_limits<uint8_t>::max()));
+        }
+
+        void SerialPort::update()
+        {
+            uint8_t bytes[256];
+            ssize_t count;
+            while ((count = ::read(m_fd, bytes, sizeof(bytes))) > 0)
+            {
+                for (ssize_t i = 0; i < count; ++i)
+                {
+                    m_received.push_back(bytes[i]);
+                    if (m_arrive_splitter.push(bytes[i]))
+                    {
+                        ++m_messages;
+                    }
+                }
+            }
+
+            if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                throw systemError("Unable to read from the serial port");
+            }
+        }
+
+        void SerialPort::zero()
+        {
+            m_received.clear();
+            m_messages = 0;
+            m_arrive_splitter.reset();
+            m_read_splitter.reset();
+        }
+
+        int SerialPort::fileDescriptor() const
+        {
+            return m_fd;
+        }
+    }  // namespace loadgen
+}  // namespace emb
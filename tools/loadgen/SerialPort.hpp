@@ -0,0 +1,66 @@
+#ifndef EMBMESSENGER_LOADGEN_SERIALPORT_HPP
+#define EMBMESSENGER_LOADGEN_SERIALPORT_HPP
+
+#include "EmbMessenger/Capture.hpp"
+#include "EmbMessenger/IBuffer.hpp"
+#include "EmbMessenger/IPollable.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace emb
+{
+    namespace loadgen
+    {
+        /**
+         * @brief Buffer for a serial port or a pseudo terminal.
+         *
+         * Messages are written with one system call each, the end of a message is found like FrameSplitter does.
+         * The write side and the read side can be used from different threads.
+         */
+        class SerialPort : public shared::IBuffer, public host::IPollable
+        {
+            int m_fd;
+
+            std::vector<uint8_t> m_write_buffer;
+            host::FrameSplitter m_write_splitter;
+
+            std::deque<uint8_t> m_received;
+            size_t m_messages;
+            host::FrameSplitter m_arrive_splitter;
+            host::FrameSplitter m_read_splitter;
+
+            void flush();
+
+        public:
+            /**
+             * @brief Opens a serial port in raw mode.
+             *
+             * @param path Path of the serial port or pseudo terminal
+             * @param baud Baud rate, `0` to keep the port's rate
+             * @throws std::runtime_error If the port can't be opened or the baud rate isn't supported
+             */
+            SerialPort(const std::string& path, uint32_t baud);
+            ~SerialPort();
+
+            SerialPort(const SerialPort&) = delete;
+            SerialPort& operator=(const SerialPort&) = delete;
+
+            virtual void writeByte(const uint8_t byte) override;
+            virtual uint8_t peek() const override;
+            virtual uint8_t readByte() override;
+            virtual bool empty() const override;
+            virtual size_t size() const override;
+            virtual uint8_t messages() const override;
+            virtual void update() override;
+            virtual void zero() override;
+
+            virtual int fileDescriptor() const override;
+        };
+    }  // namespace loadgen
+}  // namespace emb
+
+#endif  // EMBMESSENGER_LOADGEN_SERIALPORT_HPP
@@ -0,0 +1,50 @@
+#include "ExampleDevice.hpp"
+
+#include "EmbMessenger/SimulatedDevice.hpp"
+
+#include <vector>
+
+namespace emb
+{
+    namespace loadgen
+    {
+        namespace
+        {
+            using Device = sim::SimulatedDevice<1>;
+
+            // The same command table as the example device, with the LED kept in memory
+            class ExampleDevice : public Device
+            {
+                bool m_led_state = false;
+
+            public:
+                ExampleDevice(shared::IBuffer* buffer, TimeFunction time) :
+                    Device(buffer, time,
+                           { [](Device::Messenger& messenger) { messenger.checkCrc(); },
+                             [this](Device::Messenger& messenger) { messenger.read(m_led_state); },
+                             [this](Device::Messenger& messenger) {
+                                 m_led_state = !m_led_state;
+                                 messenger.write(m_led_state);
+                             },
+                             [](Device::Messenger& messenger) {
+                                 int16_t a = 0;
+                                 int16_t b = 0;
+                                 messenger.read(a, [](int16_t value) { return value > -16 && value < 128; });
+                                 messenger.read(b, [](int16_t value) { return value > -16 && value < 128; });
+                                 messenger.write(static_cast<int16_t>(a + b));
+                             },
+                             [](Device::Messenger& messenger) {
+                                 uint16_t ms = 0;
+                                 messenger.read(ms);
+                             } })
+                {
+                }
+            };
+        }  // namespace
+
+        std::unique_ptr<sim::IDevice> makeExampleDevice(shared::IBuffer* buffer, sim::IDevice::TimeFunction time)
+        {
+            return std::unique_ptr<sim::IDevice>(new ExampleDevice(buffer, time));
+        }
+    }  // namespace loadgen
+}  // namespace emb
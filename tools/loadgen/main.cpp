@@ -0,0 +1,786 @@
+// Sends a mix of commands to a device at a target rate or concurrency and reports the throughput, latency
+// percentiles and errors.
+//
+// Usage: emb-loadgen [options] <serial port | pty | sim>
+
+#include "EmbMessenger/EmbMessenger.hpp"
+#include "EmbMessenger/Metrics.hpp"
+#include "EmbMessenger/Simulator.hpp"
+
+#include "ExampleDevice.hpp"
+#include "SerialPort.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using clock_t = std::chrono::steady_clock;
+    using emb::host::EmbMessenger;
+
+    enum class Kind : size_t
+    {
+        Ping,
+        SetLed,
+        ToggleLed,
+        Add,
+        Count
+    };
+
+    const char* const kKindNames[] = { "ping", "setled", "toggle", "add" };
+
+    // The command IDs of the example device, examples/device/device.ino
+    const uint16_t kDefaultIds[] = { 0, 1, 2, 3 };
+
+    class LoadCommand : public emb::host::Command
+    {
+    public:
+        Kind kind;
+        clock_t::time_point intended;
+        clock_t::time_point received;
+        bool wrong = false;
+
+        explicit LoadCommand(Kind kind) : kind(kind)
+        {
+        }
+    };
+
+    class Ping : public LoadCommand
+    {
+    public:
+        Ping() : LoadCommand(Kind::Ping)
+        {
+        }
+
+        void receive(EmbMessenger*) override
+        {
+            received = clock_t::now();
+        }
+    };
+
+    class SetLed : public LoadCommand
+    {
+        bool m_state;
+
+    public:
+        explicit SetLed(bool state) : LoadCommand(Kind::SetLed), m_state(state)
+        {
+        }
+
+        void send(EmbMessenger* messenger) override
+        {
+            messenger->write(m_state);
+        }
+
+        void receive(EmbMessenger*) override
+        {
+            received = clock_t::now();
+        }
+    };
+
+    class ToggleLed : public LoadCommand
+    {
+    public:
+        ToggleLed() : LoadCommand(Kind::ToggleLed)
+        {
+        }
+
+        void receive(EmbMessenger* messenger) override
+        {
+            bool state = false;
+            messenger->read(state);
+            received = clock_t::now();
+        }
+    };
+
+    class Add : public LoadCommand
+    {
+        int16_t m_a;
+        int16_t m_b;
+
+    public:
+        Add(int16_t a, int16_t b) : LoadCommand(Kind::Add), m_a(a), m_b(b)
+        {
+        }
+
+        void send(EmbMessenger* messenger) override
+        {
+            messenger->write(m_a, m_b);
+        }
+
+        void receive(EmbMessenger* messenger) override
+        {
+            int16_t sum = 0;
+            messenger->read(sum);
+            received = clock_t::now();
+            wrong = sum != m_a + m_b;
+        }
+    };
+
+    struct Options
+    {
+        std::string target;
+        uint32_t baud = 115200;
+        double weights[static_cast<size_t>(Kind::Count)] = { 1, 0, 0, 0 };
+        uint16_t ids[static_cast<size_t>(Kind::Count)] = { kDefaultIds[0], kDefaultIds[1], kDefaultIds[2],
+                                                           kDefaultIds[3] };
+        size_t concurrency = 1;
+        double rate = 0;
+        size_t max_in_flight = 128;
+        std::chrono::duration<double> duration{ 10 };
+        std::chrono::duration<double> warmup{ 1 };
+        std::chrono::milliseconds timeout{ 1000 };
+        long window = 0;
+        uint32_t seed = 1;
+
+        emb::sim::DeviceOptions device;
+    };
+
+    struct KindStats
+    {
+        emb::host::LatencyHistogram latency;
+        uint64_t sent = 0;
+        uint64_t completed = 0;
+        uint64_t errors = 0;
+    };
+
+    struct Results
+    {
+        KindStats kinds[static_cast<size_t>(Kind::Count)];
+        emb::host::LatencyHistogram latency;
+        std::map<std::string, uint64_t> errors;
+        uint64_t sent = 0;
+        uint64_t completed = 0;
+        uint64_t unanswered = 0;
+    };
+
+    void printUsage(const char* name)
+    {
+        std::cerr
+            << "Usage: " << name << " [options] <serial port | pty | sim>\n"
+            << "Sends commands to a device and reports the throughput, latency percentiles and errors.\n"
+            << "The target sim is a simulated example device running in this process.\n\n"
+            << "  --baud N              Baud rate of the serial port, 0 keeps the port's rate (default 115200)\n"
+            << "  --mix NAME=W,...      Weights of the commands ping, setled, toggle and add (default ping=1)\n"
+            << "  --id NAME=ID          Command ID of a command, defaults to the example device's\n"
+            << "  --concurrency N       Closed loop, keeps N commands in flight (default 1)\n"
+            << "  --rate R              Open loop, sends R commands per second on a fixed schedule\n"
+            << "  --max-in-flight N     Limit of commands in flight in the open loop (default 128)\n"
+            << "  --duration S          Seconds to measure for (default 10)\n"
+            << "  --warmup S            Seconds to run before measuring (default 1)\n"
+            << "  --timeout MS          Time to wait for a response (default 1000)\n"
+            << "  --window BYTES        Flow control window, 0 for none, -1 to ask the device (default 0)\n"
+            << "  --seed N              Seed for the command mix and the simulated link (default 1)\n"
+            << "  --sim-baud N          Baud rate of the simulated link, 0 for unlimited (default 115200)\n"
+            << "  --sim-latency-us N    Latency of the simulated link each way (default 0)\n"
+            << "  --sim-jitter-us N     Jitter of the simulated link each way (default 0)\n"
+            << "  --sim-drop-rate P     Probability of the simulated link losing a byte (default 0)\n"
+            << "  --sim-bit-error-rate P  Probability of the simulated link flipping a bit (default 0)\n"
+            << "  --sim-period-us N     Time between the simulated device's updates (default 100)\n";
+    }
+
+    size_t kindIndex(const std::string& name)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(Kind::Count); ++i)
+        {
+            if (name == kKindNames[i])
+            {
+                return i;
+            }
+        }
+        throw std::invalid_argument("Unknown command " + name);
+    }
+
+    // Splits NAME=VALUE
+    std::pair<std::string, std::string> splitAssignment(const std::string& text)
+    {
+        size_t equals = text.find('=');
+        if (equals == std::string::npos)
+        {
+            throw std::invalid_argument("Expected NAME=VALUE, got " + text);
+        }
+        return { text.substr(0, equals), text.substr(equals + 1) };
+    }
+
+    double parseNumber(const std::string& text)
+    {
+        char* end = nullptr;
+        double value = std::strtod(text.c_str(), &end);
+        if (text.empty() || *end != '\0')
+        {
+            throw std::invalid_argument("Expected a number, got " + text);
+        }
+        return value;
+    }
+
+    std::chrono::microseconds parseMicroseconds(const std::string& text)
+    {
+        return std::chrono::microseconds(static_cast<long>(parseNumber(text)));
+    }
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options options;
+        options.device.host_to_device.bytes_per_second = 11520;
+        options.device.device_to_host.bytes_per_second = 11520;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string option = argv[i];
+            if (option.compare(0, 2, "--") != 0)
+            {
+                if (!options.target.empty())
+                {
+                    throw std::invalid_argument("Only one target can be given");
+                }
+                options.target = option;
+                continue;
+            }
+
+            if (i + 1 == argc)
+            {
+                throw std::invalid_argument("Missing the value of " + option);
+            }
+            std::string value = argv[++i];
+
+            if (option == "--baud")
+            {
+                options.baud = static_cast<uint32_t>(parseNumber(value));
+            }
+            else if (option == "--mix")
+            {
+                std::fill(std::begin(options.weights), std::end(options.weights), 0.0);
+                size_t start = 0;
+                while (start <= value.size())
+                {
+                    size_t comma = value.find(',', start);
+                    std::pair<std::string, std::string> weight =
+                        splitAssignment(value.substr(start, comma == std::string::npos ? comma : comma - start));
+                    options.weights[kindIndex(weight.first)] = parseNumber(weight.second);
+                    start = comma == std::string::npos ? value.size() + 1 : comma + 1;
+                }
+            }
+            else if (option == "--id")
+            {
+                std::pair<std::string, std::string> id = splitAssignment(value);
+                options.ids[kindIndex(id.first)] = static_cast<uint16_t>(parseNumber(id.second));
+            }
+            else if (option == "--concurrency")
+            {
+                options.concurrency = static_cast<size_t>(parseNumber(value));
+            }
+            else if (option == "--rate")
+            {
+                options.rate = parseNumber(value);
+            }
+            else if (option == "--max-in-flight")
+            {
+                options.max_in_flight = static_cast<size_t>(parseNumber(value));
+            }
+            else if (option == "--duration")
+            {
+                options.duration = std::chrono::duration<double>(parseNumber(value));
+            }
+            else if (option == "--warmup")
+            {
+                options.warmup = std::chrono::duration<double>(parseNumber(value));
+            }
+            else if (option == "--timeout")
+            {
+                options.timeout = std::chrono::milliseconds(static_cast<long>(parseNumber(value)));
+            }
+            else if (option == "--window")
+            {
+                options.window = static_cast<long>(parseNumber(value));
+            }
+            else if (option == "--seed")
+            {
+                options.seed = static_cast<uint32_t>(parseNumber(value));
+            }
+            else if (option == "--sim-baud")
+            {
+                options.device.host_to_device.bytes_per_second = static_cast<uint32_t>(parseNumber(value) / 10);
+            }
+            else if (option == "--sim-latency-us")
+            {
+                options.device.host_to_device.latency = parseMicroseconds(value);
+            }
+            else if (option == "--sim-jitter-us")
+            {
+                options.device.host_to_device.jitter = parseMicroseconds(value);
+            }
+            else if (option == "--sim-drop-rate")
+            {
+                options.device.host_to_device.drop_rate = parseNumber(value);
+            }
+            else if (option == "--sim-bit-error-rate")
+            {
+                options.device.host_to_device.bit_error_rate = parseNumber(value);
+            }
+            else if (option == "--sim-period-us")
+            {
+                options.device.update_period = parseMicroseconds(value);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option " + option);
+            }
+        }
+
+        if (options.target.empty())
+        {
+            throw std::invalid_argument("No target given");
+        }
+        if (options.concurrency == 0 || options.max_in_flight == 0)
+        {
+            throw std::invalid_argument("The concurrency and the commands in flight must be at least 1");
+        }
+
+        double total = 0;
+        for (double weight : options.weights)
+        {
+            if (weight < 0)
+            {
+                throw std::invalid_argument("Command weights can't be negative");
+            }
+            total += weight;
+        }
+        if (total <= 0)
+        {
+            throw std::invalid_argument("The command mix is empty");
+        }
+
+        // The link behaves the same both ways, with its own seed for the way back
+        options.device.host_to_device.seed = options.seed;
+        options.device.device_to_host = options.device.host_to_device;
+        options.device.device_to_host.seed = options.seed + 1;
+        return options;
+    }
+
+    // The name of an exception, like the metrics of the EmbMessenger
+    std::string errorName(std::exception_ptr error)
+    {
+        try
+        {
+            std::rethrow_exception(error);
+        }
+        catch (const std::exception& e)
+        {
+            std::string what = e.what();
+            size_t colon = what.find(':');
+            return colon == std::string::npos ? what : what.substr(0, colon);
+        }
+        catch (...)
+        {
+            return "unknown";
+        }
+    }
+
+    // Runs the simulated device in real time, in its own thread in the Multi Threaded EmbMessenger
+    class SimulatedTarget
+    {
+        emb::sim::Simulator m_simulator;
+        clock_t::time_point m_start;
+#ifndef EMB_SINGLE_THREADED
+        std::atomic_bool m_running;
+        std::thread m_thread;
+#endif
+
+    public:
+        explicit SimulatedTarget(const emb::sim::DeviceOptions& options) :
+            m_simulator(1, std::chrono::microseconds(1)),
+            m_start(clock_t::now())
+        {
+            m_simulator.addDevice(emb::loadgen::makeExampleDevice, options);
+#ifdef EMB_SINGLE_THREADED
+            // The constructor of the host waits for the device in update
+            m_simulator.setAdvanceOnIdle(true);
+#else
+            m_running = true;
+            m_thread = std::thread([this] {
+                while (m_running)
+                {
+                    update();
+                    std::this_thread::sleep_for(std::chrono::microseconds(20));
+                }
+            });
+#endif
+        }
+
+        ~SimulatedTarget()
+        {
+#ifndef EMB_SINGLE_THREADED
+            m_running = false;
+            m_thread.join();
+#endif
+        }
+
+        std::shared_ptr<emb::shared::IBuffer> buffer() const
+        {
+            return m_simulator.host(0);
+        }
+
+        // From here on the simulation follows the wall clock
+        void start()
+        {
+#ifdef EMB_SINGLE_THREADED
+            m_simulator.setAdvanceOnIdle(false);
+            m_start = clock_t::now() - std::chrono::duration_cast<clock_t::duration>(m_simulator.now());
+#endif
+        }
+
+        // Catches the simulation up with the wall clock
+        void update()
+        {
+            m_simulator.runUntil(clock_t::now() - m_start);
+        }
+
+        const emb::host::LinkEmulator& link() const
+        {
+            return m_simulator.link(0);
+        }
+    };
+
+    class LoadGenerator
+    {
+        const Options& m_options;
+        EmbMessenger& m_messenger;
+        SimulatedTarget* m_target;
+        Results& m_results;
+
+        std::mt19937 m_random;
+        std::discrete_distribution<size_t> m_mix;
+        size_t m_in_flight;
+
+        clock_t::time_point m_measure_start;
+
+        // False if the command couldn't be sent
+        bool sendOne(clock_t::time_point intended)
+        {
+            std::shared_ptr<LoadCommand> command;
+            Kind kind = static_cast<Kind>(m_mix(m_random));
+            switch (kind)
+            {
+                case Kind::Ping:
+                    command = std::make_shared<Ping>();
+                    break;
+                case Kind::SetLed:
+                    command = std::make_shared<SetLed>(m_random() & 1);
+                    break;
+                case Kind::ToggleLed:
+                    command = std::make_shared<ToggleLed>();
+                    break;
+                default:
+                    command = std::make_shared<Add>(static_cast<int16_t>(m_random() % 100),
+                                                    static_cast<int16_t>(m_random() % 100));
+                    break;
+            }
+            command->intended = intended;
+
+            bool measured = intended >= m_measure_start;
+            if (measured)
+            {
+                ++m_results.sent;
+                ++m_results.kinds[static_cast<size_t>(kind)].sent;
+            }
+
+            try
+            {
+                m_messenger.send(command, m_options.ids[static_cast<size_t>(kind)]);
+                ++m_in_flight;
+                return true;
+            }
+            catch (...)
+            {
+                if (measured)
+                {
+                    ++m_results.errors[errorName(std::current_exception())];
+                    ++m_results.kinds[static_cast<size_t>(kind)].errors;
+                }
+                return false;
+            }
+        }
+
+        size_t pollCompletions()
+        {
+            emb::host::Completion completions[64];
+            size_t count = m_messenger.pollCompletions(completions);
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::shared_ptr<LoadCommand> command = std::dynamic_pointer_cast<LoadCommand>(completions[i].command);
+                if (command == nullptr)
+                {
+                    continue;
+                }
+
+                --m_in_flight;
+                if (command->intended < m_measure_start)
+                {
+                    continue;
+                }
+
+                KindStats& stats = m_results.kinds[static_cast<size_t>(command->kind)];
+                if (completions[i].exception != nullptr)
+                {
+                    ++m_results.errors[errorName(completions[i].exception)];
+                    ++stats.errors;
+                }
+                else if (command->wrong)
+                {
+                    ++m_results.errors["WrongResult"];
+                    ++stats.errors;
+                }
+                else
+                {
+                    std::chrono::microseconds latency =
+                        std::chrono::duration_cast<std::chrono::microseconds>(command->received - command->intended);
+                    m_results.latency.record(latency);
+                    stats.latency.record(latency);
+                    ++m_results.completed;
+                    ++stats.completed;
+                }
+            }
+            return count;
+        }
+
+    public:
+        LoadGenerator(const Options& options, EmbMessenger& messenger, SimulatedTarget* target, Results& results) :
+            m_options(options),
+            m_messenger(messenger),
+            m_target(target),
+            m_results(results),
+            m_random(options.seed),
+            m_mix(std::begin(options.weights), std::end(options.weights)),
+            m_in_flight(0)
+        {
+        }
+
+        std::chrono::duration<double> run()
+        {
+            clock_t::time_point start = clock_t::now();
+            m_measure_start = start + std::chrono::duration_cast<clock_t::duration>(m_options.warmup);
+            clock_t::time_point end =
+                m_measure_start + std::chrono::duration_cast<clock_t::duration>(m_options.duration);
+            clock_t::time_point drained = end + m_options.timeout + std::chrono::milliseconds(100);
+
+            clock_t::duration interval{ 0 };
+            if (m_options.rate > 0)
+            {
+                interval =
+                    std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double>(1 / m_options.rate));
+            }
+            clock_t::time_point next_send = start;
+
+            while (true)
+            {
+                clock_t::time_point now = clock_t::now();
+#ifdef EMB_SINGLE_THREADED
+                if (m_target != nullptr)
+                {
+                    m_target->update();
+                }
+
+                // The failed commands are also completed, they are counted when polled
+                try
+                {
+                    m_messenger.updateAll();
+                }
+                catch (const emb::host::BaseException&)
+                {
+                }
+#else
+                (void)m_target;
+#endif
+                size_t polled = pollCompletions();
+
+                if (now >= end && (m_in_flight == 0 || now >= drained))
+                {
+                    break;
+                }
+
+                size_t sent = 0;
+                if (now < end)
+                {
+                    if (m_options.rate > 0)
+                    {
+                        // Late commands are measured from when they should have been sent
+                        while (next_send <= now && m_in_flight < m_options.max_in_flight)
+                        {
+                            sendOne(next_send);
+                            next_send += interval;
+                            ++sent;
+                        }
+                    }
+                    else
+                    {
+                        while (m_in_flight < m_options.concurrency && sendOne(now))
+                        {
+                            ++sent;
+                        }
+                    }
+                }
+
+#ifndef EMB_SINGLE_THREADED
+                if (polled == 0 && sent == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                }
+#else
+                (void)polled;
+                (void)sent;
+#endif
+            }
+
+            m_results.unanswered = m_in_flight;
+            return std::chrono::duration<double>(std::min(clock_t::now(), end) - m_measure_start);
+        }
+    };
+
+    void printLatency(const char* name, const emb::host::HistogramSnapshot& latency, uint64_t sent, uint64_t errors)
+    {
+        std::printf("%-8s %10llu %10llu %8llu %8llu %8llu %8llu %8llu %8llu\n", name,
+                    static_cast<unsigned long long>(sent), static_cast<unsigned long long>(errors),
+                    static_cast<unsigned long long>(latency.percentile(50).count()),
+                    static_cast<unsigned long long>(latency.percentile(90).count()),
+                    static_cast<unsigned long long>(latency.percentile(99).count()),
+                    static_cast<unsigned long long>(latency.percentile(99.9).count()),
+                    static_cast<unsigned long long>(latency.max.count()),
+                    static_cast<unsigned long long>(latency.mean().count()));
+    }
+
+    void printResults(const Options& options, const Results& results, std::chrono::duration<double> elapsed,
+                      const emb::host::MetricsSnapshot& metrics, const SimulatedTarget* target)
+    {
+        double seconds = elapsed.count() > 0 ? elapsed.count() : 1;
+
+        std::printf("Target      %s\n", options.target.c_str());
+        if (options.rate > 0)
+        {
+            std::printf("Load        open loop, %.1f commands/s, at most %zu in flight\n", options.rate,
+                        options.max_in_flight);
+        }
+        else
+        {
+            std::printf("Load        closed loop, %zu in flight\n", options.concurrency);
+        }
+        std::printf("Measured    %.2f s after %.2f s of warmup\n", elapsed.count(), options.warmup.count());
+        double uptime = std::chrono::duration<double>(metrics.uptime).count();
+        std::printf("Throughput  %.1f commands/s, %.1f B/s out and %.1f B/s in since connecting\n",
+                    results.completed / seconds, metrics.tx_bytes / uptime, metrics.rx_bytes / uptime);
+
+        uint64_t errors = 0;
+        for (const auto& error : results.errors)
+        {
+            errors += error.second;
+        }
+        std::printf("Errors      %llu, %llu unanswered at the end, %llu CRC failures on the host, %llu on the device\n",
+                    static_cast<unsigned long long>(errors), static_cast<unsigned long long>(results.unanswered),
+                    static_cast<unsigned long long>(metrics.crc_failures),
+                    static_cast<unsigned long long>(metrics.device_crc_failures));
+        for (const auto& error : results.errors)
+        {
+            std::printf("  %-24s %llu\n", error.first.c_str(), static_cast<unsigned long long>(error.second));
+        }
+
+        if (target != nullptr)
+        {
+            emb::host::LinkEmulator::Counters out = target->link().hostToDevice();
+            emb::host::LinkEmulator::Counters in = target->link().deviceToHost();
+            std::printf("Link        %llu/%llu bytes dropped/corrupted out, %llu/%llu in\n",
+                        static_cast<unsigned long long>(out.dropped), static_cast<unsigned long long>(out.corrupted),
+                        static_cast<unsigned long long>(in.dropped), static_cast<unsigned long long>(in.corrupted));
+        }
+
+        std::printf("\n%-8s %10s %10s %8s %8s %8s %8s %8s %8s\n", "Latency", "sent", "errors", "p50 us", "p90 us",
+                    "p99 us", "p99.9 us", "max us", "mean us");
+        for (size_t i = 0; i < static_cast<size_t>(Kind::Count); ++i)
+        {
+            if (results.kinds[i].sent > 0)
+            {
+                printLatency(kKindNames[i], results.kinds[i].latency.snapshot(), results.kinds[i].sent,
+                             results.kinds[i].errors);
+            }
+        }
+        printLatency("all", results.latency.snapshot(), results.sent, errors);
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc == 2 && (std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0))
+    {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    Options options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        std::unique_ptr<SimulatedTarget> target;
+        std::shared_ptr<emb::shared::IBuffer> buffer;
+        if (options.target == "sim")
+        {
+            target.reset(new SimulatedTarget(options.device));
+            buffer = target->buffer();
+        }
+        else
+        {
+            buffer = std::make_shared<emb::loadgen::SerialPort>(options.target, options.baud);
+        }
+
+#ifdef EMB_SINGLE_THREADED
+        EmbMessenger messenger(buffer);
+#else
+        EmbMessenger messenger(buffer, [](std::exception_ptr) { return false; });
+#endif
+        messenger.setDefaultTimeout(options.timeout);
+        messenger.enableCompletionQueue(1024);
+        if (options.window > 0)
+        {
+            messenger.setFlowControlWindow(static_cast<size_t>(options.window));
+        }
+        else if (options.window < 0)
+        {
+            messenger.negotiateFlowControl();
+        }
+
+        if (target != nullptr)
+        {
+            target->start();
+        }
+
+        Results results;
+        LoadGenerator generator(options, messenger, target.get(), results);
+        std::chrono::duration<double> elapsed = generator.run();
+        printResults(options, results, elapsed, messenger.snapshot(), target.get());
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}